@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/benchmarks/src/log_benchmark.cc
+
+// clang-format off
+
+#include <benchmark/benchmark.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "statusbarlog/sink.h"
+#include "statusbarlog/statusbarlog.h"
+
+// clang-format on
+
+namespace {
+
+const std::string kFilename = "log_benchmark.cc";
+
+#ifdef _WIN32
+const std::string kNullDevice = "NUL";
+#else
+const std::string kNullDevice = "/dev/null";
+#endif
+
+/**
+ * \brief Sink writing to the null device, so the benchmarks measure
+ * formatting and the sink bookkeeping rather than the disk.
+ */
+class NullSink {
+ public:
+  NullSink() { statusbar_log::sink::CreateSinkFile(this->handle, kNullDevice); }
+  ~NullSink() { statusbar_log::sink::DestroySinkHandle(this->handle); }
+
+  statusbar_log::sink::SinkHandle handle{};
+};
+
+void BM_LogPrintf(benchmark::State& state) {
+  NullSink sink;
+  const char* name = "worker";
+  int i = 0;
+  for (auto _ : state) {
+    statusbar_log::LogErr(kFilename, sink.handle,
+                          "%s %d finished with %.2f%% (%zu bytes)", name, i,
+                          i * 0.5, static_cast<std::size_t>(i) * 4096);
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogPrintf);
+
+void BM_LogFilteredAtRuntime(benchmark::State& state) {
+  NullSink sink;
+  statusbar_log::SetLogLevel(statusbar_log::kLogLevelOff);
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(statusbar_log::LogErr(
+        kFilename, sink.handle, "%s %d finished", "worker", i++));
+  }
+  statusbar_log::ResetLogLevels();
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogFilteredAtRuntime);
+
+/**
+ * \brief Logging below a statusbar with 8 bars, with the redraw interval (ms)
+ * given as argument.
+ */
+void BM_LogWithStatusbars(benchmark::State& state) {
+  NullSink sink;
+  statusbar_log::StatusbarHandle statusbar{};
+  statusbar_log::CreateStatusbarHandle(
+      statusbar, sink.handle, {8, 7, 6, 5, 4, 3, 2, 1},
+      std::vector<unsigned int>(8, 40), std::vector<std::string>(8, "bar "),
+      std::vector<std::string>(8, ""));
+  statusbar_log::SetStatusbarRedrawInterval(
+      static_cast<unsigned int>(state.range(0)));
+  int i = 0;
+  for (auto _ : state) {
+    statusbar_log::LogErr(kFilename, sink.handle, "%s %d finished", "worker",
+                          i++);
+  }
+  statusbar_log::SetStatusbarRedrawInterval(0);
+  statusbar_log::DestroyStatusbarHandle(statusbar);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogWithStatusbars)->ArgName("interval_ms")->Arg(0)->Arg(16);
+
+#ifndef _WIN32
+/**
+ * \brief Logging below 8 bars through a stdout sink (fd-backed, cursor moves
+ * are written as escape sequences) with stdout sent to the null device, so
+ * the line and the redrawn bars are composed into one frame.
+ */
+void BM_LogWithStatusbarsToFd(benchmark::State& state) {
+  std::fflush(stdout);
+  const int saved_stdout = dup(STDOUT_FILENO);
+  const int null_fd = open(kNullDevice.c_str(), O_WRONLY);
+  dup2(null_fd, STDOUT_FILENO);
+  close(null_fd);
+
+  statusbar_log::sink::SinkHandle sink_handle{};
+  statusbar_log::sink::CreateSinkStdout(sink_handle);
+  statusbar_log::StatusbarHandle statusbar{};
+  statusbar_log::CreateStatusbarHandle(
+      statusbar, sink_handle, {8, 7, 6, 5, 4, 3, 2, 1},
+      std::vector<unsigned int>(8, 40), std::vector<std::string>(8, "bar "),
+      std::vector<std::string>(8, ""));
+  int i = 0;
+  for (auto _ : state) {
+    statusbar_log::LogErr(kFilename, sink_handle, "%s %d finished", "worker",
+                          i++);
+  }
+  statusbar_log::DestroyStatusbarHandle(statusbar);
+  statusbar_log::sink::DestroySinkHandle(sink_handle);
+
+  dup2(saved_stdout, STDOUT_FILENO);
+  close(saved_stdout);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogWithStatusbarsToFd);
+#endif
+
+/**
+ * \brief Updating a statusbar with 4 bars, drawn by every call (rate 0) or by
+ * the render thread at the rate (Hz) given as argument.
+ */
+void BM_UpdateStatusbar(benchmark::State& state) {
+  NullSink sink;
+  statusbar_log::StatusbarHandle statusbar{};
+  statusbar_log::CreateStatusbarHandle(
+      statusbar, sink.handle, {4, 3, 2, 1}, std::vector<unsigned int>(4, 40),
+      std::vector<std::string>(4, "bar "), std::vector<std::string>(4, ""));
+  statusbar_log::SetStatusbarRenderRate(
+      static_cast<unsigned int>(state.range(0)));
+  std::size_t i = 0;
+  for (auto _ : state) {
+    statusbar_log::UpdateStatusbar(statusbar, i % 4, (i / 4) % 101);
+    ++i;
+  }
+  statusbar_log::SetStatusbarRenderRate(0);
+  statusbar_log::DestroyStatusbarHandle(statusbar);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UpdateStatusbar)->ArgName("rate_hz")->Arg(0)->Arg(60);
+
+NullSink* _progress_sink = nullptr;
+statusbar_log::StatusbarHandle _progress_statusbar{};
+
+/**
+ * \brief Creates the statusbar shared by all threads of BM_StatusbarProgress,
+ * drawn by a 60 Hz render thread.
+ */
+void _CreateProgressStatusbar(const benchmark::State&) {
+  _progress_sink = new NullSink();
+  statusbar_log::CreateStatusbarHandle(
+      _progress_statusbar, _progress_sink->handle, {2, 1}, {40, 40},
+      {"percent ", "counted "}, {"", ""}, {0, std::uint64_t{1} << 40});
+  statusbar_log::SetStatusbarRenderRate(60);
+}
+
+void _DestroyProgressStatusbar(const benchmark::State&) {
+  statusbar_log::SetStatusbarRenderRate(0);
+  statusbar_log::DestroyStatusbarHandle(_progress_statusbar);
+  delete _progress_sink;
+  _progress_sink = nullptr;
+}
+
+/**
+ * \brief All threads advance the same bar, with UpdateStatusbar storing a
+ * percentage (state.range(0) == 0) or with AddStatusbarProgress adding to
+ * the sharded counters (1).
+ */
+void BM_StatusbarProgress(benchmark::State& state) {
+  std::size_t i = 0;
+  if (state.range(0) == 0) {
+    for (auto _ : state) {
+      statusbar_log::UpdateStatusbar(_progress_statusbar, 0, ++i % 101);
+    }
+  } else {
+    for (auto _ : state) {
+      statusbar_log::AddStatusbarProgress(_progress_statusbar, 1, 1);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StatusbarProgress)
+    ->ArgName("counted")
+    ->Arg(0)
+    ->Arg(1)
+    ->Setup(_CreateProgressStatusbar)
+    ->Teardown(_DestroyProgressStatusbar)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+/**
+ * \brief Logging to a file flushed after every line (state.range(0) == 0, the
+ * default policy) or in 64 KiB blocks, errors and every 100 ms (1).
+ */
+void BM_LogToFileFlushPolicy(benchmark::State& state) {
+  const std::string path = "log_benchmark_flush.txt";
+  std::filesystem::remove(path);
+  statusbar_log::sink::SinkHandle handle{};
+  statusbar_log::sink::CreateSinkFile(handle, path);
+  if (state.range(0) == 1) {
+    statusbar_log::sink::SetSinkFlushPolicy(
+        handle, {false, false, std::size_t{64} << 10, 100,
+                 statusbar_log::kLogLevelErr});
+  }
+  int i = 0;
+  for (auto _ : state) {
+    statusbar_log::LogInf(kFilename, handle, "%s %d finished", "worker", i++);
+  }
+  statusbar_log::sink::DestroySinkHandle(handle);
+  std::filesystem::remove(path);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogToFileFlushPolicy)->ArgName("blocks")->Arg(0)->Arg(1);
+
+#if defined(__cpp_lib_format)
+void BM_LogFmt(benchmark::State& state) {
+  NullSink sink;
+  const char* name = "worker";
+  int i = 0;
+  for (auto _ : state) {
+    statusbar_log::LogErrFmt(kFilename, sink.handle,
+                             "{} {} finished with {:.2f}% ({} bytes)", name,
+                             i, i * 0.5, static_cast<std::size_t>(i) * 4096);
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogFmt);
+#endif  // defined(__cpp_lib_format)
+
+}  // namespace
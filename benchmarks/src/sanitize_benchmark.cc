@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/benchmarks/src/sanitize_benchmark.cc
+
+// clang-format off
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "sanitize.h"
+
+// clang-format on
+
+namespace {
+
+/**
+ * \brief The byte by byte sanitizer statusbarlog used before the vectorized
+ * scanner, kept as the baseline.
+ */
+std::string LegacySanitizeString(const std::string& input) {
+  std::string output;
+  output.reserve(input.size());
+  for (char c : input) {
+    if (c == '\t' || (c >= 32 && c <= 126)) {
+      output += c;
+    } else if (static_cast<unsigned char>(c) < 32 || c == 127) {
+      output += "\xEF\xBF\xBD";
+    } else {
+      output += c;
+    }
+  }
+  return output;
+}
+
+/**
+ * \brief Printable text of `len` bytes; with `dirty` every 64th byte is a
+ * control character.
+ */
+std::string MakeInput(const std::size_t len, const bool dirty) {
+  std::string input(len, ' ');
+  for (std::size_t i = 0; i < len; ++i) {
+    input[i] = static_cast<char>('a' + i % 26);
+    if (dirty && i % 64 == 63) input[i] = '\x1b';
+  }
+  return input;
+}
+
+void BM_SanitizeStringLegacy(benchmark::State& state) {
+  const std::string input =
+      MakeInput(static_cast<std::size_t>(state.range(0)), state.range(1) != 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LegacySanitizeString(input));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SanitizeStringLegacy)
+    ->ArgNames({"len", "dirty"})
+    ->ArgsProduct({{16, 256, 4096}, {0, 1}});
+
+void BM_SanitizeString(benchmark::State& state) {
+  const std::string input =
+      MakeInput(static_cast<std::size_t>(state.range(0)), state.range(1) != 0);
+  for (auto _ : state) {
+    // Includes copying the argument, matching the copy the legacy version
+    // makes while sanitizing.
+    benchmark::DoNotOptimize(statusbar_log::detail::SanitizeString(input));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  state.SetLabel(statusbar_log::detail::FindReplacedCharImplementation());
+}
+BENCHMARK(BM_SanitizeString)
+    ->ArgNames({"len", "dirty"})
+    ->ArgsProduct({{16, 256, 4096}, {0, 1}});
+
+void BM_FindReplacedCharScalar(benchmark::State& state) {
+  const std::string input =
+      MakeInput(static_cast<std::size_t>(state.range(0)), false);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(statusbar_log::detail::FindReplacedCharScalar(
+        input.data(), input.size(), true));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FindReplacedCharScalar)->Arg(256)->Arg(4096);
+
+void BM_FindReplacedChar(benchmark::State& state) {
+  const std::string input =
+      MakeInput(static_cast<std::size_t>(state.range(0)), false);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(statusbar_log::detail::FindReplacedChar(
+        input.data(), input.size(), true));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  state.SetLabel(statusbar_log::detail::FindReplacedCharImplementation());
+}
+BENCHMARK(BM_FindReplacedChar)->Arg(256)->Arg(4096);
+
+void BM_SanitizeInPlace(benchmark::State& state) {
+  const std::string input =
+      MakeInput(static_cast<std::size_t>(state.range(0)), state.range(1) != 0);
+  std::vector<char> buffer(input.size() * 3);
+  // Includes restoring the input, as sanitizing overwrites it.
+  for (auto _ : state) {
+    input.copy(buffer.data(), input.size());
+    benchmark::DoNotOptimize(statusbar_log::detail::SanitizeInPlace(
+        buffer.data(), input.size(), buffer.size(), true));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SanitizeInPlace)
+    ->ArgNames({"len", "dirty"})
+    ->ArgsProduct({{256, 4096}, {0, 1}});
+
+}  // namespace
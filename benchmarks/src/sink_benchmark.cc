@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/benchmarks/src/sink_benchmark.cc
+
+// clang-format off
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "statusbarlog/sink.h"
+
+// clang-format on
+
+namespace {
+
+#ifdef _WIN32
+const std::string kNullDevice = "NUL";
+#else
+const std::string kNullDevice = "/dev/null";
+#endif
+
+/**
+ * \brief Every thread writes to its own sink, so the throughput per thread
+ * should not drop with the number of threads.
+ */
+void BM_SinkWriteOwnSinkPerThread(benchmark::State& state) {
+  statusbar_log::sink::SinkHandle handle{};
+  statusbar_log::sink::CreateSinkFile(handle, kNullDevice);
+  const std::string line(64, 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        statusbar_log::sink::SinkWrite(handle, line.data(), line.size()));
+  }
+  statusbar_log::sink::DestroySinkHandle(handle);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SinkWriteOwnSinkPerThread)->ThreadRange(1, 8)->UseRealTime();
+
+statusbar_log::sink::SinkHandle _shared_handle{};
+
+/**
+ * \brief Creates the sink shared by all threads of BM_SinkWriteSharedSink: a
+ * kSinkFileOwned sink on the null device (state.range(0) == 0) or a
+ * kSinkFlightRecorder sink (1).
+ */
+void _CreateSharedSink(const benchmark::State& state) {
+  if (state.range(0) == 0) {
+    statusbar_log::sink::CreateSinkFile(_shared_handle, kNullDevice);
+  } else {
+    statusbar_log::sink::CreateSinkFlightRecorder(
+        _shared_handle, kNullDevice,
+        statusbar_log::sink::kSinkFlightRecorderDefaultSize, 0);
+  }
+}
+
+void _DestroySharedSink(const benchmark::State&) {
+  statusbar_log::sink::DestroySinkHandle(_shared_handle);
+}
+
+/**
+ * \brief All threads write 64 byte lines to the same sink. File sinks
+ * serialize the writers on their io mutex, flight recorders only on the
+ * atomic claiming the bytes.
+ */
+void BM_SinkWriteSharedSink(benchmark::State& state) {
+  const std::string line = std::string(63, 'x') + "\n";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(statusbar_log::sink::SinkWrite(
+        _shared_handle, line.data(), line.size()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SinkWriteSharedSink)
+    ->ArgName("kind")
+    ->Arg(0)
+    ->Arg(1)
+    ->Setup(_CreateSharedSink)
+    ->Teardown(_DestroySharedSink)
+    ->ThreadRange(1, 4)
+    ->UseRealTime();
+
+/**
+ * \brief Writing 64 byte lines to a log file through a kSinkFileOwned sink
+ * (state.range(0) == 0), a kSinkMappedFile sink (1) or a kSinkUringFile sink
+ * (2).
+ */
+void BM_FileSinkWriteLines(benchmark::State& state) {
+  const std::string path = "sink_benchmark_lines.txt";
+  std::filesystem::remove(path);
+  statusbar_log::sink::SinkHandle handle{};
+  if (state.range(0) == 0) {
+    statusbar_log::sink::CreateSinkFile(handle, path);
+  } else if (state.range(0) == 1) {
+    statusbar_log::sink::CreateSinkMappedFile(handle, path);
+  } else {
+    statusbar_log::sink::CreateSinkUringFile(handle, path);
+  }
+  const std::string line = std::string(63, 'x') + "\n";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        statusbar_log::sink::SinkWrite(handle, line.data(), line.size()));
+  }
+  statusbar_log::sink::DestroySinkHandle(handle);
+  std::filesystem::remove(path);
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(line.size()));
+}
+BENCHMARK(BM_FileSinkWriteLines)->ArgName("kind")->Arg(0)->Arg(1)->Arg(2);
+
+/**
+ * \brief Redrawing a statusbar line at the end of a file log that is
+ * `state.range(0)` lines long: remove the last line, write it again.
+ */
+void BM_FileSinkRedrawLastLine(benchmark::State& state) {
+  const std::string path = "sink_benchmark_redraw.txt";
+  std::filesystem::remove(path);
+  statusbar_log::sink::SinkHandle handle{};
+  statusbar_log::sink::CreateSinkFile(handle, path);
+  const std::string line(63, 'x');
+  const std::string log = line + "\n";
+  for (int i = 0; i < state.range(0); ++i) {
+    statusbar_log::sink::SinkWriteStr(handle, log);
+  }
+  for (auto _ : state) {
+    statusbar_log::sink::MoveCursorUp(handle, 1);
+    statusbar_log::sink::SinkWriteStr(handle, log);
+  }
+  statusbar_log::sink::DestroySinkHandle(handle);
+  std::filesystem::remove(path);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FileSinkRedrawLastLine)->ArgName("lines")->Arg(1000)->Arg(100000);
+
+}  // namespace
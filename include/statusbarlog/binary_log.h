@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/include/statusbarlog/binary_log.h
+
+#ifndef STATUSBARLOG_BINARY_LOG_H_
+#define STATUSBARLOG_BINARY_LOG_H_
+
+// clang-format off
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "statusbarlog/sink.h"
+#include "statusbarlog/statusbarlog.h"
+
+// clang-format on
+
+/**
+ * \file binary_log.h
+ * \brief Binary (deferred formatting) log format used by
+ * statusbar_log::sink::kSinkBinary sinks.
+ *
+ * Instead of the formatted text a binary sink stores the id of the format
+ * string, the id of the filename and the raw argument bytes of every log call.
+ * The text is produced later by statusbar_log::binary_log::DecodeBinaryLog
+ * (or the `statusbarlog_decode` tool), which prints exactly the lines
+ * statusbar_log::LogV would have printed.
+ *
+ * File layout (all integers in the byte order of the writing machine):
+ *
+ *     header:  "SBLB"  u16 version  u16 byte order mark (0x0102)
+ *     record:  u8 kind  u32 payload length  payload
+ *
+ * Record payloads:
+ * - \c kRecordString: u32 id, the string bytes. Defines (or redefines) an id
+ *   before its first use.
+ * - \c kRecordLog: u8 level, u32 format string id, u32 filename id, the
+ *   argument bytes.
+ *
+ * Argument bytes, one entry per conversion of the format string in order:
+ * - `*` width or precision: i32
+ * - d, i: i64 (already converted to the type given by the length modifier)
+ * - u, o, x, X: u64 (same)
+ * - c: i32
+ * - e, E, f, F, g, G, a, A: f64 (long double arguments are stored as double)
+ * - s: u32 length, the bytes (precision is applied when writing)
+ * - p: u64
+ * - n, %: nothing
+ */
+
+namespace statusbar_log {
+namespace binary_log {
+
+constexpr char kMagic[4] = {'S', 'B', 'L', 'B'};
+constexpr std::uint16_t kFormatVersion = 1;
+constexpr std::uint16_t kByteOrderMark = 0x0102;
+constexpr std::size_t kFileHeaderLength = 8;
+constexpr std::size_t kRecordHeaderLength = 5;
+/// Maximum size of the argument bytes of one log record.
+constexpr std::size_t kMaxArgsLength = kMaxLogLength + 512;
+
+/**
+ * \enum RecordKind
+ * \brief Kinds of records in a binary log file.
+ */
+typedef enum {
+  kRecordString = 1,  ///< Interned string (format string or filename)
+  kRecordLog = 2,     ///< One log call
+} RecordKind;
+
+/**
+ * \brief Decodes a binary log file and writes its messages to a sink.
+ *
+ * Every log record is turned into the line statusbar_log::LogV produces for
+ * the same call ("LEVEL [filename]: message") and written to `sink_handle`.
+ *
+ * \param[in] path Binary log file written by a statusbar_log::sink::kSinkBinary
+ * sink.
+ * \param[in] sink_handle Text sink receiving the decoded lines.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error codes:
+ *         -  statusbar_log::kStatusbarLogSuccess (i.e. 0): Success
+ *         - -1: Failed to open the file
+ *         - -2: Not a binary log file (bad magic, version or byte order)
+ *         - -3: Truncated or corrupt record
+ *         - -4: Record references an undefined string id
+ *         - -5: Writing a decoded line to the sink failed
+ */
+int DecodeBinaryLog(const std::string& path, sink::SinkHandle sink_handle);
+
+namespace detail {
+
+/**
+ * \brief Encodes the arguments of a printf-style call into argument bytes (see
+ * the file documentation).
+ *
+ * \param[in] fmt printf-style format string.
+ * \param[in] args Arguments matching `fmt` (not consumed, a copy is used).
+ * \param[out] out Buffer receiving the argument bytes.
+ * \param[in] capacity Size of `out`.
+ *
+ * \return Number of bytes written, or -1 if the arguments do not fit or `fmt`
+ * contains a conversion that can not be stored (the caller then falls back to
+ * storing the formatted text).
+ */
+long EncodeArgs(const char* fmt, va_list args, char* out,
+                std::size_t capacity);
+
+}  // namespace detail
+
+}  // namespace binary_log
+}  // namespace statusbar_log
+
+#endif  // STATUSBARLOG_BINARY_LOG_H_
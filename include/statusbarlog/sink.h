@@ -17,14 +17,31 @@
 #ifndef STATUSBARLOG_SINK_H_
 #define STATUSBARLOG_SINK_H_
 
+#include <array>
+#include <cstddef>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace statusbar_log {
 namespace sink {
 
 constexpr unsigned int kMaxSinkHandles = 20;
 
+/// Size of the write buffer of fd-backed sinks (stdout, stderr). Output is
+/// gathered until FlushSinkHandle is called or the buffer would overflow.
+constexpr std::size_t kSinkWriteBufferSize = 8192;
+
+/// Mapped file sinks (CreateSinkMappedFile) grow the file by this many bytes
+/// at a time, preallocating and mapping them in one step.
+constexpr std::size_t kSinkMappedFileChunkSize = std::size_t{16} << 20;
+
+/// Maximum number of children of a tee sink (CreateSinkTee).
+constexpr std::size_t kMaxSinkTeeChildren = 8;
+
+/// Suggested ring size of flight recorder sinks (CreateSinkFlightRecorder).
+constexpr std::size_t kSinkFlightRecorderDefaultSize = std::size_t{64} << 20;
+
 /**
  * \enum SinkType
  * \brief All possible sink types.
@@ -33,10 +50,35 @@ typedef enum {
   kSinkInvalid,        ///< Involid sink type
   kSinkStdout,         ///< Sink linked to stdcout (non owning)
   kSinkFileOwned,      ///< Sink linked to a file (owning)
-  kSinkOstreamWrapped  /// Sink wrapped around existing arbitrary ostream (non
-                       /// owning)
+  kSinkOstreamWrapped, ///< Sink wrapped around existing arbitrary ostream (non
+                       ///< owning)
+  kSinkBinary,         ///< Sink linked to a binary log file (owning, see
+                       ///< binary_log.h)
+  kSinkMappedFile,     ///< Sink linked to a memory mapped file (owning)
+  kSinkUringFile,      ///< Sink linked to a file written through io_uring
+                       ///< (owning, Linux only)
+  kSinkTee,            ///< Sink forwarding to other sinks (non owning, see
+                       ///< CreateSinkTee)
+  kSinkFlightRecorder  ///< Sink recording into an in-memory ring, dumped to
+                       ///< a file on demand (see CreateSinkFlightRecorder)
 } SinkType;
 
+/**
+ * \struct SinkCapabilities
+ * \brief Properties of a sink, detected once when the sink is created.
+ *
+ * \see GetSinkCapabilities: Reading the capabilities of a sink.
+ */
+// clang-format off
+typedef struct {
+  SinkType type;          ///< The sinks type
+  int fd;                 ///< File descriptor written to directly (-1 if output goes through an ostream)
+  bool is_tty;            ///< Output goes to a terminal
+  bool supports_escapes;  ///< ANSI escape sequences (cursor movement, line clearing) are interpreted
+  bool buffered;          ///< Output is buffered (by an ostream or the write buffer of an fd sink) and needs flushing
+} SinkCapabilities;
+// clang-format on
+
 /**
  * \struct SinkHandle
  * \brief Handle to a Sink. Used to interact with the underlying sink
@@ -53,6 +95,38 @@ typedef struct {
                     ///< destruction)
 } SinkHandle;
 
+/**
+ * \struct SinkTeeChild
+ * \brief A sink a tee sink forwards to (see CreateSinkTee).
+ */
+typedef struct {
+  SinkHandle sink;    ///< The child sink (not owned by the tee)
+  int max_log_level;  ///< Highest statusbar_log::LogLevel forwarded to the
+                      ///< child
+} SinkTeeChild;
+
+/// Children of a tee sink as returned by GetSinkTeeChildren.
+typedef std::array<SinkTeeChild, kMaxSinkTeeChildren> SinkTeeChildren;
+
+/**
+ * \struct SinkFlushPolicy
+ * \brief When a sink is flushed on its own (see SetSinkFlushPolicy). Every
+ * enabled trigger flushes, FlushSinkHandle always does.
+ *
+ * Sinks start with `every_write` only: flushed at the end of every log line,
+ * statusbar update and cursor or line escape sequence. Terminals usually keep
+ * that, file sinks gather large blocks with `every_bytes` and `every_ms`.
+ */
+// clang-format off
+typedef struct {
+  bool every_write;          ///< Flush at the end of every operation writing to the sink
+  bool on_newline;           ///< Flush at the end of operations that wrote a newline
+  std::size_t every_bytes;   ///< Flush once this many bytes were written since the last flush (0: off)
+  unsigned int every_ms;     ///< Flush pending output every this many milliseconds, from the shared flush timer (0: off)
+  int max_log_level;         ///< Flush after log lines of this statusbar_log::LogLevel or a more severe one (0: off)
+} SinkFlushPolicy;
+// clang-format on
+
 /**
  * \brief Check if the argument is a valid sink handle
  *
@@ -154,6 +228,214 @@ int CreateSinkStdout(SinkHandle& sink_handle);
  */
 int CreateSinkFile(SinkHandle& sink_handle, const std::string path);
 
+/**
+ * \brief Initialises a sink that writes binary log records to the given file
+ * path (append mode)
+ *
+ * Log calls on this sink store the format string id, the filename id and the
+ * raw argument bytes instead of formatted text (see binary_log.h). Use
+ * statusbar_log::binary_log::DecodeBinaryLog or the `statusbarlog_decode`
+ * tool to turn the file into text. Statusbars and raw writes (SinkWrite) are
+ * not supported on binary sinks.
+ *
+ * \param[out] sink_handle Struct to initialize.
+ * \param[in] path Path to the file to be opened/created.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error/warning codes:
+ *         -  statusbar_log::kStatusbarLogSuccess (i.e. 0): Success (no errors)
+ *         - -1: Failed to create sink handle (handle already valid)
+ *         - -2: Failed to create sink handle (handle registry exceeds
+ * maximum element limit)
+ *         - -3: Failed to create sink handle (failed in opening file)
+ *         - -4: Failed to create sink handle (unknown error in opening file)
+ *         - -5: Failed to create sink handle (failed writing the file header)
+ *
+ * \warning Don't forget to destroy the sink_handle after use.
+ *
+ * \see SinkHandle: The sink handle struct
+ * \see Sink: The sink struct.
+ */
+int CreateSinkBinary(SinkHandle& sink_handle, const std::string path);
+
+/**
+ * \brief Initialises a sink that writes to the given file path through a
+ * shared memory mapping (append mode)
+ *
+ * The file is preallocated and mapped in chunks of kSinkMappedFileChunkSize
+ * bytes as output arrives, so writes are copies into the mapping and the
+ * kernel writes the pages back. Output is visible to readers of the file right
+ * away, FlushSinkHandle has nothing to do. Moving the cursor up removes lines
+ * like on kSinkFileOwned sinks.
+ *
+ * While the sink is alive the file is longer than the output, the rest reads
+ * as zero bytes. DestroySinkHandle trims the file to the output.
+ *
+ * \param[out] sink_handle Struct to initialize.
+ * \param[in] path Path to the file to be opened/created.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error/warning codes:
+ *         -  statusbar_log::kStatusbarLogSuccess (i.e. 0): Success (no errors)
+ *         - -1: Failed to create sink handle (handle already valid)
+ *         - -2: Failed to create sink handle (handle registry exceeds
+ * maximum element limit)
+ *         - -3: Failed to create sink handle (failed in opening file)
+ *         - -4: Failed to create sink handle (not supported on this platform)
+ *
+ * \warning Don't forget to destroy the sink_handle after use.
+ *
+ * \see SinkHandle: The sink handle struct
+ * \see Sink: The sink struct.
+ */
+int CreateSinkMappedFile(SinkHandle& sink_handle, const std::string path);
+
+/**
+ * \brief Initialises a sink that appends to the given file path through
+ * io_uring (Linux only)
+ *
+ * Writes are copied into a few 64 KiB buffers and full buffers are submitted
+ * to the kernel without waiting for the disk. Flushes due by the flush policy
+ * (see SinkFlushPolicy) submit the partial buffer the same way, without
+ * waiting. FlushSinkHandle is a fence: it submits the rest and waits until
+ * every write has completed. Moving the cursor up removes lines like on
+ * kSinkFileOwned sinks.
+ *
+ * Writes go to offsets the sink tracks itself, starting at the size of the
+ * file when it is opened. The sink must be the only writer of the file while
+ * it exists, output appended by others is overwritten.
+ *
+ * If io_uring is not available (other platforms, kernels before 5.6 or
+ * blocked by a seccomp filter) a kSinkFileOwned sink is created instead, see
+ * GetSinkCapabilities for the type in use.
+ *
+ * \param[out] sink_handle Struct to initialize.
+ * \param[in] path Path to the file to be opened/created.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error/warning codes:
+ *         -  statusbar_log::kStatusbarLogSuccess (i.e. 0): Success (no errors)
+ *         - -1: Failed to create sink handle (handle already valid)
+ *         - -2: Failed to create sink handle (handle registry exceeds
+ * maximum element limit)
+ *         - -3: Failed to create sink handle (failed in opening file)
+ *         - -4: Failed to create sink handle (unknown error in opening file,
+ * only when falling back to a kSinkFileOwned sink)
+ *
+ * \warning Don't forget to destroy the sink_handle after use.
+ *
+ * \see SinkHandle: The sink handle struct
+ * \see Sink: The sink struct.
+ */
+int CreateSinkUringFile(SinkHandle& sink_handle, const std::string path);
+
+/**
+ * \brief Initialises a sink that forwards to several other sinks.
+ *
+ * Log calls on the tee format the line once and hand it to every child whose
+ * `max_log_level` admits the message. Children that are terminals (see
+ * SinkCapabilities::supports_escapes) get the line like a direct log call,
+ * with the statusbars redrawn below it. All other children get the plain line
+ * and never see escape sequences.
+ *
+ * Raw writes (SinkWrite), cursor movement and statusbars drawn on the tee go
+ * to its terminal children only. FlushSinkHandle flushes all children.
+ *
+ * The tee does not own its children: destroying the tee leaves them alone,
+ * and children destroyed before the tee are skipped.
+ *
+ * \param[out] sink_handle Struct to initialize.
+ * \param[in] children The sinks to forward to (1 to kMaxSinkTeeChildren).
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error/warning codes:
+ *         -  statusbar_log::kStatusbarLogSuccess (i.e. 0): Success (no errors)
+ *         - -1: Failed to create sink handle (handle already valid)
+ *         - -2: Failed to create sink handle (handle registry exceeds
+ * maximum element limit)
+ *         - -3: Failed to create sink handle (no children or more than
+ * kMaxSinkTeeChildren)
+ *         - -4: Failed to create sink handle (a child handle is invalid)
+ *         - -5: Failed to create sink handle (a child is a binary or tee sink)
+ *
+ * \warning Don't forget to destroy the sink_handle after use.
+ *
+ * \see SinkHandle: The sink handle struct
+ * \see SinkTeeChild: A child and its level threshold.
+ */
+int CreateSinkTee(SinkHandle& sink_handle,
+                  const std::vector<SinkTeeChild>& children);
+
+/**
+ * \brief Initialises a flight recorder sink: output goes into a ring buffer in
+ * memory and only reaches `dump_path` when the sink is dumped.
+ *
+ * Writers claim their bytes in the ring with one atomic add and copy them
+ * without taking a lock. Finished copies are committed in claim order, so a
+ * writer only waits for the copies claimed before its own. Once the ring is
+ * full the oldest output is overwritten. Nothing is written to disk while
+ * recording, FlushSinkHandle has nothing to do.
+ *
+ * The recording is appended to `dump_path`:
+ * - on request (DumpSinkFlightRecorder),
+ * - after a log line with a level of at most `dump_log_level` (see
+ *   SinkWriteFlightRecorderLog), e.g. statusbar_log::kLogLevelErr to keep the
+ *   context of every error,
+ * - on a fatal signal (SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT; not on
+ *   Windows). The handlers are installed with the first flight recorder,
+ *   handlers installed before run after the dump. Faults (SIGSEGV, SIGBUS,
+ *   SIGILL, SIGFPE raised by an instruction) reach them with their original
+ *   siginfo_t, as the faulting instruction is restarted.
+ *
+ * Each dump only appends the output recorded since the previous dump. Output
+ * overwritten before it was dumped is lost, the dump then starts at the next
+ * complete line.
+ *
+ * Log lines are recorded without redrawing statusbars, moving the cursor does
+ * nothing.
+ *
+ * \param[out] sink_handle Struct to initialize.
+ * \param[in] dump_path Path of the file dumps are appended to (created on the
+ * first dump).
+ * \param[in] size Size of the ring in bytes, rounded up to a power of two (see
+ * kSinkFlightRecorderDefaultSize).
+ * \param[in] dump_log_level Log lines with this statusbar_log::LogLevel or a
+ * more severe one trigger a dump (0, i.e. statusbar_log::kLogLevelOff: never).
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error/warning codes:
+ *         -  statusbar_log::kStatusbarLogSuccess (i.e. 0): Success (no errors)
+ *         - -1: Failed to create sink handle (handle already valid)
+ *         - -2: Failed to create sink handle (handle registry exceeds
+ * maximum element limit)
+ *         - -3: Failed to create sink handle (size is 0 or cannot be rounded
+ * up to a power of two, or the ring could not be allocated)
+ *
+ * \warning Don't forget to destroy the sink_handle after use. Destroying the
+ * sink discards output that was not dumped.
+ *
+ * \see SinkHandle: The sink handle struct
+ * \see DumpSinkFlightRecorder: Dumping on request.
+ */
+int CreateSinkFlightRecorder(SinkHandle& sink_handle,
+                             const std::string dump_path, std::size_t size,
+                             int dump_log_level);
+
+/**
+ * \brief Appends the output a flight recorder sink recorded since its last
+ * dump to its dump file.
+ *
+ * Copies the committed recording out without waiting for writers. Writers are
+ * not blocked, lines they write meanwhile go into the next dump.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error codes:
+ *         - -1 to -4: Invalid handle (see IsValidSinkHandle)
+ *         - -5: Not a flight recorder sink
+ *         - -6: Writing the dump file failed
+ */
+int DumpSinkFlightRecorder(const SinkHandle& sink_handle);
+
 /**
  * \brief Destorys a Sink using its handle and invalidates it.
  *
@@ -161,6 +443,8 @@ int CreateSinkFile(SinkHandle& sink_handle, const std::string path);
  * to the _statusbar_free_handles registry and frees its position in the
  * _statusbar_registry.
  *
+ * Writes to the sink still in flight on other threads are completed first,
+ * later calls with the handle fail as invalid.
  *
  * \param[in, out] sink_handle Struct to destroy.
  *
@@ -177,7 +461,9 @@ int CreateSinkFile(SinkHandle& sink_handle, const std::string path);
  *         - -4: Couldn't destroy sink: Invalid handle - Handle ID is 0 (i.e.
  * invalid)
  *         - -5: Couldn't destroy sink: Invalid handle - Errorcode not handled
- *         - -6: Failed to handle destruction of owned_file.
+ *         - -6: Failed to handle destruction of owned_file (or to trim and
+ * close the file of a mapped file sink, or to complete the writes of an
+ * io_uring sink).
  *
  * \see SinkHandle: The sink handle struct
  * \see Sink: The sink struct.
@@ -189,7 +475,16 @@ int CreateSinkFile(SinkHandle& sink_handle, const std::string path);
 int DestroySinkHandle(SinkHandle& sink_handle);
 
 /**
- * \brief Write len bytes (returns number of bytes written or -1 on error).
+ * \brief Write len bytes (returns number of bytes written or a negative value
+ * on error, -8 for binary sinks).
+ *
+ * fd-backed sinks buffer the output (see kSinkWriteBufferSize); it reaches the
+ * fd on FlushSinkHandle or once the buffer is full. -9 means writing the
+ * buffer to the fd failed. -10 means a mapped file sink failed to grow its
+ * file, -11 means a write of an io_uring sink failed.
+ *
+ * The handle is resolved without a global lock, writes to different sinks
+ * only synchronize on their own sink.
  */
 ssize_t SinkWrite(const SinkHandle& sink_handle, const char* buf,
                   std::size_t len);
@@ -200,6 +495,51 @@ ssize_t SinkWrite(const SinkHandle& sink_handle, const char* buf,
  */
 ssize_t SinkWriteStr(const SinkHandle& sink_handle, const std::string& str);
 
+/**
+ * \brief Writes one log record to a binary sink.
+ *
+ * The format string and the filename are interned: the first time a string is
+ * seen its definition record is written, afterwards only its id is stored.
+ *
+ * \param[in] sink_handle Handle of a statusbar_log::sink::kSinkBinary sink.
+ * \param[in] log_level Level of the message (statusbar_log::LogLevel).
+ * \param[in] filename Source filename or tag of the message.
+ * \param[in] fmt printf-style format string of the message.
+ * \param[in] args Argument bytes (see
+ * statusbar_log::binary_log::detail::EncodeArgs).
+ * \param[in] args_len Number of argument bytes.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error codes:
+ *         - -1 to -4: Invalid handle (see IsValidSinkHandle)
+ *         - -6: Not a binary sink
+ *         - -7: Argument bytes too long
+ *         - -8: Writing the record failed
+ */
+int SinkWriteBinaryLog(const SinkHandle& sink_handle, int log_level,
+                       const std::string& filename, const char* fmt,
+                       const char* args, std::size_t args_len);
+
+/**
+ * \brief Records a formatted log line on a flight recorder sink and dumps the
+ * recording if the level asks for it (see CreateSinkFlightRecorder).
+ *
+ * Recording takes no lock, only the dump does.
+ *
+ * \param[in] sink_handle Handle of a kSinkFlightRecorder sink.
+ * \param[in] log_level Level of the line (statusbar_log::LogLevel).
+ * \param[in] line The formatted line.
+ * \param[in] len Length of the line.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error codes:
+ *         - -1 to -4: Invalid handle (see IsValidSinkHandle)
+ *         - -6: Not a flight recorder sink
+ *         - -8: The line was recorded but dumping failed
+ */
+int SinkWriteFlightRecorderLog(const SinkHandle& sink_handle, int log_level,
+                               const char* line, std::size_t len);
+
 /**
  * \brief Flush a sink using its handle
  *
@@ -221,14 +561,100 @@ ssize_t SinkWriteStr(const SinkHandle& sink_handle, const std::string& str);
  *         - -5: Couldn't flush sink: Invalid handle (Errorcode not handled)
  *         - -6: Failed: Sink ostream not functional.
  *         - -7: Failed: Sink ostream became not functional after flushing.
+ *         - -8: Failed: Writing the buffered output of an fd-backed sink
+ * failed.
  */
 int FlushSinkHandle(const SinkHandle& sink_handle);
 
+/**
+ * \brief Flushes a sink if its flush policy asks for it at the end of an
+ * operation (see SinkFlushPolicy).
+ *
+ * Called by the statusbar_log functions after each log line, statusbar update
+ * or escape sequence. Tee sinks apply the policies of their children.
+ *
+ * \param[in] sink_handle The sink the operation wrote to.
+ * \param[in] log_level Level of the log line written (statusbar_log::LogLevel),
+ * 0 (i.e. statusbar_log::kLogLevelOff) for other operations.
+ *
+ * \return Same codes as FlushSinkHandle (statusbar_log::kStatusbarLogSuccess
+ * also if no flush was due).
+ */
+int FlushSinkHandleIfDue(const SinkHandle& sink_handle, int log_level);
+
+/**
+ * \brief Sets the flush policy of a sink.
+ *
+ * Time based flushes (`every_ms`) are done by one timer thread shared by all
+ * sinks. It is started with the first such policy and waits while no sink
+ * needs it.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error codes:
+ *         - -1 to -4: Invalid handle (see IsValidSinkHandle)
+ *         - -5: The flush timer thread could not be started
+ *         - -6: Tee sinks have no policy, their children's policies apply
+ */
+int SetSinkFlushPolicy(const SinkHandle& sink_handle,
+                       const SinkFlushPolicy& policy);
+
+/**
+ * \brief Reads the flush policy of a sink (see SetSinkFlushPolicy).
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * -1 to -4 for an invalid handle (see IsValidSinkHandle).
+ */
+int GetSinkFlushPolicy(const SinkHandle& sink_handle, SinkFlushPolicy& policy);
+
 /**
  * Returns true if the underlying stream is a TTY (best-effort).
+ *
+ * Detected when the sink is created, reading it takes no lock and makes no
+ * system call.
  */
 bool SinkIsTty(const SinkHandle& sink_handle);
 
+/**
+ * \brief Reads the capabilities of a sink.
+ *
+ * The capabilities are detected once when the sink is created (Create*
+ * functions). Reading them takes no lock and makes no system call, so it is
+ * cheap enough for every log call and every statusbar draw.
+ *
+ * \param[in] sink_handle Sink handle struct of which to get the capabilities.
+ * \param[out] capabilities Receives the capabilities.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these status codes:
+ *         -  statusbar_log::kStatusbarLogSuccess (i.e. 0): Valid handle
+ *         - -1: Failed: Invalid handle (Valid flag of handle set to false)
+ *         - -2: Failed: Invalid handle (Handle index out of bounds)
+ *         - -3: Failed: Invalid handle (Handle IDs don't match, e.g. the sink
+ * was destroyed)
+ *         - -4: Failed: Invalid handle (Handle ID is 0 (i.e. invalid))
+ *
+ * \see SinkCapabilities: The detected properties.
+ */
+int GetSinkCapabilities(const SinkHandle& sink_handle,
+                        SinkCapabilities& capabilities);
+
+/**
+ * \brief Reads the children of a tee sink.
+ *
+ * The children are fixed when the tee is created, reading them takes no lock.
+ *
+ * \param[in] sink_handle Handle of a kSinkTee sink.
+ * \param[out] children Receives the children (the first `count` entries).
+ * \param[out] count Number of children.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these status codes:
+ *         - -1 to -4: Invalid handle (see GetSinkCapabilities)
+ *         - -5: Not a tee sink
+ */
+int GetSinkTeeChildren(const SinkHandle& sink_handle,
+                       SinkTeeChildren& children, std::size_t& count);
+
 /**
  * \brief Get a unique lock of the mutex associated to the sink handle.
  *
@@ -260,7 +686,8 @@ int get_unique_lock(const SinkHandle& sink_handle,
  * \brief Get the pointer to the mutex associated to the sink handle.
  *
  * This function is used to retrieve a pointer to the mutex of
- * the sink assocated to the handle.
+ * the sink assocated to the handle. The mutex stays valid after the sink is
+ * destroyed (it is reused by a later sink).
  *
  * \param[in] sink_handle Sink handle struct of which to get the mutex.
  * \param[in, out]  sink_mutex_ptr Pointer in which the mutex pointer will be
@@ -286,7 +713,8 @@ int get_mutex_ptr(const SinkHandle& sink_handle, std::mutex*& sink_mutex_ptr);
  * \brief Get the sink type associated to the sink handle.
  *
  * This function is used to retrieve a the sink type of the sink associated to
- * the handle
+ * the handle. Valid handles are resolved without taking a lock (see
+ * GetSinkCapabilities).
  *
  * \param[in] sink_handle Sink handle struct of which to get the type.
  * \param[in, out] sink_type SinkType struct in which to save type.
@@ -315,10 +743,15 @@ int get_sink_type(const SinkHandle& sink_handle, SinkType& sink_type);
  * N lines. For moving down it writes N newline characters.
  *
  * Behavior:
- * - If the sink has a valid file descriptor (fd >= 0) writes directly to that
- *   fd.
+ * - If the sink has a valid file descriptor (fd >= 0) adds the sequence to the
+ *   write buffer of the sink (see SinkWrite).
  * - If the sink wraps std::cout or std::cerr, writes to fileno(stdout|stderr).
- * - If the sink is an arbitrary ostream (file or wrapped ostream), the
+ * - If the sink owns a text file (kSinkFileOwned, kSinkMappedFile,
+ *   kSinkUringFile), moving up removes the last N lines from the file and
+ *   moving down appends N newlines. The offsets of recent lines are
+ *   remembered while writing, so the file is only re-read when removing more
+ *   lines than remembered.
+ * - Binary and flight recorder sinks have no cursor, nothing happens.
  *
  * \param[in] sink_handle Sink handle struct of which to get the type.
  * \param[in] move number of lines to move up (positive value) or down (negative
@@ -340,6 +773,7 @@ int get_sink_type(const SinkHandle& sink_handle, SinkType& sink_type);
  *         - -6: Failed: Could not obtain sink pointer from registry.
  *         - -7: Failed: Failed to write to fd-backed sink.
  *         - -8: Failed: Failed to open file (trying to move up).
+ *         - -9: Failed: Failed to truncate file (trying to move up).
  */
 int MoveCursorUp(const SinkHandle& sink_handle, int move);
 
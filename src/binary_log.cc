@@ -0,0 +1,595 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/src/binary_log.cc
+
+// clang-format off
+
+#include "statusbarlog/binary_log.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "statusbarlog/sink.h"
+#include "statusbarlog/statusbarlog.h"
+
+// clang-format on
+
+namespace statusbar_log {
+namespace binary_log {
+
+namespace {
+
+/// Upper bound for the payload of a single record, protects the decoder from
+/// allocating huge buffers for corrupt files.
+constexpr std::uint32_t kMaxPayloadLength = 16 * 1024 * 1024;
+
+/**
+ * \enum LengthModifier
+ * \brief printf length modifiers understood by the encoder.
+ */
+typedef enum {
+  kLengthNone,
+  kLengthHH,
+  kLengthH,
+  kLengthL,
+  kLengthLL,
+  kLengthJ,
+  kLengthZ,
+  kLengthT,
+  kLengthBigL,
+} LengthModifier;
+
+/**
+ * \struct Conversion
+ * \brief One parsed printf conversion specification.
+ */
+// clang-format off
+typedef struct {
+  std::size_t prefix_len;  ///< Length of "%", flags, width and precision (without the length modifier).
+  bool width_star;         ///< Width is given as an argument ('*').
+  bool precision_star;     ///< Precision is given as an argument ('.*').
+  int precision;           ///< Fixed precision (-1 if none or given as argument).
+  LengthModifier length;   ///< Length modifier.
+  char conversion;         ///< Conversion character.
+} Conversion;
+// clang-format on
+
+/**
+ * \brief Parses the conversion specification starting at `*p` (which points
+ * at '%') and advances `p` behind it.
+ *
+ * \return false if the format string ends inside the specification.
+ */
+bool _ParseConversion(const char*& p, Conversion& conv) {
+  const char* start = p++;
+  conv.width_star = false;
+  conv.precision_star = false;
+  conv.precision = -1;
+  conv.length = kLengthNone;
+
+  while (*p && std::strchr("-+ #0'", *p)) ++p;
+  if (*p == '*') {
+    conv.width_star = true;
+    ++p;
+  } else {
+    while (*p >= '0' && *p <= '9') ++p;
+  }
+  if (*p == '.') {
+    ++p;
+    if (*p == '*') {
+      conv.precision_star = true;
+      ++p;
+    } else {
+      conv.precision = 0;
+      while (*p >= '0' && *p <= '9') {
+        conv.precision = conv.precision * 10 + (*p - '0');
+        ++p;
+      }
+    }
+  }
+  conv.prefix_len = static_cast<std::size_t>(p - start);
+
+  switch (*p) {
+    case 'h':
+      conv.length = (p[1] == 'h') ? kLengthHH : kLengthH;
+      p += (p[1] == 'h') ? 2 : 1;
+      break;
+    case 'l':
+      conv.length = (p[1] == 'l') ? kLengthLL : kLengthL;
+      p += (p[1] == 'l') ? 2 : 1;
+      break;
+    case 'q':
+      conv.length = kLengthLL;
+      ++p;
+      break;
+    case 'j':
+      conv.length = kLengthJ;
+      ++p;
+      break;
+    case 'z':
+      conv.length = kLengthZ;
+      ++p;
+      break;
+    case 't':
+      conv.length = kLengthT;
+      ++p;
+      break;
+    case 'L':
+      conv.length = kLengthBigL;
+      ++p;
+      break;
+    default:
+      break;
+  }
+
+  if (*p == '\0') return false;
+  conv.conversion = *p++;
+  return true;
+}
+
+/**
+ * \brief Appends the raw bytes of `value` to the output buffer.
+ *
+ * \return false if the value does not fit.
+ */
+template <typename T>
+bool _Put(char*& out, const char* end, const T value) {
+  if (static_cast<std::size_t>(end - out) < sizeof(T)) return false;
+  std::memcpy(out, &value, sizeof(T));
+  out += sizeof(T);
+  return true;
+}
+
+/**
+ * \brief Reads a signed integer argument of the given length and converts it
+ * the way printf would before printing.
+ */
+bool _ReadSigned(va_list& ap, const LengthModifier length,
+                 std::int64_t& value) {
+  switch (length) {
+    case kLengthNone:
+      value = va_arg(ap, int);
+      return true;
+    case kLengthHH:
+      value = static_cast<signed char>(va_arg(ap, int));
+      return true;
+    case kLengthH:
+      value = static_cast<short>(va_arg(ap, int));
+      return true;
+    case kLengthL:
+      value = va_arg(ap, long);
+      return true;
+    case kLengthLL:
+      value = va_arg(ap, long long);
+      return true;
+    case kLengthJ:
+      value = va_arg(ap, std::intmax_t);
+      return true;
+    case kLengthZ:
+      value = va_arg(ap, std::make_signed_t<std::size_t>);
+      return true;
+    case kLengthT:
+      value = va_arg(ap, std::ptrdiff_t);
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * \brief Reads an unsigned integer argument of the given length and converts
+ * it the way printf would before printing.
+ */
+bool _ReadUnsigned(va_list& ap, const LengthModifier length,
+                   std::uint64_t& value) {
+  switch (length) {
+    case kLengthNone:
+      value = va_arg(ap, unsigned int);
+      return true;
+    case kLengthHH:
+      value = static_cast<unsigned char>(va_arg(ap, unsigned int));
+      return true;
+    case kLengthH:
+      value = static_cast<unsigned short>(va_arg(ap, unsigned int));
+      return true;
+    case kLengthL:
+      value = va_arg(ap, unsigned long);
+      return true;
+    case kLengthLL:
+      value = va_arg(ap, unsigned long long);
+      return true;
+    case kLengthJ:
+      value = va_arg(ap, std::uintmax_t);
+      return true;
+    case kLengthZ:
+      value = va_arg(ap, std::size_t);
+      return true;
+    case kLengthT:
+      value = static_cast<std::make_unsigned_t<std::ptrdiff_t>>(
+          va_arg(ap, std::ptrdiff_t));
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * \brief Encodes all arguments of `fmt` (see EncodeArgs).
+ */
+long _EncodeArgs(const char* fmt, va_list& ap, char* out,
+                 const std::size_t capacity) {
+  char* p = out;
+  const char* const end = out + capacity;
+  const char* f = fmt;
+  while (*f) {
+    if (*f != '%') {
+      ++f;
+      continue;
+    }
+    Conversion conv;
+    if (!_ParseConversion(f, conv)) return -1;
+    if (conv.conversion == '%') continue;
+
+    int precision = conv.precision;
+    if (conv.width_star && !_Put<std::int32_t>(p, end, va_arg(ap, int))) {
+      return -1;
+    }
+    if (conv.precision_star) {
+      const int star_precision = va_arg(ap, int);
+      if (!_Put<std::int32_t>(p, end, star_precision)) return -1;
+      precision = star_precision < 0 ? -1 : star_precision;
+    }
+
+    switch (conv.conversion) {
+      case 'd':
+      case 'i': {
+        std::int64_t value;
+        if (!_ReadSigned(ap, conv.length, value)) return -1;
+        if (!_Put(p, end, value)) return -1;
+        break;
+      }
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X': {
+        std::uint64_t value;
+        if (!_ReadUnsigned(ap, conv.length, value)) return -1;
+        if (!_Put(p, end, value)) return -1;
+        break;
+      }
+      case 'c':
+        if (conv.length != kLengthNone) return -1;
+        if (!_Put<std::int32_t>(p, end, va_arg(ap, int))) return -1;
+        break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A': {
+        const double value =
+            (conv.length == kLengthBigL)
+                ? static_cast<double>(va_arg(ap, long double))
+                : va_arg(ap, double);
+        if (!_Put(p, end, value)) return -1;
+        break;
+      }
+      case 's': {
+        if (conv.length != kLengthNone) return -1;
+        const char* str = va_arg(ap, const char*);
+        if (!str) str = "(null)";
+        const std::size_t len =
+            (precision >= 0)
+                ? strnlen(str, static_cast<std::size_t>(precision))
+                : std::strlen(str);
+        if (!_Put(p, end, static_cast<std::uint32_t>(len)) ||
+            static_cast<std::size_t>(end - p) < len) {
+          return -1;
+        }
+        std::memcpy(p, str, len);
+        p += len;
+        break;
+      }
+      case 'p':
+        if (!_Put<std::uint64_t>(
+                p, end, reinterpret_cast<std::uintptr_t>(va_arg(ap, void*)))) {
+          return -1;
+        }
+        break;
+      case 'n':
+        va_arg(ap, void*);
+        break;
+      default:
+        return -1;
+    }
+  }
+  return static_cast<long>(p - out);
+}
+
+/**
+ * \struct ArgReader
+ * \brief Bounds checked reader over the argument bytes of a record.
+ */
+typedef struct {
+  const char* p;
+  const char* end;
+} ArgReader;
+
+template <typename T>
+bool _Get(ArgReader& reader, T& value) {
+  if (static_cast<std::size_t>(reader.end - reader.p) < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&value, reader.p, sizeof(T));
+  reader.p += sizeof(T);
+  return true;
+}
+
+/**
+ * \brief snprintf with zero, one or two '*' arguments in front of the value.
+ */
+template <typename T>
+int _SnprintfSpec(char* out, const std::size_t capacity, const char* spec,
+                  const int* stars, const int num_stars, const T value) {
+  switch (num_stars) {
+    case 0:
+      return std::snprintf(out, capacity, spec, value);
+    case 1:
+      return std::snprintf(out, capacity, spec, stars[0], value);
+    default:
+      return std::snprintf(out, capacity, spec, stars[0], stars[1], value);
+  }
+}
+
+/**
+ * \brief Formats one conversion and appends the result to `message`.
+ *
+ * Widths and precisions come from the decoded file, so the result is truncated
+ * to what still fits into kMaxLogLength instead of being allocated in full.
+ */
+template <typename T>
+void _AppendFormatted(std::string& message, const std::string& spec,
+                      const int* stars, const int num_stars, const T value) {
+  char buffer[256];
+  const int n = _SnprintfSpec(buffer, sizeof(buffer), spec.c_str(), stars,
+                              num_stars, value);
+  if (n < 0) return;
+  if (static_cast<std::size_t>(n) < sizeof(buffer)) {
+    message.append(buffer, static_cast<std::size_t>(n));
+    return;
+  }
+  if (message.size() >= kMaxLogLength) return;
+  const std::size_t capacity =
+      std::min(static_cast<std::size_t>(n), kMaxLogLength - message.size()) +
+      1;
+  std::vector<char> large(capacity);
+  _SnprintfSpec(large.data(), large.size(), spec.c_str(), stars, num_stars,
+                value);
+  message.append(large.data(), capacity - 1);
+}
+
+/**
+ * \brief Re-creates the message of a log record from its format string and
+ * argument bytes.
+ *
+ * \return false if the argument bytes do not match the format string.
+ */
+bool _FormatRecord(const std::string& fmt, ArgReader reader,
+                   std::string& message) {
+  const char* f = fmt.c_str();
+  while (*f && message.size() <= kMaxLogLength) {
+    if (*f != '%') {
+      const char* literal_end = std::strchr(f, '%');
+      if (!literal_end) literal_end = f + std::strlen(f);
+      message.append(f, static_cast<std::size_t>(literal_end - f));
+      f = literal_end;
+      continue;
+    }
+
+    const char* start = f;
+    Conversion conv;
+    if (!_ParseConversion(f, conv)) return false;
+    if (conv.conversion == '%') {
+      message += '%';
+      continue;
+    }
+
+    // Stored stars are clamped, a message never gets wider than kMaxLogLength.
+    constexpr std::int32_t kMaxStar = static_cast<std::int32_t>(kMaxLogLength);
+    int stars[2];
+    int num_stars = 0;
+    std::int32_t star;
+    if (conv.width_star) {
+      if (!_Get(reader, star)) return false;
+      stars[num_stars++] = std::clamp(star, -kMaxStar, kMaxStar);
+    }
+    if (conv.precision_star) {
+      if (!_Get(reader, star)) return false;
+      stars[num_stars++] = std::clamp(star, -1, kMaxStar);
+    }
+
+    // Flags, width and precision are kept, the length modifier is replaced by
+    // the one matching the stored type.
+    std::string spec(start, conv.prefix_len);
+    switch (conv.conversion) {
+      case 'd':
+      case 'i': {
+        std::int64_t value;
+        if (!_Get(reader, value)) return false;
+        spec += "ll";
+        spec += conv.conversion;
+        _AppendFormatted(message, spec, stars, num_stars,
+                         static_cast<long long>(value));
+        break;
+      }
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X': {
+        std::uint64_t value;
+        if (!_Get(reader, value)) return false;
+        spec += "ll";
+        spec += conv.conversion;
+        _AppendFormatted(message, spec, stars, num_stars,
+                         static_cast<unsigned long long>(value));
+        break;
+      }
+      case 'c': {
+        std::int32_t value;
+        if (!_Get(reader, value)) return false;
+        spec += conv.conversion;
+        _AppendFormatted(message, spec, stars, num_stars,
+                         static_cast<int>(value));
+        break;
+      }
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A': {
+        double value;
+        if (!_Get(reader, value)) return false;
+        spec += conv.conversion;
+        _AppendFormatted(message, spec, stars, num_stars, value);
+        break;
+      }
+      case 's': {
+        std::uint32_t len;
+        if (!_Get(reader, len)) return false;
+        if (static_cast<std::size_t>(reader.end - reader.p) < len) {
+          return false;
+        }
+        const std::string value(reader.p, len);
+        reader.p += len;
+        spec += conv.conversion;
+        _AppendFormatted(message, spec, stars, num_stars, value.c_str());
+        break;
+      }
+      case 'p': {
+        std::uint64_t value;
+        if (!_Get(reader, value)) return false;
+        spec += conv.conversion;
+        _AppendFormatted(
+            message, spec, stars, num_stars,
+            reinterpret_cast<void*>(static_cast<std::uintptr_t>(value)));
+        break;
+      }
+      case 'n':
+        break;
+      default:
+        return false;
+    }
+  }
+  if (message.size() > kMaxLogLength) message.resize(kMaxLogLength);
+  return true;
+}
+
+}  // namespace
+
+namespace detail {
+
+long EncodeArgs(const char* fmt, va_list args, char* out,
+                const std::size_t capacity) {
+  va_list args_copy;
+  va_copy(args_copy, args);
+  const long len = _EncodeArgs(fmt, args_copy, out, capacity);
+  va_end(args_copy);
+  return len;
+}
+
+}  // namespace detail
+
+int DecodeBinaryLog(const std::string& path, sink::SinkHandle sink_handle) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) return -1;
+
+  char header[kFileHeaderLength];
+  if (!in.read(header, sizeof(header))) return -2;
+  std::uint16_t version;
+  std::uint16_t byte_order_mark;
+  std::memcpy(&version, header + 4, sizeof(version));
+  std::memcpy(&byte_order_mark, header + 6, sizeof(byte_order_mark));
+  if (std::memcmp(header, kMagic, sizeof(kMagic)) != 0 ||
+      version != kFormatVersion || byte_order_mark != kByteOrderMark) {
+    return -2;
+  }
+
+  std::unordered_map<std::uint32_t, std::string> strings;
+  std::vector<char> payload;
+  std::string message;
+  while (true) {
+    char record_header[kRecordHeaderLength];
+    in.read(record_header, sizeof(record_header));
+    if (in.gcount() == 0) break;
+    if (in.gcount() != static_cast<std::streamsize>(sizeof(record_header))) {
+      return -3;
+    }
+    std::uint32_t payload_len;
+    std::memcpy(&payload_len, record_header + 1, sizeof(payload_len));
+    if (payload_len > kMaxPayloadLength) return -3;
+    payload.resize(payload_len);
+    if (!in.read(payload.data(), payload_len)) return -3;
+
+    ArgReader reader = {payload.data(), payload.data() + payload.size()};
+    if (record_header[0] == kRecordString) {
+      std::uint32_t id;
+      if (!_Get(reader, id)) return -3;
+      strings[id].assign(reader.p, reader.end);
+      continue;
+    }
+    if (record_header[0] != kRecordLog) return -3;
+
+    std::uint8_t level;
+    std::uint32_t fmt_id;
+    std::uint32_t file_id;
+    if (!_Get(reader, level) || !_Get(reader, fmt_id) ||
+        !_Get(reader, file_id) || level > kLogLevelDbg) {
+      return -3;
+    }
+    const auto fmt_it = strings.find(fmt_id);
+    const auto file_it = strings.find(file_id);
+    if (fmt_it == strings.end() || file_it == strings.end()) return -4;
+
+    message.clear();
+    if (!_FormatRecord(fmt_it->second, reader, message)) return -3;
+
+    ::statusbar_log::detail::LogLine line;
+    int err = ::statusbar_log::detail::BeginLogLine(
+        static_cast<LogLevel>(level), file_it->second, sink_handle, line);
+    if (err != kStatusbarLogSuccess) return -5;
+    const std::size_t len = std::min(message.size(), line.message_capacity);
+    std::memcpy(line.message, message.data(), len);
+    err = ::statusbar_log::detail::CommitLogLine(line, len);
+    if (err != kStatusbarLogSuccess) return -5;
+  }
+  return kStatusbarLogSuccess;
+}
+
+}  // namespace binary_log
+}  // namespace statusbar_log
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/src/line_diff.cc
+
+// clang-format off
+
+#include "line_diff.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// clang-format on
+
+namespace statusbar_log {
+namespace detail {
+
+namespace {
+
+/// Unchanged characters between two changed runs up to which the runs are
+/// written as one (cheaper than a cursor movement).
+constexpr std::size_t kLineDiffMergeGap = 4;
+
+/**
+ * \brief Appends a CHA sequence moving the cursor to (0-based) column `col`.
+ */
+void _AppendCursorColumn(std::string& out, const std::size_t col) {
+  char seq[32];
+  const int len = std::snprintf(seq, sizeof(seq), "\033[%zuG", col + 1);
+  out.append(seq, static_cast<std::size_t>(len));
+}
+
+}  // namespace
+
+bool AppendLineDiff(std::string& out, const std::string_view old_line,
+                    const std::string_view new_line) {
+  for (const std::string_view line : {old_line, new_line}) {
+    for (const char c : line) {
+      if (static_cast<unsigned char>(c) >= 0x80) return false;
+    }
+  }
+
+  const std::size_t common = std::min(old_line.size(), new_line.size());
+  std::size_t cursor = std::string::npos;
+  std::size_t i = 0;
+  while (i < common) {
+    if (old_line[i] == new_line[i]) {
+      ++i;
+      continue;
+    }
+    std::size_t last_change = i;
+    for (std::size_t j = i + 1;
+         j < common && j - last_change <= kLineDiffMergeGap; ++j) {
+      if (old_line[j] != new_line[j]) last_change = j;
+    }
+    if (cursor != i) _AppendCursorColumn(out, i);
+    out.append(new_line.substr(i, last_change + 1 - i));
+    cursor = last_change + 1;
+    i = cursor;
+  }
+
+  if (new_line.size() > common) {
+    if (cursor != common) _AppendCursorColumn(out, common);
+    out.append(new_line.substr(common));
+  } else if (old_line.size() > common) {
+    if (cursor != common) _AppendCursorColumn(out, common);
+    out += "\033[K";
+  }
+  return true;
+}
+
+}  // namespace detail
+}  // namespace statusbar_log
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/src/line_diff.h
+
+#ifndef STATUSBARLOG_LINE_DIFF_H_
+#define STATUSBARLOG_LINE_DIFF_H_
+
+// clang-format off
+
+#include <string>
+#include <string_view>
+
+// clang-format on
+
+/**
+ * \file line_diff.h
+ * \brief Incremental redraw of statusbar lines on a terminal.
+ *
+ * Internal to the library (and its tests), not part of the installed headers.
+ */
+
+namespace statusbar_log {
+namespace detail {
+
+/**
+ * \brief Appends what has to be written to turn `old_line` into `new_line`
+ * on the terminal line the cursor is on.
+ *
+ * Only the runs of changed characters are written, each after a CHA
+ * ("\033[<column>G") sequence moving the cursor to its column. A shorter line
+ * is cut with an EL ("\033[K") sequence. Nothing is appended if the lines are
+ * equal.
+ *
+ * \return false if one of the lines contains non-ASCII characters, whose
+ * columns can not be derived from byte offsets. The line has to be redrawn
+ * completely then.
+ */
+bool AppendLineDiff(std::string& out, std::string_view old_line,
+                    std::string_view new_line);
+
+}  // namespace detail
+}  // namespace statusbar_log
+
+#endif  // STATUSBARLOG_LINE_DIFF_H_
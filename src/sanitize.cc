@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/src/sanitize.cc
+
+// clang-format off
+
+#include "sanitize.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define STATUSBARLOG_HAVE_SSE2 1
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define STATUSBARLOG_HAVE_AVX2 1
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// clang-format on
+
+namespace statusbar_log {
+namespace detail {
+
+namespace {
+
+typedef std::size_t (*FindReplacedCharFn)(const char*, std::size_t, bool);
+
+/**
+ * \brief Index of the lowest set bit (the mask must not be 0).
+ */
+inline unsigned int _CountTrailingZeros(const unsigned int mask) {
+#if defined(_MSC_VER)
+  unsigned long idx;
+  _BitScanForward(&idx, mask);
+  return static_cast<unsigned int>(idx);
+#else
+  return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+#if defined(STATUSBARLOG_HAVE_SSE2)
+std::size_t _FindReplacedCharSse2(const char* data, const std::size_t len,
+                                  const bool allow_newline) {
+  const __m128i max_control = _mm_set1_epi8(31);
+  const __m128i del = _mm_set1_epi8(127);
+  const __m128i tab = _mm_set1_epi8('\t');
+  // With newlines allowed they are skipped like tabs, otherwise the compare
+  // against tab is simply repeated.
+  const __m128i newline = _mm_set1_epi8(allow_newline ? '\n' : '\t');
+
+  std::size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // Unsigned v <= 31: min(v, 31) == v
+    const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(v, max_control), v);
+    const __m128i allowed =
+        _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, newline));
+    const __m128i replaced = _mm_or_si128(_mm_andnot_si128(allowed, control),
+                                          _mm_cmpeq_epi8(v, del));
+    const unsigned int mask =
+        static_cast<unsigned int>(_mm_movemask_epi8(replaced));
+    if (mask != 0) return i + _CountTrailingZeros(mask);
+  }
+  return i + FindReplacedCharScalar(data + i, len - i, allow_newline);
+}
+#endif  // defined(STATUSBARLOG_HAVE_SSE2)
+
+#if defined(STATUSBARLOG_HAVE_AVX2)
+__attribute__((target("avx2"))) std::size_t _FindReplacedCharAvx2(
+    const char* data, const std::size_t len, const bool allow_newline) {
+  const __m256i max_control = _mm256_set1_epi8(31);
+  const __m256i del = _mm256_set1_epi8(127);
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i newline = _mm256_set1_epi8(allow_newline ? '\n' : '\t');
+
+  std::size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i control =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(v, max_control), v);
+    const __m256i allowed = _mm256_or_si256(_mm256_cmpeq_epi8(v, tab),
+                                            _mm256_cmpeq_epi8(v, newline));
+    const __m256i replaced = _mm256_or_si256(
+        _mm256_andnot_si256(allowed, control), _mm256_cmpeq_epi8(v, del));
+    const unsigned int mask =
+        static_cast<unsigned int>(_mm256_movemask_epi8(replaced));
+    if (mask != 0) {
+      _mm256_zeroupper();
+      return i + _CountTrailingZeros(mask);
+    }
+  }
+  // Leave the AVX state clean, otherwise the SSE2 code of the tail (and of
+  // the caller) pays for a state transition on every instruction.
+  _mm256_zeroupper();
+  return i + _FindReplacedCharSse2(data + i, len - i, allow_newline);
+}
+#endif  // defined(STATUSBARLOG_HAVE_AVX2)
+
+/**
+ * \brief Picks the fastest FindReplacedChar implementation the CPU supports.
+ */
+FindReplacedCharFn _SelectFindReplacedChar(const char*& name) {
+#if defined(STATUSBARLOG_HAVE_AVX2)
+  // May run before the constructor that initializes the CPU model does.
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    name = "avx2";
+    return _FindReplacedCharAvx2;
+  }
+#endif
+#if defined(STATUSBARLOG_HAVE_SSE2)
+  name = "sse2";
+  return _FindReplacedCharSse2;
+#else
+  name = "scalar";
+  return FindReplacedCharScalar;
+#endif
+}
+
+std::size_t _ResolveFindReplacedChar(const char* data, std::size_t len,
+                                     bool allow_newline);
+
+/// Implementation used by FindReplacedChar. Constant-initialized to the
+/// resolver, which replaces itself on the first call, so the dispatch also
+/// works from static constructors of other translation units.
+constinit std::atomic<FindReplacedCharFn> _find_replaced_char =
+    _ResolveFindReplacedChar;
+/// Name of the implementation (nullptr until resolved).
+constinit std::atomic<const char*> _find_replaced_char_name = nullptr;
+
+/**
+ * \brief Selects the implementation and publishes it (threads racing here
+ * all store the same result).
+ */
+FindReplacedCharFn _ResolveFindReplacedCharOnce() {
+  const char* name = "scalar";
+  const FindReplacedCharFn fn = _SelectFindReplacedChar(name);
+  _find_replaced_char_name.store(name, std::memory_order_relaxed);
+  _find_replaced_char.store(fn, std::memory_order_relaxed);
+  return fn;
+}
+
+std::size_t _ResolveFindReplacedChar(const char* data, const std::size_t len,
+                                     const bool allow_newline) {
+  return _ResolveFindReplacedCharOnce()(data, len, allow_newline);
+}
+
+}  // namespace
+
+std::size_t FindReplacedCharScalar(const char* data, const std::size_t len,
+                                   const bool allow_newline) {
+  std::size_t i = 0;
+  while (i < len && !IsReplacedChar(data[i], allow_newline)) ++i;
+  return i;
+}
+
+std::size_t FindReplacedChar(const char* data, const std::size_t len,
+                             const bool allow_newline) {
+  // Short strings (most filenames) are not worth the indirect call.
+  if (len < 16) return FindReplacedCharScalar(data, len, allow_newline);
+  return _find_replaced_char.load(std::memory_order_relaxed)(data, len,
+                                                             allow_newline);
+}
+
+const char* FindReplacedCharImplementation() {
+  const char* name = _find_replaced_char_name.load(std::memory_order_relaxed);
+  if (name == nullptr) {
+    _ResolveFindReplacedCharOnce();
+    name = _find_replaced_char_name.load(std::memory_order_relaxed);
+  }
+  return name;
+}
+
+std::size_t SanitizeInPlace(char* data, const std::size_t len,
+                            const std::size_t capacity,
+                            const bool allow_newline) {
+  const std::size_t first = FindReplacedChar(data, len, allow_newline);
+  if (first == len) return len;
+
+  // Find how much of the input fits once expanded, jumping from one control
+  // character to the next.
+  std::size_t src_end = first;
+  std::size_t new_len = first;
+  while (src_end < len) {
+    // data[src_end] has to be replaced.
+    if (new_len + kReplacementCharLength > capacity) break;
+    new_len += kReplacementCharLength;
+    ++src_end;
+
+    const std::size_t clean =
+        FindReplacedChar(data + src_end, len - src_end, allow_newline);
+    if (new_len + clean > capacity) {
+      src_end += capacity - new_len;
+      new_len = capacity;
+      break;
+    }
+    new_len += clean;
+    src_end += clean;
+  }
+
+  // Expand back to front so no byte is overwritten before it is moved.
+  std::size_t dst = new_len;
+  for (std::size_t src = src_end; src-- > first;) {
+    if (IsReplacedChar(data[src], allow_newline)) {
+      dst -= kReplacementCharLength;
+      std::memcpy(data + dst, kReplacementChar, kReplacementCharLength);
+    } else {
+      data[--dst] = data[src];
+    }
+  }
+  return new_len;
+}
+
+std::string SanitizeString(std::string input) {
+  std::size_t pos = FindReplacedChar(input.data(), input.size(), false);
+  if (pos == input.size()) return input;
+
+  std::string output;
+  output.reserve(input.size() + 2 * kReplacementCharLength);
+  std::size_t start = 0;
+  while (pos < input.size()) {
+    output.append(input, start, pos - start);
+    output.append(kReplacementChar, kReplacementCharLength);
+    start = pos + 1;
+    pos = start +
+          FindReplacedChar(input.data() + start, input.size() - start, false);
+  }
+  output.append(input, start, std::string::npos);
+  return output;
+}
+
+}  // namespace detail
+}  // namespace statusbar_log
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/src/sanitize.h
+
+#ifndef STATUSBARLOG_SANITIZE_H_
+#define STATUSBARLOG_SANITIZE_H_
+
+// clang-format off
+
+#include <cstddef>
+#include <string>
+
+// clang-format on
+
+namespace statusbar_log {
+namespace detail {
+
+/// UTF-8 encoding of U+FFFD, the replacement for sanitized control characters.
+constexpr char kReplacementChar[] = "\xEF\xBF\xBD";
+constexpr std::size_t kReplacementCharLength = sizeof(kReplacementChar) - 1;
+
+/**
+ * \brief Returns true if `c` is a control character that has to be replaced
+ * by the sanitizers (everything below 32 and DEL, except \\t and optionally
+ * \\n).
+ */
+inline bool IsReplacedChar(const char c, const bool allow_newline) {
+  const unsigned char uc = static_cast<unsigned char>(c);
+  if (c == '\t' || (allow_newline && c == '\n')) return false;
+  return uc < 32 || uc == 127;
+}
+
+/**
+ * \brief Returns the index of the first character in `data` that has to be
+ * replaced (see IsReplacedChar), or `len` if there is none.
+ *
+ * Scans 32 (AVX2) or 16 (SSE2) bytes per step. The implementation is picked
+ * once at runtime from the CPU features, other architectures use
+ * FindReplacedCharScalar.
+ */
+std::size_t FindReplacedChar(const char* data, std::size_t len,
+                             bool allow_newline);
+
+/**
+ * \brief Byte by byte version of FindReplacedChar (reference and fallback).
+ */
+std::size_t FindReplacedCharScalar(const char* data, std::size_t len,
+                                   bool allow_newline);
+
+/**
+ * \brief Name of the implementation used by FindReplacedChar ("avx2", "sse2"
+ * or "scalar").
+ */
+const char* FindReplacedCharImplementation();
+
+/**
+ * \brief Sanitizes `len` bytes at `data` in place.
+ *
+ * Control characters (see IsReplacedChar) are replaced by U+FFFD. As the
+ * replacement is three bytes long the text grows towards the end of the
+ * buffer; bytes that no longer fit into `capacity` are cut off. Clean input is
+ * only scanned, never written, and bytes in front of the first control
+ * character are never moved.
+ *
+ * \return The new length (<= capacity).
+ */
+std::size_t SanitizeInPlace(char* data, std::size_t len, std::size_t capacity,
+                            bool allow_newline);
+
+/**
+ * \brief Sanitizes a string for use in post- and prefixes of statusbars.
+ *
+ * Replaces all control characters except \\t (newlines included). Clean
+ * strings are returned as they are, without copying.
+ */
+std::string SanitizeString(std::string input);
+
+}  // namespace detail
+}  // namespace statusbar_log
+
+#endif  // STATUSBARLOG_SANITIZE_H_
@@ -21,22 +21,45 @@
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
+#include <functional>
 #include <ios>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <ostream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "slot_map.h"
+#include "statusbarlog/binary_log.h"
 #include "statusbarlog/statusbarlog.h"
+#include "uring_file.h"
 
 // clang-format on
 
@@ -47,6 +70,64 @@ namespace sink {
 
 namespace {
 
+/// Newlines of an owned file MoveCursorUp can remove without reading the file.
+constexpr std::size_t kLineIndexSize = 128;
+
+/**
+ * \struct LineIndex
+ *
+ * \brief Offsets of the most recent newlines written to an owned file, kept
+ * as a ring so MoveCursorUp can truncate the file without re-reading it.
+ */
+typedef struct {
+  std::array<std::uint64_t, kLineIndexSize>
+      newlines;        ///< Offsets of the newline bytes, oldest first from tail
+  std::size_t head;    ///< Slot the next newline offset is stored in
+  std::size_t count;   ///< Number of offsets in the ring
+  std::uint64_t size;  ///< File size, including output not flushed yet
+  bool complete;       ///< The ring holds every newline of the file
+} LineIndex;
+
+/**
+ * \struct MappedFile
+ *
+ * \brief File of a kSinkMappedFile sink, mapped from offset 0 to `capacity`.
+ */
+typedef struct {
+  int fd;                ///< File descriptor of the file (-1 if none)
+  char* data;            ///< Start of the mapping (nullptr if not mapped yet)
+  std::size_t capacity;  ///< Preallocated and mapped bytes
+} MappedFile;
+
+/**
+ * \struct FlightRecorder
+ *
+ * \brief Ring of a kSinkFlightRecorder sink. Positions count the bytes
+ * recorded since the sink was created, byte `pos` is kept at
+ * `data[pos & (size - 1)]` until it is overwritten.
+ */
+typedef struct {
+  std::unique_ptr<char[]> data;          ///< The ring (nullptr if none)
+  std::size_t size;                      ///< Size of the ring, a power of two
+  std::atomic<std::uint64_t> claimed;    ///< End of the claimed bytes
+  std::atomic<std::uint64_t> committed;  ///< End of the bytes copied in
+                                         ///< completely (advanced in claim
+                                         ///< order)
+  std::atomic<std::uint64_t> dumped;     ///< End of the bytes already dumped
+  int dump_log_level;                    ///< Lines of this level or below dump
+} FlightRecorder;
+
+/**
+ * \brief Hash of strings that also takes std::string_view, so a string table
+ * can be searched without building a std::string.
+ */
+struct StringViewHash {
+  using is_transparent = void;
+  std::size_t operator()(const std::string_view str) const {
+    return std::hash<std::string_view>{}(str);
+  }
+};
+
 /**
  * \struct Sink
  *
@@ -67,14 +148,352 @@ typedef struct {
   int fd;  ///< File descriptor, used for differenciating between cout and cerr
            ///< (-1 if not applicable)
   unsigned int id;  ///< id of the struct, used for validating handles
+  std::atomic<unsigned int>
+      users;  ///< Calls currently using the sink (see _AcquireSink)
+  std::mutex io_mutex;  ///< Guards write_buffer and writes to out
+  std::string write_buffer;  ///< fd sinks: output not yet written to the fd
+  LineIndex lines;  ///< Owned text files: recent newlines and the file size
+                    ///< (guarded by io_mutex)
+  MappedFile mapped;  ///< kSinkMappedFile: the mapping (guarded by io_mutex)
+  detail::UringFile*
+      uring;  ///< kSinkUringFile: the file (guarded by io_mutex, else nullptr)
+  SinkTeeChildren tee_children;  ///< kSinkTee: the children (fixed)
+  std::size_t tee_child_count;   ///< kSinkTee: number of children
+  FlightRecorder recorder;  ///< kSinkFlightRecorder: the ring (dumps guarded by
+                            ///< io_mutex, recording takes no lock)
+  SinkFlushPolicy flush_policy;  ///< When to flush (guarded by io_mutex)
+  std::size_t unflushed_bytes;   ///< Bytes written since the last flush
+                                 ///< (guarded by io_mutex)
+  bool unflushed_newline;  ///< A newline was written since the last flush
+                           ///< (guarded by io_mutex)
+  std::unordered_map<const void*, std::uint32_t>
+      binary_ids;  ///< kSinkBinary: format strings by the address they were
+                   ///< first interned from (fast path)
+  std::unordered_map<std::string, std::uint32_t, StringViewHash,
+                     std::equal_to<>>
+      binary_content_ids;  ///< kSinkBinary: interned strings by content
+  std::vector<std::string>
+      binary_strings;  ///< kSinkBinary: content of string id i + 1
 } Sink;
 
-std::vector<std::unique_ptr<Sink>> _sink_registry = {};
-std::vector<SinkHandle> _sink_free_handles = {};
-unsigned int _sink_handle_id_count = 0;
+/// Flush policy of new sinks: flushed at the end of every operation.
+constexpr SinkFlushPolicy kDefaultFlushPolicy = {true, false, 0, 0, 0};
+
+/// All sinks, preallocated. Destroyed sinks are reused by later sinks at the
+/// same index, so a resolved Sink* stays dereferenceable.
+detail::SlotMap<Sink, kMaxSinkHandles> _sink_registry;
 
 static std::mutex _sink_registry_mutex;
-static std::mutex _sink_id_count_mutex;
+
+/// Capabilities of the sink at the same index, packed so they can be read
+/// without the registry lock: bits 0-31 sink id (0 = no sink), 32-39 SinkType,
+/// bit 40 is_tty, 41 supports_escapes, 42 buffered, 44-63 fd + 1 (0 = none).
+std::array<std::atomic<std::uint64_t>, kMaxSinkHandles> _sink_capabilities = {};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+constexpr std::uint64_t kCapabilityTty = std::uint64_t{1} << 40;
+constexpr std::uint64_t kCapabilityEscapes = std::uint64_t{1} << 41;
+constexpr std::uint64_t kCapabilityBuffered = std::uint64_t{1} << 42;
+constexpr int kCapabilityFdShift = 44;
+constexpr int kCapabilityMaxFd = (1 << (64 - kCapabilityFdShift)) - 2;
+
+/**
+ * \brief Detects the capabilities of a freshly set up sink and publishes the
+ * sink for lock-free readers.
+ *
+ * Called by the Create* functions with the registry lock held, once all fields
+ * of the sink are set.
+ */
+void _PublishSink(const std::size_t idx, const Sink& sink) {
+  std::uint64_t word = sink.id;
+  word |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(sink.type))
+          << 32;
+  if (sink.fd >= 0 && ::isatty(sink.fd) != 0) {
+    // Terminals are the only outputs interpreting the cursor escapes.
+    word |= kCapabilityTty | kCapabilityEscapes;
+  }
+  if (sink.type == kSinkTee) {
+    // A tee has the capabilities of its terminal children (see SinkWrite).
+    constexpr std::uint64_t kInherited =
+        kCapabilityTty | kCapabilityEscapes | kCapabilityBuffered;
+    for (std::size_t i = 0; i < sink.tee_child_count; ++i) {
+      const std::size_t child_idx = sink.tee_children[i].sink.idx;
+      word |= _sink_capabilities[child_idx].load(std::memory_order_acquire) &
+              kInherited;
+    }
+  } else if (sink.type != kSinkMappedFile &&
+             sink.type != kSinkFlightRecorder) {
+    // fd sinks gather output in their write buffer, the others in an ostream
+    // or a partially filled io_uring buffer. Mapped files need no flush (see
+    // _FlushSink).
+    word |= kCapabilityBuffered;
+  }
+  if (sink.fd >= 0 && sink.fd <= kCapabilityMaxFd) {
+    word |= static_cast<std::uint64_t>(sink.fd + 1) << kCapabilityFdShift;
+  }
+  _sink_capabilities[idx].store(word, std::memory_order_release);
+  _sink_registry.Publish(idx, sink.id);
+}
+
+/**
+ * \brief Loads the capability word of a handle without taking a lock.
+ *
+ * \return true if the handle refers to a live sink (the word is only valid
+ * then).
+ */
+bool _LoadSinkCapabilities(const SinkHandle& sink_handle,
+                           std::uint64_t& word) {
+  if (!sink_handle.valid || sink_handle.id == 0 ||
+      sink_handle.idx >= kMaxSinkHandles) {
+    return false;
+  }
+  word = _sink_capabilities[sink_handle.idx].load(std::memory_order_acquire);
+  return static_cast<std::uint32_t>(word) == sink_handle.id;
+}
+
+SinkType _CapabilitySinkType(const std::uint64_t word) {
+  return static_cast<SinkType>(static_cast<std::uint8_t>(word >> 32));
+}
+
+/**
+ * \brief Drops a reference taken by _AcquireSink.
+ */
+struct SinkReleaser {
+  void operator()(Sink* sink) const {
+    sink->users.fetch_sub(1, std::memory_order_release);
+  }
+};
+
+/// A sink DestroySinkHandle will not tear down while the reference is held.
+typedef std::unique_ptr<Sink, SinkReleaser> SinkReference;
+
+/**
+ * \brief Resolves a handle to its sink without taking the registry lock.
+ *
+ * The returned reference keeps the sink alive: DestroySinkHandle first
+ * unpublishes the sink, then waits until no reference is left. The id is
+ * checked again after taking the reference, so either the destroying thread
+ * sees the reference or this thread sees the sink gone.
+ *
+ * \return The sink, or an empty reference if the handle is invalid.
+ */
+SinkReference _AcquireSink(const SinkHandle& sink_handle) {
+  if (_sink_registry.Validate(sink_handle) != kStatusbarLogSuccess) {
+    return SinkReference();
+  }
+  Sink* sink = &_sink_registry[sink_handle.idx];
+  sink->users.fetch_add(1, std::memory_order_seq_cst);
+  SinkReference reference(sink);
+  if (_sink_registry.Id(sink_handle.idx) != sink_handle.id) {
+    return SinkReference();
+  }
+  return reference;
+}
+
+/**
+ * \brief Returns true for sinks owning a text file, MoveCursorUp removes lines
+ * from their end.
+ */
+bool _IsTextFileSink(const SinkType type) {
+  return type == kSinkFileOwned || type == kSinkMappedFile ||
+         type == kSinkUringFile;
+}
+
+/**
+ * \brief Empties the line index of a file that is `size` bytes long. Unless
+ * the file is empty, its existing newlines are not known to the index.
+ */
+void _ResetLineIndex(LineIndex& index, const std::uint64_t size) {
+  index.head = 0;
+  index.count = 0;
+  index.size = size;
+  index.complete = (size == 0);
+}
+
+/**
+ * \brief Empties the line index of an owned file, taking the size from the
+ * file system.
+ */
+void _ResetLineIndexFromFile(LineIndex& index, const std::string& path) {
+  std::error_code ec;
+  const std::uintmax_t size = std::filesystem::file_size(path, ec);
+  _ResetLineIndex(index, ec ? 0 : size);
+  if (ec) index.complete = false;
+}
+
+/**
+ * \brief Records the newlines of output appended to an owned file. Once the
+ * ring is full the oldest offsets are dropped.
+ */
+void _IndexLines(LineIndex& index, const char* buf, const std::size_t len) {
+  const char* end = buf + len;
+  for (const char* p = buf;
+       (p = static_cast<const char*>(std::memchr(p, '\n', end - p)));
+       ++p) {
+    index.newlines[index.head] =
+        index.size + static_cast<std::uint64_t>(p - buf);
+    index.head = (index.head + 1) % kLineIndexSize;
+    if (index.count < kLineIndexSize) {
+      ++index.count;
+    } else {
+      index.complete = false;
+    }
+  }
+  index.size += len;
+}
+
+/**
+ * \brief Looks up the file size after removing the last `lines` newlines (and
+ * everything following them) and drops them from the index.
+ *
+ * \return false if the index does not reach back far enough, the index is
+ * unchanged then.
+ */
+bool _RemoveIndexedLines(LineIndex& index, const std::size_t lines,
+                         std::uint64_t& new_size) {
+  if (lines <= index.count) {
+    index.head = (index.head + kLineIndexSize - lines) % kLineIndexSize;
+    index.count -= lines;
+    new_size = index.newlines[index.head];
+  } else if (index.complete) {
+    // Fewer newlines than lines to remove, the file becomes empty.
+    index.head = 0;
+    index.count = 0;
+    new_size = 0;
+  } else {
+    return false;
+  }
+  index.size = new_size;
+  if (new_size == 0) index.complete = true;
+  return true;
+}
+
+/**
+ * \brief Finds the file size after removing the last `lines` newlines by
+ * scanning the file backwards. Used when the line index does not reach back
+ * far enough.
+ *
+ * \return false if the file could not be read.
+ */
+bool _ScanLinesBackwards(const std::string& path, int lines,
+                         std::uint64_t& new_size) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+
+  in.seekg(0, std::ios::end);
+  std::streamoff pos = in.tellg();
+  while (pos > 0 && lines > 0) {
+    --pos;
+    in.seekg(pos);
+    char c;
+    in.get(c);
+    if (!in) break;
+    if (c == '\n') {
+      --lines;
+    }
+  }
+  new_size = (pos > 0) ? static_cast<std::uint64_t>(pos) : 0;
+  return true;
+}
+
+/**
+ * \brief Makes a mapped file hold at least `needed` bytes, preallocating and
+ * mapping whole chunks (see kSinkMappedFileChunkSize).
+ *
+ * \return true on success, false if the file could not be grown or mapped
+ * (the old mapping stays valid then).
+ */
+bool _ReserveMappedFile(MappedFile& mapped, const std::uint64_t needed) {
+  if (needed <= mapped.capacity) return true;
+#ifdef _WIN32
+  return false;
+#else
+  const std::uint64_t chunks =
+      (needed + kSinkMappedFileChunkSize - 1) / kSinkMappedFileChunkSize;
+  const std::size_t capacity =
+      static_cast<std::size_t>(chunks * kSinkMappedFileChunkSize);
+  // Some file systems can't preallocate, growing the file (sparse) is enough
+  // for the mapping.
+  if (::posix_fallocate(mapped.fd, static_cast<off_t>(mapped.capacity),
+                        static_cast<off_t>(capacity - mapped.capacity)) != 0 &&
+      ::ftruncate(mapped.fd, static_cast<off_t>(capacity)) != 0) {
+    return false;
+  }
+
+  void* data;
+#if defined(MREMAP_MAYMOVE)
+  if (mapped.data) {
+    data = ::mremap(mapped.data, mapped.capacity, capacity, MREMAP_MAYMOVE);
+  } else {
+    data = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  mapped.fd, 0);
+  }
+#else
+  data = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+                mapped.fd, 0);
+  if (data != MAP_FAILED && mapped.data) {
+    ::munmap(mapped.data, mapped.capacity);
+  }
+#endif
+  if (data == MAP_FAILED) return false;
+  mapped.data = static_cast<char*>(data);
+  mapped.capacity = capacity;
+  return true;
+#endif
+}
+
+/**
+ * \brief Unmaps a mapped file and trims it to `size` bytes.
+ *
+ * \return true on success.
+ */
+bool _CloseMappedFile(MappedFile& mapped, const std::uint64_t size) {
+  bool ok = true;
+#ifndef _WIN32
+  if (mapped.data) ::munmap(mapped.data, mapped.capacity);
+  if (mapped.fd >= 0) {
+    ok = ::ftruncate(mapped.fd, static_cast<off_t>(size)) == 0;
+    ok = (::close(mapped.fd) == 0) && ok;
+  }
+#else
+  (void)size;
+#endif
+  mapped = {-1, nullptr, 0};
+  return ok;
+}
+
+/**
+ * \brief Appends output to the mapped file of a sink, growing the file first
+ * if needed. The caller holds the io mutex of the sink.
+ *
+ * \return true on success, false if the file could not be grown.
+ */
+bool _WriteMappedFile(Sink& sink, const char* buf, const std::size_t len) {
+  if (!_ReserveMappedFile(sink.mapped, sink.lines.size + len)) return false;
+  std::memcpy(sink.mapped.data + sink.lines.size, buf, len);
+  _IndexLines(sink.lines, buf, len);
+  return true;
+}
+
+/**
+ * \brief Finds the file size after removing the last `lines` newlines of a
+ * mapped file by scanning the mapping backwards. Used when the line index
+ * does not reach back far enough.
+ *
+ * \return false if the file could not be mapped.
+ */
+bool _ScanMappedLinesBackwards(Sink& sink, int lines,
+                               std::uint64_t& new_size) {
+  // Only a sink opened on a non-empty file may not have mapped it yet.
+  if (!_ReserveMappedFile(sink.mapped, sink.lines.size)) return false;
+  std::uint64_t pos = sink.lines.size;
+  while (pos > 0 && lines > 0) {
+    --pos;
+    if (sink.mapped.data[pos] == '\n') --lines;
+  }
+  new_size = pos;
+  return true;
+}
 
 /**
  * \brief Checks if a sink handle can be used for creating a new sink.
@@ -102,7 +521,12 @@ int _ValidateSinkCreation(SinkHandle& sink_handle) {
   sink_handle.valid = false;
   sink_handle.id = 0;
 
-  if (_sink_registry.size() - _sink_free_handles.size() >= kMaxSinkHandles) {
+  bool full;
+  {
+    std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
+    full = _sink_registry.active() >= kMaxSinkHandles;
+  }
+  if (full) {
     std::cout
         << "ERROR [" << kFilename << "]: "
         << "Failed to create sink handle. Maximum number of sink handles ("
@@ -113,26 +537,418 @@ int _ValidateSinkCreation(SinkHandle& sink_handle) {
   return kStatusbarLogSuccess;
 }
 
-}  // namespace
+/**
+ * \brief Sets up a free registry slot as a new sink and hands out its handle.
+ *
+ * Called by the Create* functions with the registry lock held.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * -2 if all sink slots are in use.
+ */
+int _InstallSink(SinkHandle& sink_handle, std::ostream* out,
+                 std::unique_ptr<std::ofstream> owned_file,
+                 const SinkType type, const std::string& path, const int fd,
+                 const MappedFile& mapped = {-1, nullptr, 0},
+                 detail::UringFile* uring = nullptr,
+                 const std::vector<SinkTeeChild>& tee_children = {},
+                 std::unique_ptr<char[]> ring = nullptr,
+                 const std::size_t ring_size = 0,
+                 const int dump_log_level = 0) {
+  std::size_t idx;
+  unsigned int id;
+  if (!_sink_registry.Claim(idx, id)) return -2;
+
+  Sink& sink = _sink_registry[idx];
+  sink.out = out;
+  sink.owned_file = std::move(owned_file);
+  sink.path = path;
+  sink.type = type;
+  sink.fd = fd;
+  sink.id = id;
+  sink.mapped = mapped;
+  sink.uring = uring;
+  sink.tee_child_count = tee_children.size();
+  std::copy(tee_children.begin(), tee_children.end(),
+            sink.tee_children.begin());
+  sink.recorder.data = std::move(ring);
+  sink.recorder.size = ring_size;
+  sink.recorder.claimed.store(0, std::memory_order_relaxed);
+  sink.recorder.committed.store(0, std::memory_order_relaxed);
+  sink.recorder.dumped.store(0, std::memory_order_relaxed);
+  sink.recorder.dump_log_level = dump_log_level;
+  sink.flush_policy = kDefaultFlushPolicy;
+  sink.unflushed_bytes = 0;
+  sink.unflushed_newline = false;
+  // Output is appended, so the index starts at the current end of the file.
+  if (_IsTextFileSink(type)) _ResetLineIndexFromFile(sink.lines, path);
+  _PublishSink(idx, sink);
+
+  sink_handle.idx = idx;
+  sink_handle.id = id;
+  sink_handle.valid = true;
+  return kStatusbarLogSuccess;
+}
 
-int IsValidSinkHandle(const SinkHandle& sink_handle) {
-  const std::size_t idx = sink_handle.idx;
+/**
+ * \brief Writes two buffers to a file descriptor with as few system calls as
+ * possible, retrying after interrupts and short writes.
+ *
+ * \return true on success, false if the fd reported an error.
+ */
+bool _WriteAllFd(const int fd, const char* head, const std::size_t head_len,
+                 const char* body, const std::size_t body_len) {
+#ifdef _WIN32
+  const char* parts[2] = {head, body};
+  std::size_t lens[2] = {head_len, body_len};
+  for (int i = 0; i < 2; ++i) {
+    while (lens[i] > 0) {
+      const int rc = ::write(fd, parts[i], static_cast<unsigned int>(lens[i]));
+      if (rc < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      parts[i] += rc;
+      lens[i] -= static_cast<std::size_t>(rc);
+    }
+  }
+  return true;
+#else
+  iovec iov[2];
+  int iovcnt = 0;
+  if (head_len > 0) iov[iovcnt++] = {const_cast<char*>(head), head_len};
+  if (body_len > 0) iov[iovcnt++] = {const_cast<char*>(body), body_len};
+  iovec* next = iov;
+  while (iovcnt > 0) {
+    const ssize_t rc = ::writev(fd, next, iovcnt);
+    if (rc < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    std::size_t done = static_cast<std::size_t>(rc);
+    while (iovcnt > 0 && done >= next->iov_len) {
+      done -= next->iov_len;
+      ++next;
+      --iovcnt;
+    }
+    if (iovcnt > 0) {
+      next->iov_base = static_cast<char*>(next->iov_base) + done;
+      next->iov_len -= done;
+    }
+  }
+  return true;
+#endif
+}
 
-  if (!sink_handle.valid) {
-    return -1;
+/**
+ * \brief Counts output written since the last flush, for the flush policy.
+ *
+ * The caller holds the io mutex of the sink.
+ */
+void _CountUnflushed(Sink& sink, const char* buf, const std::size_t len) {
+  sink.unflushed_bytes += len;
+  if (sink.flush_policy.on_newline && !sink.unflushed_newline &&
+      std::memchr(buf, '\n', len) != nullptr) {
+    sink.unflushed_newline = true;
   }
+}
 
-  if ((sink_handle.idx >= _sink_registry.size()) ||
-      (sink_handle.idx == SIZE_MAX)) {
-    return -2;
+/**
+ * \brief Forgets the output counted by _CountUnflushed, it is being flushed.
+ *
+ * The caller holds the io mutex of the sink.
+ */
+void _ResetUnflushed(Sink& sink) {
+  sink.unflushed_bytes = 0;
+  sink.unflushed_newline = false;
+}
+
+/**
+ * \brief Adds output to the write buffer of an fd sink. A full buffer is
+ * written out together with the new output in one system call.
+ *
+ * The caller holds the io mutex of the sink.
+ *
+ * \return true on success, false if writing to the fd failed.
+ */
+bool _BufferFdWrite(Sink& sink, const char* buf, const std::size_t len) {
+  _CountUnflushed(sink, buf, len);
+  if (sink.write_buffer.size() + len <= kSinkWriteBufferSize) {
+    sink.write_buffer.append(buf, len);
+    return true;
   }
-  if (sink_handle.id != _sink_registry[idx]->id) {
-    return -3;
+  const bool ok = _WriteAllFd(sink.fd, sink.write_buffer.data(),
+                              sink.write_buffer.size(), buf, len);
+  sink.write_buffer.clear();
+  return ok;
+}
+
+/**
+ * \brief Writes out the write buffer of an fd sink.
+ *
+ * \return true on success (or if there was nothing to write).
+ */
+bool _FlushFdBuffer(Sink& sink) {
+  std::lock_guard<std::mutex> io_lock(sink.io_mutex);
+  _ResetUnflushed(sink);
+  if (sink.write_buffer.empty()) return true;
+  const bool ok = _WriteAllFd(sink.fd, sink.write_buffer.data(),
+                              sink.write_buffer.size(), nullptr, 0);
+  sink.write_buffer.clear();
+  return ok;
+}
+
+/**
+ * \brief Copies output into the ring of a flight recorder without taking a
+ * lock. Output longer than the ring only keeps its end.
+ *
+ * The bytes are claimed with one atomic add and copied while other writers
+ * copy theirs. Committing them then waits for the writers that claimed bytes
+ * before, which are at most one copy away from committing.
+ */
+void _RecordFlightRecorder(FlightRecorder& recorder, const char* buf,
+                           std::size_t len) {
+  if (len > recorder.size) {
+    buf += len - recorder.size;
+    len = recorder.size;
   }
-  if (sink_handle.id == 0) {
-    return -4;
+  const std::uint64_t begin =
+      recorder.claimed.fetch_add(len, std::memory_order_relaxed);
+  // Pairs with the fence in _DumpFlightRecorder: a dump seeing these bytes
+  // also sees the claim, so it knows older bytes were overwritten.
+  std::atomic_thread_fence(std::memory_order_release);
+  const std::size_t offset =
+      static_cast<std::size_t>(begin) & (recorder.size - 1);
+  const std::size_t first = std::min(len, recorder.size - offset);
+  std::memcpy(recorder.data.get() + offset, buf, first);
+  std::memcpy(recorder.data.get(), buf + first, len - first);
+  while (recorder.committed.load(std::memory_order_acquire) != begin) {
+    std::this_thread::yield();
   }
-  return kStatusbarLogSuccess;
+  recorder.committed.store(begin + len, std::memory_order_release);
+}
+
+/**
+ * \brief Finds the recorded bytes not dumped yet, given the end of the
+ * recorded bytes.
+ *
+ * \return The first byte to dump. `lost` is set if older bytes were
+ * overwritten before they were dumped.
+ */
+std::uint64_t _FlightRecorderDumpBegin(const FlightRecorder& recorder,
+                                       const std::uint64_t end, bool& lost) {
+  const std::uint64_t begin = recorder.dumped.load(std::memory_order_relaxed);
+  lost = end - begin > recorder.size;
+  return lost ? end - recorder.size : begin;
+}
+
+/**
+ * \brief Appends the output recorded since the last dump to the dump file of
+ * a flight recorder.
+ *
+ * Dumps up to the committed bytes without waiting for writers, copying them
+ * out of the ring while writers carry on. Bytes overwritten before or during
+ * the copy are dropped together with the rest of their line. The caller holds
+ * the io mutex of the sink.
+ *
+ * \return true on success (or if there was nothing to dump).
+ */
+bool _DumpFlightRecorder(Sink& sink) {
+  FlightRecorder& recorder = sink.recorder;
+  const std::uint64_t end =
+      recorder.committed.load(std::memory_order_acquire);
+  bool lost;
+  const std::uint64_t begin = _FlightRecorderDumpBegin(recorder, end, lost);
+  if (begin == end) return true;
+
+  std::string staged(static_cast<std::size_t>(end - begin), '\0');
+  const std::size_t offset =
+      static_cast<std::size_t>(begin) & (recorder.size - 1);
+  const std::size_t first = std::min(staged.size(), recorder.size - offset);
+  std::memcpy(staged.data(), recorder.data.get() + offset, first);
+  std::memcpy(staged.data() + first, recorder.data.get(),
+              staged.size() - first);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const std::uint64_t claimed =
+      recorder.claimed.load(std::memory_order_relaxed);
+  const std::uint64_t ahead = claimed - begin;
+  const std::uint64_t overwritten =
+      ahead > recorder.size ? ahead - recorder.size : 0;
+  std::size_t skip = 0;
+  if (lost || overwritten > 0) {
+    // Start at the first line that is still complete.
+    const std::size_t from = static_cast<std::size_t>(
+        std::min<std::uint64_t>(overwritten, staged.size()));
+    const std::size_t newline = staged.find('\n', from);
+    skip = (newline == std::string::npos) ? staged.size() : newline + 1;
+  }
+
+  std::ofstream out(sink.path, std::ios::app | std::ios::binary);
+  out.write(staged.data() + skip,
+            static_cast<std::streamsize>(staged.size() - skip));
+  out.close();
+  if (!out.good()) return false;
+  recorder.dumped.store(end, std::memory_order_relaxed);
+  return true;
+}
+
+#ifndef _WIN32
+/// Signals dumping the flight recorders before the process dies.
+constexpr std::array<int, 5> kFatalSignals = {SIGSEGV, SIGBUS, SIGILL, SIGFPE,
+                                              SIGABRT};
+/// Actions installed for kFatalSignals before _InstallFatalSignalHandlers.
+std::array<struct sigaction, kFatalSignals.size()> _previous_fatal_actions;
+
+/**
+ * \brief Appends the output recorded since the last dump to the dump file,
+ * using async-signal-safe calls only.
+ *
+ * Does not wait for writers: lines not committed yet (e.g. by the thread
+ * that crashed) are left out, and the oldest bytes overwritten by writers
+ * running on other threads may come out garbled.
+ */
+void _DumpFlightRecorderFromSignal(const Sink& sink) {
+  const FlightRecorder& recorder = sink.recorder;
+  if (!recorder.data) return;
+  const std::uint64_t end = recorder.committed.load(std::memory_order_acquire);
+  bool lost;
+  std::uint64_t begin = _FlightRecorderDumpBegin(recorder, end, lost);
+  // Skip the line the overwritten bytes belonged to.
+  while (lost && begin != end &&
+         recorder.data[static_cast<std::size_t>(begin) &
+                       (recorder.size - 1)] != '\n') {
+    ++begin;
+  }
+  if (lost && begin != end) ++begin;
+  if (begin == end) return;
+
+  const int fd = ::open(sink.path.c_str(),
+                        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) return;
+  const std::size_t len = static_cast<std::size_t>(end - begin);
+  const std::size_t offset =
+      static_cast<std::size_t>(begin) & (recorder.size - 1);
+  const std::size_t first = std::min(len, recorder.size - offset);
+  _WriteAllFd(fd, recorder.data.get() + offset, first, recorder.data.get(),
+              len - first);
+  ::close(fd);
+}
+
+extern "C" void _HandleFatalSignal(int signal, siginfo_t* info, void*) {
+  for (std::size_t idx = 0; idx < kMaxSinkHandles; ++idx) {
+    const std::uint64_t word =
+        _sink_capabilities[idx].load(std::memory_order_acquire);
+    if (static_cast<std::uint32_t>(word) != 0 &&
+        _CapabilitySinkType(word) == kSinkFlightRecorder) {
+      _DumpFlightRecorderFromSignal(_sink_registry[idx]);
+    }
+  }
+  // The action installed before (by default terminating) handles the signal
+  // once this handler returns.
+  for (std::size_t i = 0; i < kFatalSignals.size(); ++i) {
+    if (kFatalSignals[i] == signal) {
+      sigaction(signal, &_previous_fatal_actions[i], nullptr);
+    }
+  }
+  // A fault raised by an instruction (si_code > 0) happens again when the
+  // instruction is restarted, and reaches that action with its real siginfo
+  // (e.g. the fault address for crash reporters). Only signals that were
+  // sent (abort, kill) have to be raised again.
+  if (signal == SIGABRT || info == nullptr || info->si_code <= 0) {
+    ::raise(signal);
+  }
+}
+
+/**
+ * \brief Installs the fatal signal handlers dumping the flight recorders
+ * (once).
+ */
+void _InstallFatalSignalHandlers() {
+  static std::once_flag installed;
+  std::call_once(installed, [] {
+    struct sigaction action {};
+    action.sa_sigaction = _HandleFatalSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO;
+    for (std::size_t i = 0; i < kFatalSignals.size(); ++i) {
+      sigaction(kFatalSignals[i], &action, &_previous_fatal_actions[i]);
+    }
+  });
+}
+#endif
+
+/**
+ * \brief Writes one framed record ("u8 kind, u32 length, payload") to a binary
+ * sink. The payload is given in two parts so callers need no extra copy.
+ *
+ * \return true on success.
+ */
+bool _WriteBinaryRecord(Sink& sink, const binary_log::RecordKind kind,
+                        const char* head, const std::size_t head_len,
+                        const char* body, const std::size_t body_len) {
+  char header[binary_log::kRecordHeaderLength];
+  header[0] = static_cast<char>(kind);
+  const std::uint32_t payload_len =
+      static_cast<std::uint32_t>(head_len + body_len);
+  std::memcpy(header + 1, &payload_len, sizeof(payload_len));
+
+  std::streambuf* sb = sink.out->rdbuf();
+  if (!sb) return false;
+  const std::streamsize header_len = sizeof(header);
+  return sb->sputn(header, header_len) == header_len &&
+         sb->sputn(head, static_cast<std::streamsize>(head_len)) ==
+             static_cast<std::streamsize>(head_len) &&
+         sb->sputn(body, static_cast<std::streamsize>(body_len)) ==
+             static_cast<std::streamsize>(body_len);
+}
+
+/**
+ * \brief Returns the id of a string in the string table of a binary sink.
+ *
+ * Strings are looked up by content, without copying them. With
+ * `cache_address` (format strings, usually literals) the address a string was
+ * first interned from is remembered and checked first, with the stored
+ * content compared. A buffer reused for different strings (e.g. the temporary
+ * std::string built from a literal filename) therefore maps each content to
+ * one id, however often the contents alternate, and adds no entries. New
+ * strings get their kRecordString definition written before the id is
+ * returned.
+ *
+ * \return The id (> 0) or 0 if writing the definition failed.
+ */
+std::uint32_t _InternBinaryString(Sink& sink, const char* str,
+                                  const std::size_t len,
+                                  const bool cache_address) {
+  if (cache_address) {
+    const auto it = sink.binary_ids.find(str);
+    if (it != sink.binary_ids.end()) {
+      const std::string& stored = sink.binary_strings[it->second - 1];
+      if (stored.size() == len && std::memcmp(stored.data(), str, len) == 0) {
+        return it->second;
+      }
+    }
+  }
+  const std::string_view content(str, len);
+  const auto by_content = sink.binary_content_ids.find(content);
+  if (by_content != sink.binary_content_ids.end()) return by_content->second;
+
+  const std::uint32_t id =
+      static_cast<std::uint32_t>(sink.binary_strings.size() + 1);
+  if (!_WriteBinaryRecord(sink, binary_log::kRecordString,
+                          reinterpret_cast<const char*>(&id), sizeof(id), str,
+                          len)) {
+    return 0;
+  }
+  sink.binary_strings.emplace_back(content);
+  sink.binary_content_ids.emplace(content, id);
+  if (cache_address) sink.binary_ids.emplace(str, id);
+  return id;
+}
+
+}  // namespace
+
+int IsValidSinkHandle(const SinkHandle& sink_handle) {
+  return _sink_registry.Validate(sink_handle);
 }
 
 int IsValidSinkHandleVerbose(const SinkHandle& sink_handle) {
@@ -149,7 +965,7 @@ int IsValidSinkHandleVerbose(const SinkHandle& sink_handle) {
     std::cout << "\033[999B\n";
     std::cout << "WARNING [" << kFilename
               << "]: Invalid sink handle: Handle index " << sink_handle.idx
-              << " out of bounds (max " << _sink_registry.size() << ")\n";
+              << " out of bounds (max " << kMaxSinkHandles << ")\n";
     return -2;
   }
 
@@ -158,7 +974,7 @@ int IsValidSinkHandleVerbose(const SinkHandle& sink_handle) {
     std::cout << "WARNING [" << kFilename
               << "]: " << "Invalid sink Handle: ID mismatch: handle "
               << sink_handle.id << " vs registry "
-              << _sink_registry[sink_handle.idx]->id;
+              << _sink_registry.Id(sink_handle.idx);
     return -3;
   }
 
@@ -185,69 +1001,191 @@ int IsValidSinkHandleVerbose(const SinkHandle& sink_handle) {
  * Function tries to flush a sink. Returns kStatusbarLogSuccess on success,
  * otherwise a negative integer
  *
+ * \param[in] wait Wait until the output reached the file. Only io_uring sinks
+ * can do without: flushes asked for by the flush policy just submit their
+ * output, only FlushSinkHandle (and destroying the sink) waits for the disk.
+ *
  *\returns Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
  * one of these error/warnings codes:
  *         - statusbar_log::kStatusbarLogSuccess (i.e. 0): Successfully flushed
  * sink.
  *         - -1: Failed: Sink ostream not functional.
  *         - -2: Failed: Sink ostream became not functional after flushing.
+ *         - -3: Failed: Writing the buffered output to the fd failed.
  */
-int _FlushSink(std::unique_ptr<Sink>& sink) {
-  // std::lock_guard<std::mutex> lk(sink->mutex);
-  if (sink->fd >= 0) {
+int _FlushSink(Sink& sink, const bool wait) {
+  // Writes to the mapping are visible to readers of the file right away.
+  // Flight recorders only write to disk when dumped.
+  if (sink.type == kSinkMappedFile || sink.type == kSinkFlightRecorder) {
     return kStatusbarLogSuccess;
   }
-  if (!sink->out->good()) return -1;
-  sink->out->flush();
-  return sink->out->good() ? 0 : -2;
+  if (sink.type == kSinkUringFile) {
+    std::lock_guard<std::mutex> io_lock(sink.io_mutex);
+    _ResetUnflushed(sink);
+    const bool ok = wait ? detail::UringFileFence(sink.uring)
+                         : detail::UringFileSubmit(sink.uring);
+    return ok ? kStatusbarLogSuccess : -3;
+  }
+  if (sink.type == kSinkTee) {
+    int err = kStatusbarLogSuccess;
+    for (std::size_t i = 0; i < sink.tee_child_count; ++i) {
+      // Children destroyed in the meantime are skipped.
+      const SinkHandle& child = sink.tee_children[i].sink;
+      if (IsValidSinkHandle(child) != kStatusbarLogSuccess) continue;
+      if (FlushSinkHandle(child) < -5) err = -3;
+    }
+    return err;
+  }
+  if (sink.fd >= 0) {
+    return _FlushFdBuffer(sink) ? kStatusbarLogSuccess : -3;
+  }
+  std::lock_guard<std::mutex> io_lock(sink.io_mutex);
+  _ResetUnflushed(sink);
+  if (!sink.out->good()) return -1;
+  sink.out->flush();
+  return sink.out->good() ? 0 : -2;
+}
+
+namespace {
+
+/**
+ * \struct TimedFlush
+ * \brief A sink flushed by the flush timer (SinkFlushPolicy::every_ms).
+ */
+typedef struct {
+  SinkHandle sink;                            ///< The sink (id 0: none)
+  std::chrono::milliseconds interval;         ///< Time between flushes
+  std::chrono::steady_clock::time_point due;  ///< Time of the next flush
+} TimedFlush;
+
+/**
+ * \struct FlushTimer
+ * \brief The thread doing the time based flushes of all sinks.
+ */
+// clang-format off
+typedef struct {
+  std::mutex mutex;                                  ///< Guards all members below.
+  std::condition_variable wake;                      ///< Signalled when a timed sink is added or on stop.
+  std::array<TimedFlush, kMaxSinkHandles> timed;     ///< Timed sink at each registry index.
+  bool stop;                                         ///< Set to make the thread exit.
+  std::thread thread;                                ///< The timer thread (joinable once started).
+} FlushTimer;
+// clang-format on
+
+/// Never destroyed; the thread is stopped at exit (_StopFlushTimer), before
+/// the sinks it flushes are.
+FlushTimer* const _flush_timer = new FlushTimer();
+
+/**
+ * \brief Flushes a sink if output was written since its last flush.
+ *
+ * \return false if the sink no longer exists.
+ */
+bool _FlushSinkIfPending(const SinkHandle& sink_handle) {
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) return false;
+  bool pending;
+  {
+    std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+    pending = sink->unflushed_bytes > 0;
+  }
+  if (pending) _FlushSink(*sink, false);
+  return true;
+}
+
+/**
+ * \brief Body of the flush timer thread: flushes every timed sink whose
+ * interval has passed, then sleeps until the next one is due.
+ */
+void _FlushTimerLoop(FlushTimer* timer) {
+  std::array<SinkHandle, kMaxSinkHandles> due;
+  std::unique_lock<std::mutex> lock(timer->mutex);
+  while (!timer->stop) {
+    const std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point next =
+        std::chrono::steady_clock::time_point::max();
+    std::size_t due_count = 0;
+    for (TimedFlush& entry : timer->timed) {
+      if (entry.sink.id == 0) continue;
+      if (entry.due <= now) {
+        due[due_count++] = entry.sink;
+        entry.due = now + entry.interval;
+      }
+      next = std::min(next, entry.due);
+    }
+
+    if (due_count > 0) {
+      lock.unlock();
+      std::array<bool, kMaxSinkHandles> gone;
+      for (std::size_t i = 0; i < due_count; ++i) {
+        gone[i] = !_FlushSinkIfPending(due[i]);
+      }
+      lock.lock();
+      // Sinks destroyed in the meantime leave the timer.
+      for (std::size_t i = 0; i < due_count; ++i) {
+        TimedFlush& entry = timer->timed[due[i].idx];
+        if (gone[i] && entry.sink.id == due[i].id) entry.sink.id = 0;
+      }
+      continue;
+    }
+    if (next == std::chrono::steady_clock::time_point::max()) {
+      timer->wake.wait(lock);
+    } else {
+      timer->wake.wait_until(lock, next);
+    }
+  }
+}
+
+void _StopFlushTimer() {
+  FlushTimer& timer = *_flush_timer;
+  {
+    std::lock_guard<std::mutex> lock(timer.mutex);
+    timer.stop = true;
+  }
+  timer.wake.notify_one();
+  if (timer.thread.joinable()) timer.thread.join();
+}
+
+/**
+ * \brief Adds a sink to the flush timer (interval 0 removes it), starting the
+ * timer thread on first use.
+ *
+ * \return false if the thread could not be started.
+ */
+bool _ScheduleTimedFlush(const SinkHandle& sink_handle,
+                         const unsigned int interval_ms) {
+  FlushTimer& timer = *_flush_timer;
+  std::lock_guard<std::mutex> lock(timer.mutex);
+  if (interval_ms > 0 && !timer.thread.joinable() && !timer.stop) {
+    try {
+      timer.thread = std::thread(_FlushTimerLoop, &timer);
+    } catch (...) {
+      return false;
+    }
+    std::atexit(_StopFlushTimer);
+  }
+  TimedFlush& entry = timer.timed[sink_handle.idx];
+  entry.sink = sink_handle;
+  if (interval_ms == 0) entry.sink.id = 0;
+  entry.interval = std::chrono::milliseconds(interval_ms);
+  entry.due = std::chrono::steady_clock::now() + entry.interval;
+  timer.wake.notify_one();
+  return true;
 }
 
+}  // namespace
+
 int CreateSinkStdout(SinkHandle& sink_handle) {
   const int err = _ValidateSinkCreation(sink_handle);
   if (err != kStatusbarLogSuccess) {
     return err;
   }
 
-  std::unique_lock<std::mutex> registry_lock(_sink_registry_mutex,
-                                             std::defer_lock);
-  std::unique_lock<std::mutex> id_count_lock(_sink_id_count_mutex,
-                                             std::defer_lock);
-  std::lock(registry_lock, id_count_lock);
-
-  _sink_handle_id_count++;
-  if (_sink_handle_id_count == 0) {
-    std::cout << "WARNING [" << kFilename
-              << "]: Max number of possible sink handle ids reached, looping "
-                 "back to 1\n";
-    _sink_handle_id_count++;
-  }
-
-  if (!_sink_free_handles.empty()) {
-    SinkHandle free_handle = _sink_free_handles.back();
-    _sink_free_handles.pop_back();
-    sink_handle.idx = free_handle.idx;
-    // std::mutex
-    _sink_registry[sink_handle.idx]->out = &std::cout;
-    _sink_registry[sink_handle.idx]->owned_file.reset();
-    _sink_registry[sink_handle.idx]->path.clear();
-    _sink_registry[sink_handle.idx]->type = kSinkStdout;
-    _sink_registry[sink_handle.idx]->fd = fileno(stdout);
-    _sink_registry[sink_handle.idx]->id = _sink_handle_id_count;
-  } else {
-    std::unique_ptr<Sink> new_sink = std::make_unique<Sink>();
-    sink_handle.idx = _sink_registry.size();
-    new_sink->out = &std::cout;
-    new_sink->owned_file.reset();
-    new_sink->path.clear();
-    new_sink->type = kSinkStdout;
-    new_sink->fd = fileno(stdout);
-    new_sink->id = _sink_handle_id_count;
-    _sink_registry.push_back(std::move(new_sink));
-  }
-  sink_handle.id = _sink_handle_id_count;
-  sink_handle.valid = true;
+  std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
 
-  return kStatusbarLogSuccess;
+  return _InstallSink(sink_handle, &std::cout, nullptr, kSinkStdout, "",
+                      fileno(stdout));
 }
 
 int CreateSinkFile(SinkHandle& sink_handle, const std::string path) {
@@ -256,18 +1194,7 @@ int CreateSinkFile(SinkHandle& sink_handle, const std::string path) {
     return err;
   }
 
-  std::unique_lock<std::mutex> registry_lock(_sink_registry_mutex,
-                                             std::defer_lock);
-  std::unique_lock<std::mutex> id_count_lock(_sink_id_count_mutex,
-                                             std::defer_lock);
-  std::lock(registry_lock, id_count_lock);
-
-  _sink_handle_id_count++;
-  if (_sink_handle_id_count == 0) {
-    std::cout << "WARNING [" << kFilename
-              << "]: Max number of possible sink handle ids reached, looping "
-                 "back to 1\n";
-  }
+  std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
 
   std::unique_ptr<std::ofstream> f;
   try {
@@ -279,32 +1206,9 @@ int CreateSinkFile(SinkHandle& sink_handle, const std::string path) {
     return -4;
   }
 
-  if (!_sink_free_handles.empty()) {
-    SinkHandle free_handle = _sink_free_handles.back();
-    _sink_free_handles.pop_back();
-    sink_handle.idx = free_handle.idx;
-    // std::mutex
-    _sink_registry[sink_handle.idx]->out = f.get();
-    _sink_registry[sink_handle.idx]->owned_file = std::move(f);
-    _sink_registry[sink_handle.idx]->path = path;
-    _sink_registry[sink_handle.idx]->type = kSinkFileOwned;
-    _sink_registry[sink_handle.idx]->fd = -1;
-    _sink_registry[sink_handle.idx]->id = _sink_handle_id_count;
-  } else {
-    std::unique_ptr<Sink> new_sink = std::make_unique<Sink>();
-    // std::mutex
-    new_sink->out = f.get();
-    new_sink->owned_file = std::move(f);
-    new_sink->path = path;
-    new_sink->type = kSinkFileOwned;
-    new_sink->fd = -1;
-    new_sink->id = _sink_handle_id_count;
-    _sink_registry.push_back(std::move(new_sink));
-  }
-  sink_handle.id = _sink_handle_id_count;
-  sink_handle.valid = true;
-
-  return kStatusbarLogSuccess;
+  std::ofstream* out = f.get();
+  return _InstallSink(sink_handle, out, std::move(f), kSinkFileOwned, path,
+                      -1);
 }
 
 int CreateSinkOstream(SinkHandle& sink_handle, std::ostream& os) {
@@ -313,18 +1217,7 @@ int CreateSinkOstream(SinkHandle& sink_handle, std::ostream& os) {
     return err;
   }
 
-  std::unique_lock<std::mutex> registry_lock(_sink_registry_mutex,
-                                             std::defer_lock);
-  std::unique_lock<std::mutex> id_count_lock(_sink_id_count_mutex,
-                                             std::defer_lock);
-  std::lock(registry_lock, id_count_lock);
-
-  _sink_handle_id_count++;
-  if (_sink_handle_id_count == 0) {
-    std::cout << "WARNING [" << kFilename
-              << "]: Max number of possible sink handle ids reached, looping "
-                 "back to 1\n";
-  }
+  std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
 
   int fd;
   if (&os == &std::cout) {
@@ -335,56 +1228,231 @@ int CreateSinkOstream(SinkHandle& sink_handle, std::ostream& os) {
     fd = -1;
   }
 
-  if (!_sink_free_handles.empty()) {
-    SinkHandle free_handle = _sink_free_handles.back();
-    _sink_free_handles.pop_back();
-    sink_handle.idx = free_handle.idx;
-    // std::mutex
-    _sink_registry[sink_handle.idx]->out = &os;
-    _sink_registry[sink_handle.idx]->owned_file.reset();
-    _sink_registry[sink_handle.idx]->path.clear();
-    _sink_registry[sink_handle.idx]->type = kSinkOstreamWrapped;
-    _sink_registry[sink_handle.idx]->fd = fd;
-    _sink_registry[sink_handle.idx]->id = _sink_handle_id_count;
-  } else {
-    std::unique_ptr<Sink> new_sink = std::make_unique<Sink>();
-    // std::mutex
-    new_sink->out = &os;
-    new_sink->owned_file.reset();
-    new_sink->path.clear();
-    new_sink->type = kSinkOstreamWrapped;
-    new_sink->fd = fd;
-    new_sink->id = _sink_handle_id_count;
-    _sink_registry.push_back(std::move(new_sink));
-  }
-  sink_handle.id = _sink_handle_id_count;
-  sink_handle.valid = true;
+  return _InstallSink(sink_handle, &os, nullptr, kSinkOstreamWrapped, "",
+                      fd);
+}
 
-  return kStatusbarLogSuccess;
+int CreateSinkBinary(SinkHandle& sink_handle, const std::string path) {
+  const int err = _ValidateSinkCreation(sink_handle);
+  if (err != kStatusbarLogSuccess) {
+    return err;
+  }
+
+  std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
+
+  std::unique_ptr<std::ofstream> f;
+  try {
+    f = std::make_unique<std::ofstream>(path,
+                                        std::ios::app | std::ios::binary);
+    if (!f->is_open() || !f->good()) {
+      return -3;
+    }
+  } catch (...) {
+    return -4;
+  }
+
+  // Appending to an existing binary log keeps its header. String ids restart
+  // at 1, the decoder takes the latest definition of an id.
+  std::error_code ec;
+  if (std::filesystem::file_size(path, ec) == 0 && !ec) {
+    char header[binary_log::kFileHeaderLength];
+    std::memcpy(header, binary_log::kMagic, sizeof(binary_log::kMagic));
+    std::memcpy(header + 4, &binary_log::kFormatVersion,
+                sizeof(binary_log::kFormatVersion));
+    std::memcpy(header + 6, &binary_log::kByteOrderMark,
+                sizeof(binary_log::kByteOrderMark));
+    f->write(header, sizeof(header));
+    if (!f->good()) {
+      return -5;
+    }
+  }
+
+  std::ofstream* out = f.get();
+  return _InstallSink(sink_handle, out, std::move(f), kSinkBinary, path, -1);
+}
+
+int CreateSinkMappedFile(SinkHandle& sink_handle, const std::string path) {
+#ifdef _WIN32
+  (void)sink_handle;
+  (void)path;
+  return -4;
+#else
+  const int err = _ValidateSinkCreation(sink_handle);
+  if (err != kStatusbarLogSuccess) {
+    return err;
+  }
+
+  std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
+
+  // The file is grown and mapped by the first write, until then it keeps its
+  // size, which the line index starts from.
+  MappedFile mapped = {::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644),
+                       nullptr, 0};
+  if (mapped.fd < 0) {
+    return -3;
+  }
+
+  const int install_err =
+      _InstallSink(sink_handle, nullptr, nullptr, kSinkMappedFile, path, -1,
+                   mapped);
+  if (install_err != kStatusbarLogSuccess) {
+    ::close(mapped.fd);
+  }
+  return install_err;
+#endif
+}
+
+int CreateSinkUringFile(SinkHandle& sink_handle, const std::string path) {
+  int err = _ValidateSinkCreation(sink_handle);
+  if (err != kStatusbarLogSuccess) {
+    return err;
+  }
+
+  detail::UringFile* uring = detail::OpenUringFile(path, err);
+  if (err == -1) {
+    // No io_uring (not Linux, old kernel or blocked), use a plain file sink.
+    return CreateSinkFile(sink_handle, path);
+  }
+  if (err != kStatusbarLogSuccess) {
+    return -3;
+  }
+
+  std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
+
+  const int install_err =
+      _InstallSink(sink_handle, nullptr, nullptr, kSinkUringFile, path, -1,
+                   {-1, nullptr, 0}, uring);
+  if (install_err != kStatusbarLogSuccess) {
+    detail::CloseUringFile(uring);
+  }
+  return install_err;
+}
+
+int CreateSinkTee(SinkHandle& sink_handle,
+                  const std::vector<SinkTeeChild>& children) {
+  const int err = _ValidateSinkCreation(sink_handle);
+  if (err != kStatusbarLogSuccess) {
+    return err;
+  }
+  if (children.empty() || children.size() > kMaxSinkTeeChildren) {
+    return -3;
+  }
+  for (const SinkTeeChild& child : children) {
+    std::uint64_t word;
+    if (!_LoadSinkCapabilities(child.sink, word)) return -4;
+    const SinkType type = _CapabilitySinkType(word);
+    if (type == kSinkBinary || type == kSinkTee) return -5;
+  }
+
+  std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
+
+  return _InstallSink(sink_handle, nullptr, nullptr, kSinkTee, "", -1,
+                      {-1, nullptr, 0}, nullptr, children);
+}
+
+int CreateSinkFlightRecorder(SinkHandle& sink_handle,
+                             const std::string dump_path,
+                             const std::size_t size,
+                             const int dump_log_level) {
+  const int err = _ValidateSinkCreation(sink_handle);
+  if (err != kStatusbarLogSuccess) {
+    return err;
+  }
+  // The ring size is rounded up to a power of two that has to fit.
+  if (size == 0 || size > (std::numeric_limits<std::size_t>::max() >> 1) + 1) {
+    return -3;
+  }
+  const std::size_t ring_size = std::bit_ceil(size);
+  // Not value-initialized: pages are only touched once output reaches them.
+  std::unique_ptr<char[]> ring;
+  try {
+    ring.reset(new char[ring_size]);
+  } catch (const std::bad_alloc&) {
+    return -3;
+  }
+
+#ifndef _WIN32
+  _InstallFatalSignalHandlers();
+#endif
+
+  std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
+
+  return _InstallSink(sink_handle, nullptr, nullptr, kSinkFlightRecorder,
+                      dump_path, -1, {-1, nullptr, 0}, nullptr, {},
+                      std::move(ring), ring_size, dump_log_level);
+}
+
+int DumpSinkFlightRecorder(const SinkHandle& sink_handle) {
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) {
+    const int err = IsValidSinkHandle(sink_handle);
+    return (err != kStatusbarLogSuccess) ? err : -3;
+  }
+  if (sink->type != kSinkFlightRecorder) return -5;
+
+  std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+  return _DumpFlightRecorder(*sink) ? kStatusbarLogSuccess : -6;
 }
 
 ssize_t SinkWrite(const SinkHandle& sink_handle, const char* buf,
                   std::size_t len) {
-  std::lock_guard<std::mutex> lx(_sink_registry_mutex);
   if (!buf) return -1;
 
-  if (!(IsValidSinkHandle(sink_handle) == kStatusbarLogSuccess)) return -2;
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) return -2;
 
-  std::unique_ptr<Sink>& sink = _sink_registry[sink_handle.idx];
+  // Binary sinks only take framed records (SinkWriteBinaryLog)
+  if (sink->type == kSinkBinary) return -8;
 
   if (len == 0) return kStatusbarLogSuccess;
 
-  if (!sink->out->good() && sink->fd < 0) return -3;
+  if (sink->type == kSinkFlightRecorder) {
+    _RecordFlightRecorder(sink->recorder, buf, len);
+    return static_cast<ssize_t>(len);
+  }
+
+  if (sink->type == kSinkMappedFile) {
+    std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+    if (!_WriteMappedFile(*sink, buf, len)) return -10;
+    return static_cast<ssize_t>(len);
+  }
+
+  if (sink->type == kSinkUringFile) {
+    std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+    if (!detail::UringFileWrite(sink->uring, buf, len)) return -11;
+    _IndexLines(sink->lines, buf, len);
+    _CountUnflushed(*sink, buf, len);
+    return static_cast<ssize_t>(len);
+  }
+
+  if (sink->type == kSinkTee) {
+    // Raw output (statusbars, escape sequences) is for terminals only.
+    for (std::size_t i = 0; i < sink->tee_child_count; ++i) {
+      const SinkHandle& child = sink->tee_children[i].sink;
+      std::uint64_t word;
+      if (!_LoadSinkCapabilities(child, word) ||
+          (word & kCapabilityEscapes) == 0) {
+        continue;
+      }
+      const ssize_t rc = SinkWrite(child, buf, len);
+      if (rc < 0 && IsValidSinkHandle(child) == kStatusbarLogSuccess) {
+        return rc;
+      }
+    }
+    return static_cast<ssize_t>(len);
+  }
 
   if (sink->fd >= 0) {
 #if defined(SSIZE_MAX)
     if (len > static_cast<std::size_t>(SSIZE_MAX)) return -2;
 #endif
-    ssize_t rc = ::write(sink->fd, buf, static_cast<size_t>(len));
-    return rc;
+    std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+    if (!_BufferFdWrite(*sink, buf, len)) return -9;
+    return static_cast<ssize_t>(len);
   }
 
-  if (!sink->out->good()) return -4;
+  std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+  if (!sink->out->good()) return -3;
 
   if (len >
       static_cast<std::size_t>(std::numeric_limits<std::streamsize>::max())) {
@@ -401,6 +1469,8 @@ ssize_t SinkWrite(const SinkHandle& sink_handle, const char* buf,
     sink->out->setstate(std::ios::failbit);
     return -7;
   }
+  if (sink->type == kSinkFileOwned) _IndexLines(sink->lines, buf, len);
+  _CountUnflushed(*sink, buf, len);
 
   return static_cast<ssize_t>(written);
 }
@@ -409,6 +1479,53 @@ ssize_t SinkWriteStr(const SinkHandle& sink_handle, const std::string& str) {
   return SinkWrite(sink_handle, str.c_str(), str.size());
 }
 
+int SinkWriteBinaryLog(const SinkHandle& sink_handle, const int log_level,
+                       const std::string& filename, const char* fmt,
+                       const char* args, const std::size_t args_len) {
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) {
+    const int err = IsValidSinkHandle(sink_handle);
+    return (err != kStatusbarLogSuccess) ? err : -3;
+  }
+  if (sink->type != kSinkBinary) return -6;
+  if (args_len > binary_log::kMaxArgsLength) return -7;
+
+  std::lock_guard<std::mutex> sink_lock(sink->mutex);
+  const std::uint32_t fmt_id =
+      _InternBinaryString(*sink, fmt, std::strlen(fmt), true);
+  const std::uint32_t file_id =
+      _InternBinaryString(*sink, filename.data(), filename.size(), false);
+  if (fmt_id == 0 || file_id == 0) return -8;
+
+  char head[9];
+  head[0] = static_cast<char>(log_level);
+  std::memcpy(head + 1, &fmt_id, sizeof(fmt_id));
+  std::memcpy(head + 5, &file_id, sizeof(file_id));
+  if (!_WriteBinaryRecord(*sink, binary_log::kRecordLog, head, sizeof(head),
+                          args, args_len)) {
+    sink->out->setstate(std::ios::failbit);
+    return -8;
+  }
+  return kStatusbarLogSuccess;
+}
+
+int SinkWriteFlightRecorderLog(const SinkHandle& sink_handle,
+                               const int log_level, const char* line,
+                               const std::size_t len) {
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) {
+    const int err = IsValidSinkHandle(sink_handle);
+    return (err != kStatusbarLogSuccess) ? err : -3;
+  }
+  if (sink->type != kSinkFlightRecorder) return -6;
+
+  _RecordFlightRecorder(sink->recorder, line, len);
+  if (log_level > sink->recorder.dump_log_level) return kStatusbarLogSuccess;
+
+  std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+  return _DumpFlightRecorder(*sink) ? kStatusbarLogSuccess : -8;
+}
+
 int DestroySinkHandle(SinkHandle& sink_handle) {
   int err = IsValidSinkHandleVerbose(sink_handle);
   if (err != kStatusbarLogSuccess) {
@@ -420,102 +1537,235 @@ int DestroySinkHandle(SinkHandle& sink_handle) {
   // std::unique_lock<std::mutex> sink_lock;
   // get_unique_lock(sink_handle, sink_lock);
   // std::lock(sink_lock, registry_lock);
-  std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
-
-  std::unique_ptr<Sink> target = std::move(_sink_registry[sink_handle.idx]);
+  {
+    std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
+    // Another thread destroyed the sink in the meantime.
+    if (IsValidSinkHandle(sink_handle) != kStatusbarLogSuccess) return -3;
+
+    // Unpublish the sink first, then wait for the writes still in flight (see
+    // _AcquireSink). The sink object itself stays, it is reused by the next
+    // sink created at this index.
+    _sink_capabilities[sink_handle.idx].store(0, std::memory_order_release);
+    _sink_registry.Unpublish(sink_handle.idx);
+  }
+  // The slot is not released yet, so no other sink can be created in it while
+  // a slow write (e.g. a uring fence or a recorder dump) is waited for without
+  // the registry lock.
+  Sink& target = _sink_registry[sink_handle.idx];
+  while (target.users.load(std::memory_order_seq_cst) != 0) {
+    std::this_thread::yield();
+  }
 
-  _FlushSink(target);
+  _FlushSink(target, true);
 
-  target->out = nullptr;
-  if (target->owned_file) {
-    target->owned_file->close();
-    if (!target->owned_file->good()) {
+  err = kStatusbarLogSuccess;
+  target.out = nullptr;
+  if (target.owned_file) {
+    target.owned_file->close();
+    if (!target.owned_file->good()) {
       // TODO: Error message (not sure if it will work here)
-      return -6;
+      err = -6;
     }
-    target->owned_file.reset();
+    target.owned_file.reset();
   }
-  target->type = kSinkInvalid;
-  target->fd = -1;
-  target->id = 0;
-
-  _sink_registry[sink_handle.idx] = std::move(target);
+  if (target.type == kSinkMappedFile &&
+      !_CloseMappedFile(target.mapped, target.lines.size)) {
+    err = -6;
+  }
+  if (target.uring) {
+    if (!detail::CloseUringFile(target.uring)) err = -6;
+    target.uring = nullptr;
+  }
+  target.tee_child_count = 0;
+  target.recorder.data.reset();
+  target.recorder.size = 0;
+  target.type = kSinkInvalid;
+  target.fd = -1;
+  target.id = 0;
+  target.write_buffer.clear();
+  target.binary_ids.clear();
+  target.binary_strings.clear();
+  target.binary_content_ids.clear();
 
+  {
+    std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
+    _sink_registry.Release(sink_handle.idx);
+  }
   sink_handle.valid = false;
   sink_handle.id = 0;
-  _sink_free_handles.push_back(sink_handle);
 
-  return kStatusbarLogSuccess;
+  return err;
 }
 
 bool SinkIsTty(const SinkHandle& sink_handle) {
-  std::lock_guard<std::mutex> lx(_sink_registry_mutex);
-  int err = IsValidSinkHandleVerbose(sink_handle);
-  if (err != kStatusbarLogSuccess) return false;
-
-  auto& sink = _sink_registry[sink_handle.idx];  // reference, no move
-  if (!sink) return false;
-
-  if (sink->fd >= 0) {
-    return ::isatty(sink->fd) != 0;
-  }
-  if (sink->out == &std::cout) {
-    return ::isatty(fileno(stdout));
+  std::uint64_t word;
+  if (!_LoadSinkCapabilities(sink_handle, word)) {
+    IsValidSinkHandleVerbose(sink_handle);
+    return false;
   }
-  if (sink->out == &std::cerr) {
-    return ::isatty(fileno(stderr));
+  return (word & kCapabilityTty) != 0;
+}
+
+int GetSinkCapabilities(const SinkHandle& sink_handle,
+                        SinkCapabilities& capabilities) {
+  std::uint64_t word;
+  if (!_LoadSinkCapabilities(sink_handle, word)) {
+    const int err = IsValidSinkHandle(sink_handle);
+    return (err != kStatusbarLogSuccess) ? err : -3;
   }
+  capabilities.type = _CapabilitySinkType(word);
+  capabilities.fd = static_cast<int>(word >> kCapabilityFdShift) - 1;
+  capabilities.is_tty = (word & kCapabilityTty) != 0;
+  capabilities.supports_escapes = (word & kCapabilityEscapes) != 0;
+  capabilities.buffered = (word & kCapabilityBuffered) != 0;
+  return kStatusbarLogSuccess;
+}
 
-  return false;
+int GetSinkTeeChildren(const SinkHandle& sink_handle,
+                       SinkTeeChildren& children, std::size_t& count) {
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) {
+    const int err = IsValidSinkHandle(sink_handle);
+    return (err != kStatusbarLogSuccess) ? err : -3;
+  }
+  if (sink->type != kSinkTee) return -5;
+  children = sink->tee_children;
+  count = sink->tee_child_count;
+  return kStatusbarLogSuccess;
 }
 
 int get_unique_lock(const SinkHandle& sink_handle,
                     std::unique_lock<std::mutex>& sink_lock) {
-  int err = IsValidSinkHandleVerbose(sink_handle);
+  std::mutex* sink_mutex_ptr = nullptr;
+  const int err = get_mutex_ptr(sink_handle, sink_mutex_ptr);
   if (err != kStatusbarLogSuccess) return err;
-  std::lock_guard<std::mutex> lx(_sink_registry_mutex);
-  sink_lock = std::unique_lock<std::mutex>(
-      _sink_registry[sink_handle.idx]->mutex, std::defer_lock);
+  sink_lock = std::unique_lock<std::mutex>(*sink_mutex_ptr, std::defer_lock);
   return kStatusbarLogSuccess;
 }
 
 int get_mutex_ptr(const SinkHandle& sink_handle, std::mutex*& sink_mutex_ptr) {
-  int err = IsValidSinkHandleVerbose(sink_handle);
-  if (err != kStatusbarLogSuccess) return err;
-  std::lock_guard<std::mutex> lx(_sink_registry_mutex);
-  sink_mutex_ptr = &_sink_registry[sink_handle.idx]->mutex;
-  return kStatusbarLogSuccess;
+  // Sinks are never freed, so the mutex outlives the check.
+  std::uint64_t word;
+  if (_LoadSinkCapabilities(sink_handle, word)) {
+    sink_mutex_ptr = &_sink_registry[sink_handle.idx].mutex;
+    return kStatusbarLogSuccess;
+  }
+  const int err = IsValidSinkHandleVerbose(sink_handle);
+  return (err != kStatusbarLogSuccess) ? err : -3;
 }
 
 int get_sink_type(const SinkHandle& sink_handle, SinkType& sink_type) {
-  int err = IsValidSinkHandleVerbose(sink_handle);
-  if (err != kStatusbarLogSuccess) return err;
-  std::lock_guard<std::mutex> lx(_sink_registry_mutex);
-  sink_type = _sink_registry[sink_handle.idx]->type;
-  return kStatusbarLogSuccess;
+  std::uint64_t word;
+  if (_LoadSinkCapabilities(sink_handle, word)) {
+    sink_type = _CapabilitySinkType(word);
+    return kStatusbarLogSuccess;
+  }
+  const int err = IsValidSinkHandleVerbose(sink_handle);
+  return (err != kStatusbarLogSuccess) ? err : -3;
 }
 
 int FlushSinkHandle(const SinkHandle& sink_handle) {
-  int err = IsValidSinkHandleVerbose(sink_handle);
-  if (err != kStatusbarLogSuccess) return err;
-  err = _FlushSink(_sink_registry[sink_handle.idx]);
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) {
+    const int err = IsValidSinkHandleVerbose(sink_handle);
+    return (err != kStatusbarLogSuccess) ? err : -3;
+  }
+  const int err = _FlushSink(*sink, true);
   if (err != kStatusbarLogSuccess) {
-    return err + 5;
+    return err - 5;
   }
   return kStatusbarLogSuccess;
 }
 
+int FlushSinkHandleIfDue(const SinkHandle& sink_handle, const int log_level) {
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) {
+    const int err = IsValidSinkHandleVerbose(sink_handle);
+    return (err != kStatusbarLogSuccess) ? err : -3;
+  }
+
+  if (sink->type == kSinkTee) {
+    int err = kStatusbarLogSuccess;
+    for (std::size_t i = 0; i < sink->tee_child_count; ++i) {
+      const SinkHandle& child = sink->tee_children[i].sink;
+      if (IsValidSinkHandle(child) != kStatusbarLogSuccess) continue;
+      const int child_err = FlushSinkHandleIfDue(child, log_level);
+      if (err == kStatusbarLogSuccess) err = child_err;
+    }
+    return err;
+  }
+
+  bool due;
+  {
+    std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+    const SinkFlushPolicy& policy = sink->flush_policy;
+    due = policy.every_write ||
+          (policy.on_newline && sink->unflushed_newline) ||
+          (policy.every_bytes > 0 &&
+           sink->unflushed_bytes >= policy.every_bytes) ||
+          (log_level > 0 && log_level <= policy.max_log_level);
+  }
+  if (!due) return kStatusbarLogSuccess;
+
+  const int err = _FlushSink(*sink, false);
+  return (err != kStatusbarLogSuccess) ? err - 5 : kStatusbarLogSuccess;
+}
+
+int SetSinkFlushPolicy(const SinkHandle& sink_handle,
+                       const SinkFlushPolicy& policy) {
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) {
+    const int err = IsValidSinkHandle(sink_handle);
+    return (err != kStatusbarLogSuccess) ? err : -3;
+  }
+  if (sink->type == kSinkTee) return -6;
+  {
+    std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+    sink->flush_policy = policy;
+  }
+  return _ScheduleTimedFlush(sink_handle, policy.every_ms)
+             ? kStatusbarLogSuccess
+             : -5;
+}
+
+int GetSinkFlushPolicy(const SinkHandle& sink_handle,
+                       SinkFlushPolicy& policy) {
+  const SinkReference sink = _AcquireSink(sink_handle);
+  if (!sink) {
+    const int err = IsValidSinkHandle(sink_handle);
+    return (err != kStatusbarLogSuccess) ? err : -3;
+  }
+  std::lock_guard<std::mutex> io_lock(sink->io_mutex);
+  policy = sink->flush_policy;
+  return kStatusbarLogSuccess;
+}
+
 int MoveCursorUp(const SinkHandle& sink_handle, int move) {
   if (move == 0) return kStatusbarLogSuccess;
 
-  {
-    std::lock_guard<std::mutex> registry_lock(_sink_registry_mutex);
-    int valid = IsValidSinkHandle(sink_handle);
-    if (valid != kStatusbarLogSuccess) return valid;
+  const SinkReference s = _AcquireSink(sink_handle);
+  if (!s) {
+    const int valid = IsValidSinkHandle(sink_handle);
+    return (valid != kStatusbarLogSuccess) ? valid : -6;
   }
 
-  Sink* s = _sink_registry[sink_handle.idx].get();
-  if (!s) return -6;
+  // Binary logs and flight recorders have no cursor, there is nothing to move.
+  if (s->type == kSinkBinary || s->type == kSinkFlightRecorder) {
+    return kStatusbarLogSuccess;
+  }
+
+  // Tees move the cursor of their terminals (see SinkWrite).
+  if (s->type == kSinkTee) {
+    for (std::size_t i = 0; i < s->tee_child_count; ++i) {
+      const SinkHandle& child = s->tee_children[i].sink;
+      std::uint64_t word;
+      if (_LoadSinkCapabilities(child, word) &&
+          (word & kCapabilityEscapes) != 0) {
+        MoveCursorUp(child, move);
+      }
+    }
+    return kStatusbarLogSuccess;
+  }
 
   // Case 1: we have an fd (covers stdout/stderr and any fd-backed sinks).
   if (s->fd >= 0) {
@@ -525,47 +1775,63 @@ int MoveCursorUp(const SinkHandle& sink_handle, int move) {
     } else {
       seq.assign(static_cast<size_t>(-move), '\n');  // move down -> newlines
     }
-    ssize_t rc = ::write(s->fd, seq.data(), seq.size());
-    return (rc < 0) ? -7 : kStatusbarLogSuccess;
+    std::lock_guard<std::mutex> io_lock(s->io_mutex);
+    return _BufferFdWrite(*s, seq.data(), seq.size()) ? kStatusbarLogSuccess
+                                                       : -7;
   }
 
-  // Case 2: sink owns a file (CreateSinkFile -> kSinkFileOwned).
-  if (s->type == kSinkFileOwned) {
-    if (move > 0) {
-      std::ofstream* file = s->owned_file.get();
-      (*file).flush();
-      std::ifstream in(s->path, std::ios::binary);
-      if (!in) return -8;
-
-      in.seekg(0, std::ios::end);
-      std::streamoff pos = in.tellg();
-      if (pos <= 0) {
-        return kStatusbarLogSuccess;
-      }
+  // Case 2: sink owns a text file (CreateSinkFile -> kSinkFileOwned,
+  // CreateSinkMappedFile -> kSinkMappedFile, CreateSinkUringFile ->
+  // kSinkUringFile). Moving up removes the last lines, found in the line index
+  // without reading the file.
+  if (_IsTextFileSink(s->type)) {
+    if (move < 0) {
+      const std::string buf(static_cast<std::size_t>(-move), '\n');
+      return (SinkWriteStr(sink_handle, buf) < 0) ? -7 : kStatusbarLogSuccess;
+    }
 
-      int lines_to_remove = move;
-      while (pos > 0 && lines_to_remove > 0) {
-        --pos;
-        in.seekg(pos);
-        char c;
-        in.get(c);
-        if (!in) break;
-        if (c == '\n') {
-          --lines_to_remove;
-        }
-      }
+    std::lock_guard<std::mutex> io_lock(s->io_mutex);
+    const bool mapped = (s->type == kSinkMappedFile);
+    const std::uint64_t old_size = s->lines.size;
+    if (s->type == kSinkFileOwned) s->owned_file->flush();
+    // The fallback scan reads the file, which needs the writes in flight.
+    if (s->type == kSinkUringFile && !detail::UringFileFence(s->uring)) {
+      return -7;
+    }
+    std::uint64_t new_size;
+    if (!_RemoveIndexedLines(s->lines, static_cast<std::size_t>(move),
+                             new_size)) {
+      const bool scanned =
+          mapped ? _ScanMappedLinesBackwards(*s, move, new_size)
+                 : _ScanLinesBackwards(s->path, move, new_size);
+      if (!scanned) return -8;
+      _ResetLineIndex(s->lines, new_size);
+    }
 
-      try {
-        std::filesystem::resize_file(
-            s->path, (pos > 0) ? static_cast<std::uintmax_t>(pos) : 0);
-      } catch (const std::exception&) {
-        return -9;
+    if (mapped) {
+      // The removed bytes read as the zeros of the preallocated rest again.
+      if (new_size < old_size) {
+        std::memset(s->mapped.data + new_size, 0,
+                    static_cast<std::size_t>(old_size - new_size));
       }
       return kStatusbarLogSuccess;
-    } else {
-      std::string buf(-move, '\n');
-      SinkWriteStr(sink_handle, buf);
     }
+    if (s->type == kSinkUringFile) {
+      if (detail::UringFileTruncate(s->uring, new_size)) {
+        return kStatusbarLogSuccess;
+      }
+      _ResetLineIndexFromFile(s->lines, s->path);
+      return -9;
+    }
+
+    std::error_code ec;
+    std::filesystem::resize_file(s->path, new_size, ec);
+    if (ec) {
+      // The file was not changed, the lines dropped from the index are lost.
+      _ResetLineIndexFromFile(s->lines, s->path);
+      return -9;
+    }
+    return kStatusbarLogSuccess;
   }
 
   // Case 3: wrapped ostream (kSinkOstreamWrapped or other non-fd)
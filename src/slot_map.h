@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/src/slot_map.h
+
+#ifndef STATUSBARLOG_SLOT_MAP_H_
+#define STATUSBARLOG_SLOT_MAP_H_
+
+// clang-format off
+
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+// clang-format on
+
+namespace statusbar_log {
+namespace detail {
+
+/**
+ * \class SlotMap
+ * \brief Fixed-capacity registry of `T` addressed by handles ({idx, id, valid},
+ * e.g. sink::SinkHandle and StatusbarHandle).
+ *
+ * All slots are allocated up front, so elements never move and creating or
+ * destroying never allocates. Free slots are kept on a stack, most recently
+ * freed first.
+ *
+ * The id of a handle encodes the slot index and a per-slot generation that is
+ * bumped on every Claim: `id = generation * Capacity + idx + 1`. Ids are
+ * therefore never 0, differ between slots and change when a slot is reused,
+ * so stale handles are detected.
+ *
+ * Claim, Publish, Unpublish and Release are serialized by the owner's registry
+ * mutex. Validate and Id take no lock.
+ */
+template <typename T, std::size_t Capacity>
+class SlotMap {
+  static_assert(Capacity > 0 && Capacity < UINT_MAX);
+
+ public:
+  /**
+   * \brief Takes a free slot (O(1)). The slot is invisible to Validate until
+   * it is published.
+   *
+   * \return false if all slots are in use.
+   */
+  bool Claim(std::size_t& idx, unsigned int& id) {
+    if (this->free_count_ > 0) {
+      idx = this->free_[--this->free_count_];
+    } else {
+      idx = this->high_water_.load(std::memory_order_relaxed);
+      if (idx >= Capacity) return false;
+      this->high_water_.store(idx + 1, std::memory_order_release);
+    }
+    this->generations_[idx] = (this->generations_[idx] + 1) % kMaxGeneration;
+    this->claimed_[idx] = true;
+    id = static_cast<unsigned int>(this->generations_[idx] * Capacity + idx +
+                                   1);
+    return true;
+  }
+
+  /// Makes a claimed slot valid for handles with `id`.
+  void Publish(const std::size_t idx, const unsigned int id) {
+    this->ids_[idx].store(id, std::memory_order_seq_cst);
+  }
+
+  /// Invalidates all handles to the slot (it stays claimed).
+  void Unpublish(const std::size_t idx) {
+    this->ids_[idx].store(0, std::memory_order_seq_cst);
+  }
+
+  /**
+   * \brief Returns an unpublished slot to the free stack (O(1)).
+   *
+   * \return false (and changes nothing) if the slot is already free.
+   */
+  bool Release(const std::size_t idx) {
+    if (idx >= this->size() || !this->claimed_[idx]) return false;
+    this->claimed_[idx] = false;
+    this->free_[this->free_count_++] = static_cast<std::uint32_t>(idx);
+    return true;
+  }
+
+  /**
+   * \brief Validates a handle without taking a lock.
+   *
+   * \return 0 if valid, or the codes shared by the handle validation
+   * functions:
+   *         - -1: Valid flag of handle set to false
+   *         - -2: Handle index out of bounds (never claimed)
+   *         - -3: Handle id doesn't match the slot (destroyed or reused)
+   *         - -4: Handle id is 0 (i.e. invalid)
+   */
+  template <typename Handle>
+  int Validate(const Handle& handle) const {
+    if (!handle.valid) return -1;
+    if (handle.idx >= this->size()) return -2;
+    if (handle.id != this->Id(handle.idx)) return -3;
+    if (handle.id == 0) return -4;
+    return 0;
+  }
+
+  /// Id a handle to the slot needs (0 if the slot is not published).
+  unsigned int Id(const std::size_t idx) const {
+    return this->ids_[idx].load(std::memory_order_seq_cst);
+  }
+
+  /// Number of slots in use (the caller holds the registry mutex).
+  std::size_t active() const { return this->size() - this->free_count_; }
+
+  /// Number of slots ever claimed, all indices below are safe to access.
+  std::size_t size() const {
+    return this->high_water_.load(std::memory_order_acquire);
+  }
+  bool empty() const { return this->size() == 0; }
+
+  T& operator[](const std::size_t idx) { return this->slots_[idx]; }
+  const T& operator[](const std::size_t idx) const { return this->slots_[idx]; }
+
+  /// Iterates the slots ever claimed (free slots included).
+  T* begin() { return this->slots_.data(); }
+  T* end() { return this->slots_.data() + this->size(); }
+
+ private:
+  static constexpr std::size_t kMaxGeneration = UINT_MAX / Capacity;
+
+  std::array<T, Capacity> slots_ = {};
+  std::array<std::atomic<unsigned int>, Capacity> ids_ = {};
+  std::array<std::size_t, Capacity> generations_ = {};
+  std::array<bool, Capacity> claimed_ = {};
+  std::array<std::uint32_t, Capacity> free_ = {};
+  std::size_t free_count_ = 0;
+  std::atomic<std::size_t> high_water_ = 0;
+};
+
+}  // namespace detail
+}  // namespace statusbar_log
+
+#endif  // STATUSBARLOG_SLOT_MAP_H_
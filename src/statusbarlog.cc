@@ -29,20 +29,32 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <csignal>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <ctime>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <ostream>
-#include <sstream>
-#include <iomanip>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "line_diff.h"
+#include "sanitize.h"
+#include "slot_map.h"
+#include "statusbarlog/binary_log.h"
 #include "statusbarlog/sink.h"
 
 // clang-format on
@@ -54,54 +66,418 @@ namespace statusbar_log {
 // Hidden implementation detail
 namespace {
 
+/**
+ * \struct BarLink
+ * \brief Link of a bar to its parent bar (see
+ * statusbar_log::SetStatusbarParent).
+ */
+// clang-format off
+typedef struct {
+  std::size_t slot_idx;  ///< Registry slot of the parent's statusbar.
+  unsigned int id;       ///< Id of the parent's statusbar (0 = no parent).
+  std::size_t bar_idx;   ///< Index of the parent bar.
+  double weight;         ///< Weight of the child among the parent's children.
+} BarLink;
+// clang-format on
+
+/// Longest line a bar can draw: prefix, bar, brackets, percentage and
+/// (expanded) postfix.
+constexpr std::size_t kMaxBarLineLength =
+    kMaxPrefixLength + kMaxBarWidth + kMaxPostfixLength + 16;
+static_assert(kMaxBarLineLength <= UINT16_MAX);
+
+/**
+ * \struct BarRecord
+ * \brief State of a single bar of a statusbar, kept in _bar_arena.
+ *
+ * Records have a fixed size; the prefix, the postfix and the line last drawn
+ * are stored inline (bounded by statusbar_log::kMaxPrefixLength,
+ * statusbar_log::kMaxPostfixLength and kMaxBarLineLength), so a statusbar
+ * needs no allocation of its own and drawing walks contiguous memory.
+ *
+ * The percentage of a bar with children is the weighted mean of its
+ * children's percentages. It is kept up to date incrementally: a changed
+ * child adds weight * change to `weighted_sum` of its parent, which passes
+ * its own change on to its parent (see _SetBarPercent).
+ */
+// clang-format off
+typedef struct {
+  double percent;                   ///< Progress percentage (0-100).
+  unsigned int position;            ///< Vertical position (1=topmost).
+  unsigned int bar_size;            ///< Total width (characters) of the bar.
+  std::size_t spin_idx;             ///< Spinner animation index.
+  BarLink parent;                   ///< Parent of the bar.
+  double child_weight;              ///< Summed weights of the children of the bar (0 = no children).
+  double weighted_sum;              ///< Summed weight * percentage of the children of the bar.
+  double rate;                      ///< EWMA of the percent per second.
+  double rate_percent;              ///< Percentage at the last rate sample.
+  std::int64_t rate_time;           ///< Coarse time (ns) of the last rate sample.
+  bool rate_known;                  ///< Whether the bar has a rate sample yet (no NaN under -ffast-math).
+  bool stale;                       ///< Whether the bar changed since it was last drawn.
+  std::uint16_t prefix_len;         ///< Length of `prefix`.
+  std::uint16_t postfix_len;        ///< Length of `postfix`.
+  std::uint16_t rendered_len;       ///< Length of `rendered` (0 = unknown, redraw fully).
+  char prefix[kMaxPrefixLength];    ///< Text displayed before the bar (sanitized).
+  char postfix[kMaxPostfixLength];  ///< Text displayed after the bar (sanitized).
+  char rendered[kMaxBarLineLength]; ///< Line last drawn for the bar.
+} BarRecord;
+// clang-format on
+
 /**
  * \struct Statusbar
  * \brief Represents a multi-component status bar with progress indicators.
  *
- * A status bar can contain multiple stacked bars, each with:
- * - Progress percentages (0-100) for each bar.
- * - Vertical positions (1=topmost).
- * - Total width (characters) of each bar.
- * - Text displayed before each bar.
- * - Text displayed after each bar.
- * - Spinner animation indices.
- * - Indicator whether error already has been reported
- * - unique id corresponding to the handle
+ * A status bar can contain multiple stacked bars. Their records (see
+ * BarRecord) are the `num_bars` consecutive records of _bar_arena starting
+ * at `first_bar`.
+ *
+ * The id of the handle is kept by the registry (see detail::SlotMap).
  */
 // clang-format off
 typedef struct {
-  sink::SinkHandle sink_handle;         ///< The sink in which to print the statusbar (for e.g. stdout).
-  std::vector<double> percentages;      ///< Progress percentages (0-100) for each bar.
-  std::vector<unsigned int> positions;  ///< Vertical positions (1=topmost).
-  std::vector<unsigned int> bar_sizes;  ///< Total width (characters) of each bar.
-  std::vector<std::string> prefixes;    ///< Text displayed before each bar.
-  std::vector<std::string> postfixes;   ///< Text displayed after each bar.
-  std::vector<std::size_t> spin_idxs;   ///< Spinner animation indices.
-  unsigned int id;                      ///< unique id corresponding to the handle
-  bool error_reported;                  ///< Indicator whether error already has been reported
+  sink::SinkHandle sink_handle;  ///< The sink in which to print the statusbar (for e.g. stdout).
+  std::size_t first_bar;         ///< Index of the first bar in _bar_arena.
+  std::size_t num_bars;          ///< Number of bars.
+  bool error_reported;           ///< Indicator whether error already has been reported
 } Statusbar;
 // clang-format on
 
 /**
  *
  */
-std::vector<Statusbar> _statusbar_registry = {};
-std::vector<StatusbarHandle> _statusbar_free_handles = {};
-unsigned int _statusbar_handle_id_count = 0;
+detail::SlotMap<Statusbar, kMaxStatusbarHandles> _statusbar_registry;
+
+/**
+ * Bars of all statusbars, in creation order. Creating a statusbar appends its
+ * bars, destroying one closes the gap (both under the registry lock).
+ */
+std::vector<BarRecord> _bar_arena;
 
 static std::mutex _statusbar_registry_mutex;
-static std::mutex _statusbar_id_count_mutex;
+
+/// Number of progress counters per bar (and of updater counts per statusbar).
+constexpr std::size_t kProgressShards = 16;
+
+/**
+ * \struct PaddedCounter
+ * \brief A counter on its own cache line, so threads updating neighbouring
+ * counters don't contend.
+ */
+typedef struct {
+  alignas(64) std::atomic<std::uint64_t> value;  ///< The count.
+} PaddedCounter;
+
+/**
+ * \struct LiveBar
+ * \brief Live state of a single bar (see LiveStatusbar).
+ */
+// clang-format off
+typedef struct {
+  std::atomic<double> percent;           ///< Latest percentage of the bar.
+  std::atomic<std::int64_t> updated_ns;  ///< Coarse time (ns) of the latest update of the bar.
+  std::atomic<bool> derived;             ///< Whether the bar has children (its percentage is not set).
+  std::uint64_t total;                   ///< Total of a bar counting progress, 0 for percentage bars.
+} LiveBar;
+// clang-format on
+
+/**
+ * \struct LiveStatusbar
+ * \brief Progress of a statusbar written without a lock by
+ * statusbar_log::UpdateStatusbar (when a render thread draws the bars, see
+ * statusbar_log::SetStatusbarRenderRate) and by
+ * statusbar_log::AddStatusbarProgress.
+ *
+ * Bars created with a total count progress in kProgressShards counters; each
+ * thread adds to the counter of its shard and the counters are only summed up
+ * when the bar is drawn. Lock-free updaters announce themselves in the `users`
+ * counter of their shard.
+ *
+ * Set up before the statusbar is published and torn down after it was
+ * unpublished and no updater uses it anymore, both under the registry lock.
+ * The per-bar arrays are kept for the next statusbar in the slot if they are
+ * large enough, so reusing a slot does not allocate. The values are copied
+ * into BarRecord::percent before drawing.
+ */
+// clang-format off
+typedef struct {
+  std::array<PaddedCounter, kProgressShards> users;  ///< Lock-free updaters currently accessing the slot, per shard.
+  std::unique_ptr<LiveBar[]> bars;                   ///< Live state of each bar.
+  std::unique_ptr<PaddedCounter[]> progress;         ///< kProgressShards progress counters per bar (nullptr until a bar has a total).
+  std::size_t bar_capacity;                          ///< Length of `bars`.
+  std::size_t progress_capacity;                     ///< Number of bars `progress` has counters for.
+  std::size_t num_bars;                              ///< Number of bars of the statusbar.
+  std::atomic<bool> dirty;                           ///< Set by updates not drawn yet.
+} LiveStatusbar;
+// clang-format on
+
+/// Live state of each slot of _statusbar_registry.
+std::array<LiveStatusbar, kMaxStatusbarHandles> _live_statusbars;
+
+/// Frames per second of the render thread, 0 draws in UpdateStatusbar.
+std::atomic<unsigned int> _render_rate_hz = 0;
+
+/**
+ * \brief Returns the shard of the calling thread (assigned round robin on
+ * first use).
+ */
+std::size_t _ProgressShard() {
+  static std::atomic<std::size_t> next_shard = 0;
+  thread_local const std::size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kProgressShards;
+  return shard;
+}
+
+/**
+ * \brief Latest percentage of a bar, summing up its progress counters for
+ * bars with a total (the caller holds the registry lock).
+ */
+double _LivePercent(const LiveStatusbar& live, const std::size_t bar_idx) {
+  const std::uint64_t total = live.bars[bar_idx].total;
+  if (total == 0) {
+    return live.bars[bar_idx].percent.load(std::memory_order_relaxed);
+  }
+  std::uint64_t done = 0;
+  const PaddedCounter* counters = &live.progress[bar_idx * kProgressShards];
+  for (std::size_t shard = 0; shard < kProgressShards; ++shard) {
+    // Pairs with AddStatusbarProgress, see there.
+    done += counters[shard].value.load(std::memory_order_seq_cst);
+  }
+  if (done >= total) return 100.0;
+  return 100.0 * static_cast<double>(done) / static_cast<double>(total);
+}
+
+/// Time constant of the rate EWMA: older samples fade by 1/e per period.
+constexpr double kRateTimeConstantSeconds = 3.0;
+
+/**
+ * \brief Reads a cheap monotonic clock with a resolution of a few
+ * milliseconds (CLOCK_MONOTONIC_COARSE is read from the vDSO without a
+ * system call).
+ */
+std::int64_t _CoarseNowNs() {
+#ifdef CLOCK_MONOTONIC_COARSE
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+  return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/**
+ * \brief Feeds the change of a bar to its rate EWMA (the caller holds the
+ * registry lock).
+ *
+ * Changes within the same clock tick are gathered into the next sample. The
+ * weight of a sample grows with the time it covers, so bursts of updates
+ * count as much as a single update covering the same time.
+ */
+void _SampleRate(BarRecord& bar, const double percent,
+                 const std::int64_t now_ns) {
+  const std::int64_t elapsed_ns = now_ns - bar.rate_time;
+  if (elapsed_ns <= 0) return;
+  const double elapsed = static_cast<double>(elapsed_ns) * 1e-9;
+  const double sample = (percent - bar.rate_percent) / elapsed;
+  if (!bar.rate_known) {
+    bar.rate = sample;
+    bar.rate_known = true;
+  } else {
+    bar.rate += (1.0 - std::exp(-elapsed / kRateTimeConstantSeconds)) *
+                (sample - bar.rate);
+  }
+  bar.rate_time = now_ns;
+  bar.rate_percent = percent;
+}
 
 /**
- * \brief Conditionally flushes the output based on
- * statusbar_log::kStatusbarLogNoAutoFlush setting
+ * \brief Record of bar `bar_idx` of the statusbar in slot `slot_idx` (the
+ * caller holds the registry lock).
  */
-void _ConditionalFlush(sink::SinkHandle sink_handle) {
-  if (!kStatusbarLogNoAutoFlush) {
-    sink::FlushSinkHandle(sink_handle);
+BarRecord& _Bar(const std::size_t slot_idx, const std::size_t bar_idx) {
+  return _bar_arena[_statusbar_registry[slot_idx].first_bar + bar_idx];
+}
+
+/**
+ * \brief Sets the percentage of a bar and updates its ancestors in O(depth),
+ * marking every changed bar stale and sampling their rates (the caller holds
+ * the registry lock).
+ *
+ * \param[in] now_ns Coarse time of the update (see _CoarseNowNs).
+ */
+void _SetBarPercent(std::size_t slot_idx, std::size_t bar_idx,
+                    const double percent, const std::int64_t now_ns) {
+  BarRecord* bar = &_Bar(slot_idx, bar_idx);
+  double change = percent - bar->percent;
+  if (change == 0.0) return;
+  _SampleRate(*bar, percent, now_ns);
+  bar->percent = percent;
+  bar->stale = true;
+
+  while (true) {
+    const BarLink link = bar->parent;
+    if (link.id == 0 || _statusbar_registry.Id(link.slot_idx) != link.id) {
+      return;
+    }
+    bar = &_Bar(link.slot_idx, link.bar_idx);
+    bar->weighted_sum += link.weight * change;
+    const double updated =
+        std::clamp(bar->weighted_sum / bar->child_weight, 0.0, 100.0);
+    change = updated - bar->percent;
+    if (change == 0.0) return;
+    _SampleRate(*bar, updated, now_ns);
+    bar->percent = updated;
+    bar->stale = true;
+  }
+}
+
+/**
+ * \brief Copies the latest percentages of the bars without children of a
+ * statusbar into BarRecord::percent, updating their ancestors (the caller
+ * holds the registry lock).
+ */
+void _SyncLivePercentages(const std::size_t slot_idx) {
+  const Statusbar& statusbar = _statusbar_registry[slot_idx];
+  const LiveStatusbar& live = _live_statusbars[slot_idx];
+  for (std::size_t j = 0; j < statusbar.num_bars; ++j) {
+    if (_bar_arena[statusbar.first_bar + j].child_weight > 0.0) continue;
+    _SetBarPercent(slot_idx, j, _LivePercent(live, j),
+                   live.bars[j].updated_ns.load(std::memory_order_relaxed));
+  }
+}
+
+/**
+ * \brief Rate of a bar in its own unit per second: counted units for bars
+ * with a total, percent otherwise (0 if unknown, see
+ * BarRecord::rate_known). The caller holds the registry lock.
+ */
+double _BarRate(const std::size_t slot_idx, const std::size_t bar_idx) {
+  const double rate = _Bar(slot_idx, bar_idx).rate;
+  const std::uint64_t total = _live_statusbars[slot_idx].bars[bar_idx].total;
+  return total > 0 ? rate * static_cast<double>(total) / 100.0 : rate;
+}
+
+/**
+ * \brief Estimated seconds until a bar reaches 100% (negative if unknown).
+ * The caller holds the registry lock.
+ */
+double _BarEtaSeconds(const BarRecord& bar) {
+  const double remaining = 100.0 - bar.percent;
+  if (remaining <= 0.0) return 0.0;
+  if (!bar.rate_known || bar.rate <= 0.0) return -1.0;
+  return remaining / bar.rate;
+}
+
+/**
+ * \brief Returns the postfix of a bar with its fields filled in: "{rate}"
+ * becomes the progress per second (e.g. "12.5/s" for bars with a total,
+ * "1.25%/s" otherwise) and "{eta}" the estimated time left ("MM:SS" or
+ * "H:MM:SS", "--:--" if unknown). The expanded postfix is cut to
+ * statusbar_log::kMaxPostfixLength bytes. The caller holds the registry
+ * lock.
+ *
+ * \param[out] buffer Holds the expanded postfix if it has fields.
+ *
+ * \return The postfix, or a view of `buffer`.
+ */
+std::string_view _ExpandPostfix(const std::size_t slot_idx,
+                                const std::size_t bar_idx,
+                                std::string& buffer) {
+  const BarRecord& bar = _Bar(slot_idx, bar_idx);
+  const std::string_view postfix(bar.postfix, bar.postfix_len);
+  if (postfix.find('{') == std::string_view::npos) return postfix;
+
+  static constexpr std::string_view kRateField = "{rate}";
+  static constexpr std::string_view kEtaField = "{eta}";
+  buffer.clear();
+  char field[32];
+  std::size_t pos = 0;
+  while (pos < postfix.size()) {
+    if (postfix.compare(pos, kRateField.size(), kRateField) == 0) {
+      const double rate = _BarRate(slot_idx, bar_idx);
+      const bool counted = _live_statusbars[slot_idx].bars[bar_idx].total > 0;
+      if (!bar.rate_known) {
+        buffer += counted ? "?/s" : "?%/s";
+      } else {
+        std::snprintf(field, sizeof(field), counted ? "%.1f/s" : "%.2f%%/s",
+                      rate);
+        buffer += field;
+      }
+      pos += kRateField.size();
+    } else if (postfix.compare(pos, kEtaField.size(), kEtaField) == 0) {
+      const double eta = _BarEtaSeconds(bar);
+      if (eta < 0.0 || eta >= 360000.0) {
+        buffer += "--:--";
+      } else {
+        const unsigned long seconds = static_cast<unsigned long>(eta + 0.5);
+        if (seconds >= 3600) {
+          std::snprintf(field, sizeof(field), "%lu:%02lu:%02lu", seconds / 3600,
+                        seconds / 60 % 60, seconds % 60);
+        } else {
+          std::snprintf(field, sizeof(field), "%02lu:%02lu", seconds / 60,
+                        seconds % 60);
+        }
+        buffer += field;
+      }
+      pos += kEtaField.size();
+    } else {
+      buffer += postfix[pos++];
+    }
+  }
+  // Keeps the drawn line within kMaxBarLineLength, without splitting a UTF-8
+  // sequence.
+  if (buffer.size() > kMaxPostfixLength) {
+    std::size_t len = kMaxPostfixLength;
+    while (len > 0 &&
+           (static_cast<unsigned char>(buffer[len]) & 0xC0) == 0x80) {
+      --len;
+    }
+    buffer.resize(len);
+  }
+  return buffer;
+}
+
+/**
+ * \brief Flushes a sink at the end of an operation if its flush policy asks
+ * for it (see statusbar_log::sink::SetSinkFlushPolicy).
+ *
+ * \param[in] log_level Level of the log line written, kLogLevelOff for other
+ * operations.
+ */
+void _ConditionalFlush(sink::SinkHandle sink_handle,
+                       const LogLevel log_level = kLogLevelOff) {
+  sink::FlushSinkHandleIfDue(sink_handle, log_level);
+}
+
+/**
+ * \brief Writes a cursor or line clearing escape sequence for a sink.
+ *
+ * Terminals get the sequence in their write buffer, so it stays in order with
+ * the rest of their output and goes out with the same system call. Tee sinks
+ * pass it to their terminals. Sinks that don't interpret escapes (files,
+ * pipes, binary logs, ...) drop it.
+ */
+void _WriteTerminalSequence(const sink::SinkHandle& sink_handle,
+                            const char* seq, const std::size_t len) {
+  sink::SinkCapabilities capabilities;
+  if (sink::GetSinkCapabilities(sink_handle, capabilities) ==
+          kStatusbarLogSuccess &&
+      capabilities.supports_escapes) {
+    sink::SinkWrite(sink_handle, seq, len);
   }
 }
 
+/// Returns to the start of the line and clears it.
+constexpr char kClearLineSeq[] = "\r\033[2K";
+
+/**
+ * \brief Returns to the start of the line and clears it (without flushing).
+ */
+void _ClearCurrentLine(const sink::SinkHandle& sink_handle) {
+  _WriteTerminalSequence(sink_handle, kClearLineSeq, sizeof(kClearLineSeq) - 1);
+}
+
 /**
  * \brief Gets terminal width in columns.
  *
@@ -135,50 +511,119 @@ int _GetTerminalWidth(int& width) {
   return kStatusbarLogSuccess;
 }
 
+/// Bumped on every terminal resize (SIGWINCH or NotifyTerminalResized).
+/// Lock-free, so it may be touched from the signal handler.
+std::atomic<std::uint32_t> _terminal_generation = 0;
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
 /**
- * \brief Sanitize string for use in log function or post- and prefixes
- * in statusbars
- *
- * \brief This functions replaces all control charachters except \n and \t
- * of an input string.
+ * \struct TerminalGeometry
+ * \brief Terminal width cached for one sink (guarded by the write lock of the
+ * sink).
  */
-std::string _SanitizeStringWithNewline(const std::string& input) {
-  std::string output;
-  output.reserve(input.size());
-  for (char c : input) {
-    // Allow for '\n' and '\t' charachters
-    if (c == '\n' || c == '\t' || (c >= 32 && c <= 126)) {
-      output += c;
-    } else if (static_cast<unsigned char>(c) < 32 || c == 127) {
-      output += "�";
-    } else {
-      output += c;
+// clang-format off
+typedef struct {
+  unsigned int sink_id;      ///< Id of the sink the entry belongs to (0 = empty).
+  std::uint32_t generation;  ///< _terminal_generation when the width was read.
+  int width;                 ///< Terminal width in columns.
+  int err;                   ///< Result of _GetTerminalWidth.
+} TerminalGeometry;
+// clang-format on
+
+std::array<TerminalGeometry, sink::kMaxSinkHandles> _terminal_geometry{};
+
+#ifndef _WIN32
+struct sigaction _previous_sigwinch_action;
+
+extern "C" void _HandleSigwinch(int signal, siginfo_t* info, void* context) {
+  _terminal_generation.fetch_add(1, std::memory_order_relaxed);
+  if (_previous_sigwinch_action.sa_flags & SA_SIGINFO) {
+    if (_previous_sigwinch_action.sa_sigaction != nullptr) {
+      _previous_sigwinch_action.sa_sigaction(signal, info, context);
     }
+  } else if (_previous_sigwinch_action.sa_handler != SIG_DFL &&
+             _previous_sigwinch_action.sa_handler != SIG_IGN) {
+    _previous_sigwinch_action.sa_handler(signal);
   }
-  return output;
 }
 
 /**
- * \brief Sanitize string for use in log function or post- and prefixes
- * in statusbars
+ * \brief Installs the SIGWINCH handler (once), keeping a previously installed
+ * handler working, whether it is a plain (sa_handler) or an SA_SIGINFO
+ * (sa_sigaction) one.
+ */
+void _InstallResizeHandler() {
+  static std::once_flag installed;
+  std::call_once(installed, [] {
+    struct sigaction action {};
+    action.sa_sigaction = _HandleSigwinch;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigaction(SIGWINCH, &action, &_previous_sigwinch_action);
+  });
+}
+#endif
+
+/**
+ * \brief Gets the terminal width of a TTY sink from the cache, reading it
+ * again only after a resize.
+ *
+ * The caller holds the write lock of the sink. On Windows, where there is no
+ * resize signal, the width is read on every call.
  *
- * \brief This functions replaces all control charachters except \t
- * of an input string.
+ * \param[out] width Receives terminal width. Defaults to 80 on failure.
+ * \param[out] resized True if the width was read again because the terminal
+ * was resized since the last call for this sink.
+ *
+ * \return Same codes as _GetTerminalWidth.
  */
-std::string _SanitizeString(const std::string& input) {
-  std::string output;
-  output.reserve(input.size());
-  for (char c : input) {
-    // Allow for '\n' and '\t' charachters
-    if (c == '\t' || (c >= 32 && c <= 126)) {
-      output += c;
-    } else if (static_cast<unsigned char>(c) < 32 || c == 127) {
-      output += "�";
-    } else {
-      output += c;
-    }
+int _CachedTerminalWidth(const sink::SinkHandle& sink_handle, int& width,
+                         bool& resized) {
+  resized = false;
+#ifdef _WIN32
+  return _GetTerminalWidth(width);
+#else
+  if (sink_handle.idx >= _terminal_geometry.size()) {
+    return _GetTerminalWidth(width);
   }
-  return output;
+  _InstallResizeHandler();
+  TerminalGeometry& geometry = _terminal_geometry[sink_handle.idx];
+  const std::uint32_t generation =
+      _terminal_generation.load(std::memory_order_relaxed);
+  if (geometry.sink_id != sink_handle.id ||
+      geometry.generation != generation) {
+    resized = geometry.sink_id == sink_handle.id;
+    geometry.sink_id = sink_handle.id;
+    geometry.generation = generation;
+    geometry.err = _GetTerminalWidth(geometry.width);
+  }
+  width = geometry.width;
+  return geometry.err;
+#endif
+}
+
+/**
+ * \brief Forgets the lines last drawn for all bars, so each is redrawn
+ * completely.
+ */
+void _InvalidateRenderedBars() {
+  for (BarRecord& bar : _bar_arena) bar.rendered_len = 0;
+}
+
+/**
+ * \brief Returns true (once per resize) if the terminal of a TTY sink was
+ * resized since its statusbars were last drawn. All cached bar lines are
+ * invalidated then.
+ *
+ * The caller holds the write lock of the sink and the registry lock.
+ */
+bool _CheckTerminalResized(const sink::SinkHandle& sink_handle) {
+  if (!sink::SinkIsTty(sink_handle)) return false;
+  int width;
+  bool resized;
+  _CachedTerminalWidth(sink_handle, width, resized);
+  if (resized) _InvalidateRenderedBars();
+  return resized;
 }
 
 /**
@@ -203,22 +648,7 @@ std::string _SanitizeString(const std::string& input) {
  * \see _IsValidHandleVerbose: Verbose version of this function
  */
 int _IsValidStatusbarHandle(const StatusbarHandle& statusbar_handle) {
-  const std::size_t idx = statusbar_handle.idx;
-
-  if (!statusbar_handle.valid) {
-    return -1;
-  }
-  if ((statusbar_handle.idx >= _statusbar_registry.size()) ||
-      (statusbar_handle.idx == SIZE_MAX)) {
-    return -2;
-  }
-  if (statusbar_handle.id != _statusbar_registry[idx].id) {
-    return -3;
-  }
-  if (statusbar_handle.id == 0) {
-    return -4;
-  }
-  return kStatusbarLogSuccess;
+  return _statusbar_registry.Validate(statusbar_handle);
 }
 
 /**
@@ -264,12 +694,10 @@ int _IsValidStatusbarHandleVerbose(const StatusbarHandle& statusbar_handle,
     return -2;
   }
 
-  Statusbar& target = _statusbar_registry[statusbar_handle.idx];
-
   if (is_valid_handle == -3) {
     LogWrn(kFilename, err_sink_handle,
            "Invalid Handle: ID mismatch: handle %u vs registry %u",
-           statusbar_handle.id, target.id);
+           statusbar_handle.id, _statusbar_registry.Id(statusbar_handle.idx));
     return -3;
   }
 
@@ -279,314 +707,1818 @@ int _IsValidStatusbarHandleVerbose(const StatusbarHandle& statusbar_handle,
     return -4;
   }
 
-  if (is_valid_handle != kStatusbarLogSuccess) {
-    LogWrn(kFilename, err_sink_handle,
-           "Invalid Handle: Errorcode not handled!");
-    return -5;
+  if (is_valid_handle != kStatusbarLogSuccess) {
+    LogWrn(kFilename, err_sink_handle,
+           "Invalid Handle: Errorcode not handled!");
+    return -5;
+  }
+
+  return kStatusbarLogSuccess;
+}
+
+/**
+ * \struct StatusbarFrame
+ * \brief Output of the bars drawn on one sink in one go, sent with a single
+ * sink::SinkWrite by _CommitFrame.
+ *
+ * The cursor moves, line clears and bar text of all bars are appended to
+ * `buffer`. The cursor goes from one bar straight to the next and only returns
+ * below the statusbars at the end of the frame.
+ *
+ * Only sinks that take cursor movement as plain output are composed: fd-backed
+ * sinks and tees (see _BeginFrame). Text file sinks emulate moving up by
+ * removing lines and get each bar written directly.
+ */
+// clang-format off
+typedef struct {
+  std::string buffer;  ///< Composed output not written yet.
+  unsigned int row;    ///< Lines the cursor is above the line below the statusbars (at the end of `buffer`).
+  bool composed;       ///< Whether output is composed in `buffer`, false writes bars directly.
+} StatusbarFrame;
+// clang-format on
+
+/**
+ * \brief Starts an empty frame on a sink (the caller holds the write lock of
+ * the sink).
+ */
+void _BeginFrame(const sink::SinkHandle& sink_handle, StatusbarFrame& frame) {
+  sink::SinkCapabilities capabilities;
+  frame.buffer.clear();
+  frame.row = 0;
+  // fd sinks and tees take the frame as one write, other sinks emulate the
+  // cursor movement per bar (see sink::MoveCursorUp).
+  frame.composed =
+      sink::GetSinkCapabilities(sink_handle, capabilities) ==
+          kStatusbarLogSuccess &&
+      (capabilities.fd >= 0 || capabilities.type == sink::kSinkTee);
+}
+
+/**
+ * \brief Appends the cursor movement to the line `row` lines above the line
+ * below the statusbars. Moving down writes newlines, like sink::MoveCursorUp.
+ */
+void _FrameMoveTo(StatusbarFrame& frame, const unsigned int row) {
+  if (row > frame.row) {
+    char seq[32];
+    const int len =
+        std::snprintf(seq, sizeof(seq), "\033[%uA", row - frame.row);
+    frame.buffer.append(seq, static_cast<std::size_t>(len));
+  } else if (row < frame.row) {
+    frame.buffer.append(frame.row - row, '\n');
+  }
+  frame.row = row;
+}
+
+/**
+ * \brief Moves the cursor of a frame back below the statusbars and writes the
+ * frame to the sink (the caller holds the write lock of the sink).
+ *
+ * \return statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or -8 if
+ * the sink write failed (the lines of all bars are redrawn completely next
+ * time).
+ */
+int _CommitFrame(const sink::SinkHandle& sink_handle, StatusbarFrame& frame) {
+  if (!frame.composed || frame.buffer.empty()) return kStatusbarLogSuccess;
+  _FrameMoveTo(frame, 0);
+  const ssize_t written =
+      sink::SinkWrite(sink_handle, frame.buffer.data(), frame.buffer.size());
+  frame.buffer.clear();
+  if (written <= 0) {
+    _InvalidateRenderedBars();
+    std::cout << "ERROR [" << kFilename << "]: "
+              << "Sink Write Failed in _CommitFrame!\n";
+    return -8;
+  }
+  return kStatusbarLogSuccess;
+}
+
+/**
+ * \brief Function used only by that StatusbarLog module to draw a single status
+ * bar at a certain position.
+ *
+ * This function draws a single status bar (not multiple stacked ones) from
+ * its record. The line is assembled on the stack.
+ *
+ * Example single statusbar:
+ * "prefix string"[########/       ] 50% "postfix string"
+ *
+ * the bar can be drawn at an arbitrary postion above or on the cursur using its
+ * `position`.
+ *
+ * \param[in] SinkHandle Struct to use for writing.
+ * \param[in] write_lock Unique lock of the sink to write to (should already be
+ * locked).
+ * \param[in, out] bar: The bar to draw. Its percentage, width, prefix,
+ * spinner index and position (vertical offset from the cursor, positive = up)
+ * are drawn. `rendered` holds the line last drawn for the bar, or is empty if
+ * the terminal line is unknown (e.g. after a log line moved the bars). If
+ * known and the sink is a terminal only the changed characters are written
+ * (see detail::AppendLineDiff).
+ * \param[in] postfix: Text after the bar (see _ExpandPostfix).
+ * \param[in, out] frame: Frame the bar is appended to (see StatusbarFrame).
+ * Sinks whose frame is not composed get the bar written directly.
+ *
+ * \details Using the spin_idx the spinner character can cycle through { |,
+ * /, -, \ } on each update.
+ *
+ * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
+ * one of these error/warning codes:
+ *         -  statusbar_log::kStatusbarLogSuccess (i.e. 0): Success (no errors)
+ *         - -1: Terminal width detection failed (Windows)
+ *         - -2: Terminal width detection failed (Linux)
+ *         - -3: Truncantion was needed (bar exeeds terminal width)
+ *         - -4: Both terminal width detection failed (Window) AND truncation
+ * was needed
+ *         - -5: Both terminal width detection failed (Linux) AND truncation was
+ *         - -6: Invalid percentage given
+ *         - -7: write_lock not owned (cannot print without write_lock owned)
+ *         - -8: Sink write failed (direct writes only, see _CommitFrame).
+ * needed
+ */
+int _DrawStatusbarComponent(const sink::SinkHandle& sink_handle,
+                            std::unique_lock<std::mutex>& write_lock,
+                            BarRecord& bar, const std::string_view postfix,
+                            StatusbarFrame& frame) {
+  if (!write_lock.owns_lock()) {
+    return -7;
+  }
+  const double percent = bar.percent;
+  if (percent > 100.0 || percent < 0.0) {
+    write_lock.unlock();
+
+    LogErr(kFilename, sink_handle,
+           "Failed to update statusbar: Invalid percentage.");
+    write_lock.lock();
+    return -5;
+  }
+
+  int err = kStatusbarLogSuccess;
+  static const std::array<char, 4> spinner = {'|', '/', '-', '\\'};
+  bar.spin_idx %= spinner.size();
+  char spin_char = spinner[bar.spin_idx];
+
+  const unsigned int bar_width = bar.bar_size;
+  const unsigned int fill =
+      std::floor((percent * static_cast<double>(bar_width)) / 100.0);
+  const unsigned int empty = bar_width - fill;
+
+  // Bounded by kMaxBarLineLength, see BarRecord.
+  char line[kMaxBarLineLength];
+  std::size_t len = 0;
+  std::memcpy(line, bar.prefix, bar.prefix_len);
+  len += bar.prefix_len;
+  line[len++] = '[';
+  std::memset(line + len, '#', fill);
+  len += fill;
+  if (empty > 0) {
+    line[len++] = spin_char;
+    std::memset(line + len, ' ', empty - 1);
+    len += empty - 1;
+  }
+  line[len++] = ']';
+  line[len++] = ' ';
+  len += static_cast<std::size_t>(
+      std::snprintf(line + len, kMaxBarLineLength - len, "%6.2f", percent));
+  const std::size_t postfix_len =
+      std::min(postfix.size(), kMaxBarLineLength - len);
+  std::memcpy(line + len, postfix.data(), postfix_len);
+  len += postfix_len;
+
+  const bool is_tty = sink::SinkIsTty(sink_handle);
+  int term_width;
+  if (is_tty) {
+    bool resized;
+    err = _CachedTerminalWidth(sink_handle, term_width, resized);
+    if (resized) bar.rendered_len = 0;
+  } else {
+    term_width = INT_MAX;
+  }
+
+  if (len > static_cast<size_t>(term_width)) {
+    // A width of 0 (e.g. a pty without a size) is unknown and cuts nothing.
+    if (term_width > 0) len = term_width - 1;
+    switch (err) {
+      case kStatusbarLogSuccess:
+        err = -3;
+        break;
+      case -1:
+        err = -4;
+        break;
+      case -2:
+        err = -5;
+        break;
+    }
+  }
+  const std::string_view status_str(line, len);
+
+  // Only terminals have a cursor to position, other sinks emulate moving up
+  // by removing lines and always get the full line.
+  const std::string_view rendered(bar.rendered, bar.rendered_len);
+  if (frame.composed) {
+    const std::size_t frame_len = frame.buffer.size();
+    const unsigned int frame_row = frame.row;
+    _FrameMoveTo(frame, bar.position);
+    const std::size_t moved_len = frame.buffer.size();
+    if (is_tty && !rendered.empty() &&
+        detail::AppendLineDiff(frame.buffer, rendered, status_str)) {
+      if (frame.buffer.size() == moved_len) {
+        // Unchanged, the cursor does not have to move there.
+        frame.buffer.resize(frame_len);
+        frame.row = frame_row;
+        return err;
+      }
+    } else {
+      frame.buffer.append(kClearLineSeq, sizeof(kClearLineSeq) - 1);
+      frame.buffer.append(status_str);
+    }
+    std::memcpy(bar.rendered, line, len);
+    bar.rendered_len = static_cast<std::uint16_t>(len);
+    return err;
+  }
+
+  const int move = static_cast<int>(bar.position);
+  std::string diff;
+  if (is_tty && !rendered.empty() &&
+      detail::AppendLineDiff(diff, rendered, status_str)) {
+    if (diff.empty()) return err;
+    sink::MoveCursorUp(sink_handle, move);
+    ssize_t written = sink::SinkWrite(sink_handle, diff.data(), diff.size());
+    if (written <= 0) {
+      bar.rendered_len = 0;
+      std::cout << "ERROR [" << kFilename << "]: "
+                << "Sink Write Failed in _DrawStatusbarComponent!\n";
+      return -8;
+    }
+  } else {
+    sink::MoveCursorUp(sink_handle, move);
+    _ClearCurrentLine(sink_handle);
+    ssize_t written = sink::SinkWrite(sink_handle, line, len);
+    if (written <= 0) {
+      bar.rendered_len = 0;
+      std::cout << "ERROR [" << kFilename << "]: "
+                << "Sink Write Failed in _DrawStatusbarComponent!\n";
+      return -8;
+    }
+  }
+  std::memcpy(bar.rendered, line, len);
+  bar.rendered_len = static_cast<std::uint16_t>(len);
+  sink::MoveCursorUp(sink_handle, -move);
+
+  return err;
+}
+
+}  // namespace
+
+void SaveCursorPosition(sink::SinkHandle sink_handle) {
+  // ANSI escape code to save cursor position
+  _WriteTerminalSequence(sink_handle, "\033[s", 3);
+  _ConditionalFlush(sink_handle);
+}
+
+void RestoreCursorPosition(sink::SinkHandle sink_handle) {
+  // ANSI escape code to restore cursor position
+  _WriteTerminalSequence(sink_handle, "\033[u", 3);
+  _ConditionalFlush(sink_handle);
+}
+
+void ClearToEndOfLine(sink::SinkHandle sink_handle) {
+  // ANSI escape code to clear to end of line
+  _WriteTerminalSequence(sink_handle, "\033[0K", 4);
+  _ConditionalFlush(sink_handle);
+}
+
+void ClearFromStartOfLine(sink::SinkHandle sink_handle) {
+  // ANSI escape code to clear from start of line
+  _WriteTerminalSequence(sink_handle, "\033[1K", 4);
+  _ConditionalFlush(sink_handle);
+}
+
+void ClearLine(sink::SinkHandle sink_handle) {
+  _WriteTerminalSequence(sink_handle, "\033[2K", 4);
+  _ConditionalFlush(sink_handle);
+}
+
+void ClearCurrentLine(sink::SinkHandle sink_handle) {
+  _ClearCurrentLine(sink_handle);
+  _ConditionalFlush(sink_handle);
+}
+
+namespace {
+
+/// Longest level prefix ("WARNING") plus the " [" and "]: " separators.
+constexpr std::size_t kLogLineOverhead = 16;
+
+/// Capacity of one asynchronous queue slot (a complete formatted log line).
+/// Lines only get cut if sanitizing expands the message beyond this.
+constexpr std::size_t kAsyncLineCapacity =
+    kLogLineOverhead + kMaxFilenameLength + kMaxLogLength + 64;
+
+/// Capacity of the thread-local buffer used by synchronous logging. Large
+/// enough for a message consisting entirely of replaced control characters,
+/// so synchronous lines are never cut.
+constexpr std::size_t kLogLineBufferCapacity =
+    kLogLineOverhead + kMaxFilenameLength +
+    detail::kReplacementCharLength * kMaxLogLength + 1;
+
+/**
+ * \struct AsyncLogSlot
+ * \brief One pre-allocated slot of the asynchronous log queue.
+ *
+ * The sequence number implements the bounded multi-producer queue by Dmitry
+ * Vyukov: a slot at position `pos` is free for producers when
+ * `sequence == pos` and holds a message for the writer when
+ * `sequence == pos + 1`.
+ */
+// clang-format off
+typedef struct {
+  std::atomic<std::size_t> sequence;  ///< Position bookkeeping (see above).
+  sink::SinkHandle sink_handle;       ///< The sink the line is written to.
+  LogLevel log_level;                 ///< Level of the line (picks the children of tee sinks).
+  std::size_t len;                    ///< Length of the formatted line.
+  char line[kAsyncLineCapacity];      ///< The formatted line ("PREFIX [file]: msg\n").
+} AsyncLogSlot;
+// clang-format on
+
+/**
+ * \struct AsyncLogger
+ * \brief State of the asynchronous logging backend (queue, counters and the
+ * writer thread).
+ */
+// clang-format off
+typedef struct {
+  std::unique_ptr<AsyncLogSlot[]> slots;                 ///< Ring of pre-allocated slots.
+  std::size_t mask;                                      ///< Number of slots minus one (power of two).
+  AsyncOverflowPolicy policy;                            ///< What to do when the queue is full.
+  alignas(64) std::atomic<std::size_t> enqueue_pos;      ///< Next position to be claimed by a producer.
+  alignas(64) std::atomic<std::size_t> dequeue_pos;      ///< Next position to be consumed.
+  alignas(64) std::atomic<std::uint64_t> completed;      ///< Positions written or dropped so far.
+  alignas(64) std::atomic<std::uint32_t> wake;           ///< Bumped to wake the sleeping writer thread.
+  std::atomic<bool> writer_sleeping;                     ///< True while the writer waits on `wake`.
+  std::atomic<bool> stop;                                ///< Set to make the writer drain and exit.
+  std::atomic<std::uint64_t> enqueued;                   ///< See AsyncLogStats.
+  std::atomic<std::uint64_t> written;                    ///< See AsyncLogStats.
+  std::atomic<std::uint64_t> failed;                     ///< See AsyncLogStats.
+  std::atomic<std::uint64_t> dropped_newest;             ///< See AsyncLogStats.
+  std::atomic<std::uint64_t> dropped_oldest;             ///< See AsyncLogStats.
+  std::thread writer;                                    ///< The writer thread.
+} AsyncLogger;
+// clang-format on
+
+/// Active asynchronous backend (nullptr while logging synchronously).
+std::atomic<AsyncLogger*> _async_logger = nullptr;
+/// Number of threads currently inside the asynchronous producer path.
+std::atomic<unsigned int> _async_producers = 0;
+/// Serializes StartAsyncLogging and StopAsyncLogging.
+static std::mutex _async_control_mutex;
+/// True on the writer thread, whose own log calls must not be queued.
+thread_local bool _is_async_writer_thread = false;
+
+/**
+ * \brief Returns the prefix printed in front of messages of the given level.
+ */
+const char* _LogLevelPrefix(const LogLevel log_level) {
+  // clang-format off
+  switch(log_level){
+    case kLogLevelErr: return "ERROR";
+    case kLogLevelWrn: return "WARNING";
+    case kLogLevelInf: return "INFO";
+    case kLogLevelDbg: return "DEBUG";
+    default: return "";
+  }
+  // clang-format on
+}
+
+/**
+ * \brief Writes the start of a log line ("PREFIX [filename]: ") to `out`
+ * without allocating.
+ *
+ * The filename is sanitized while it is copied and cut to
+ * statusbar_log::kMaxFilenameLength characters ("..." marks the cut).
+ *
+ * \param[out] out Buffer of at least kLogLineOverhead + kMaxFilenameLength
+ * bytes. Not NUL terminated.
+ *
+ * \return Number of bytes written.
+ */
+std::size_t _FormatLogLineHeader(char* out, const LogLevel log_level,
+                                 const std::string& filename) {
+  char* p = out;
+  const char* prefix = _LogLevelPrefix(log_level);
+  const std::size_t prefix_len = std::strlen(prefix);
+  std::memcpy(p, prefix, prefix_len);
+  p += prefix_len;
+  std::memcpy(p, " [", 2);
+  p += 2;
+
+  // Copy the clean runs between control characters in one go.
+  char* const filename_end = p + kMaxFilenameLength;
+  const char* src = filename.data();
+  const char* const src_end = src + filename.size();
+  bool filename_cut = false;
+  while (src < src_end) {
+    const std::size_t clean = detail::FindReplacedChar(
+        src, static_cast<std::size_t>(src_end - src), true);
+    const std::size_t room = static_cast<std::size_t>(filename_end - p);
+    if (clean > room) {
+      std::memcpy(p, src, room);
+      p = filename_end;
+      filename_cut = true;
+      break;
+    }
+    std::memcpy(p, src, clean);
+    p += clean;
+    src += clean;
+    if (src == src_end) break;
+
+    if (p + detail::kReplacementCharLength > filename_end) {
+      filename_cut = true;
+      break;
+    }
+    std::memcpy(p, detail::kReplacementChar, detail::kReplacementCharLength);
+    p += detail::kReplacementCharLength;
+    ++src;
+  }
+  if (filename_cut) {
+    p = filename_end - 3;
+    std::memcpy(p, "...", 3);
+    p += 3;
+  }
+  std::memcpy(p, "]: ", 3);
+  p += 3;
+  return static_cast<std::size_t>(p - out);
+}
+
+/**
+ * \brief Redraws every bar of every statusbar into a frame of a sink (the
+ * caller writes it with _CommitFrame).
+ *
+ * The caller holds the write lock of the sink and the lock of the statusbar
+ * registry.
+ *
+ * \return statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or the
+ * error code of _DrawStatusbarComponent minus 5 (-6 to -13) if a bar could not
+ * be drawn. Only critical errors are returned, once per statusbar.
+ */
+int _RedrawStatusbars(const sink::SinkHandle& sink_handle,
+                      std::unique_lock<std::mutex>& write_lock,
+                      StatusbarFrame& frame) {
+  _CheckTerminalResized(sink_handle);
+  // All first, a child may update the parent of an earlier statusbar.
+  for (std::size_t i = 0; i < _statusbar_registry.size(); ++i) {
+    if (_statusbar_registry.Id(i) != 0) _SyncLivePercentages(i);
+  }
+  std::string postfix;
+  for (std::size_t i = 0; i < _statusbar_registry.size(); ++i) {
+    Statusbar& statusbar = _statusbar_registry[i];
+    // The cached lines describe the statusbar's own sink only.
+    const bool own_sink = statusbar.sink_handle.idx == sink_handle.idx &&
+                          statusbar.sink_handle.id == sink_handle.id;
+    for (std::size_t j = 0; j < statusbar.num_bars; ++j) {
+      BarRecord& bar = _bar_arena[statusbar.first_bar + j];
+      if (!own_sink) bar.rendered_len = 0;
+      if (own_sink) bar.stale = false;
+      int bar_err_code = _DrawStatusbarComponent(
+          sink_handle, write_lock, bar, _ExpandPostfix(i, j, postfix), frame);
+      if (!own_sink) bar.rendered_len = 0;
+      if ((bar_err_code != kStatusbarLogSuccess) &&
+          !statusbar.error_reported) {
+        std::string why;
+        bool is_critical_error = false;
+        switch (bar_err_code) {
+          case -1:
+            is_critical_error = true;
+            why = "Terminal width detection failed (Windows)";
+            break;
+          case -2:
+            is_critical_error = true;
+            why = "Terminal width detection failed (Linux)";
+            break;
+          case -3:
+            is_critical_error = false;
+            why = "Truncantion was needed (bar exeeds terminal width)";
+            break;
+          case -4:
+            is_critical_error = true;
+            why =
+                "Both terminal width detection failed (Window) AND "
+                "truncation";
+            break;
+          case -5:
+            is_critical_error = true;
+            why = "Both terminal width detection failed (Linux) AND truncation";
+            break;
+          case -6:
+            is_critical_error = true;
+            why = "Invalid percentage given";
+            break;
+          default:
+            is_critical_error = true;
+            why = "Unknown _DrawStatusbarComponent error!";
+            break;
+        }
+        if (is_critical_error) {
+          statusbar.error_reported = true;
+          printf(
+              "ERROR [statusbarlog.cc]: LogV(...) failed updating "
+              "statusbar: %s on statusbar with ID %zu at bar idx %zu",
+              why.c_str(), i, j);
+          return bar_err_code - 5;
+        }
+      }
+    }
+  }
+  return kStatusbarLogSuccess;
+}
+
+/**
+ * \struct FrameScheduler
+ * \brief Statusbar redraws that were postponed to the next frame (see
+ * statusbar_log::SetStatusbarRedrawInterval) and the thread drawing them.
+ */
+// clang-format off
+typedef struct {
+  std::mutex mutex;                           ///< Guards all members below.
+  std::condition_variable wake;               ///< Signalled when a sink becomes dirty or on stop.
+  std::vector<sink::SinkHandle> dirty_sinks;  ///< Sinks whose statusbars wait for the next frame.
+  bool stop;                                  ///< Set to make the thread draw the pending frames and exit.
+  std::thread thread;                         ///< The scheduler thread (joinable while the interval is > 0).
+} FrameScheduler;
+// clang-format on
+
+/// Minimum time between two frames, 0 redraws after every log line.
+std::atomic<unsigned int> _redraw_interval_ms = 0;
+/// steady_clock time (ns) before which no frame is drawn.
+std::atomic<std::int64_t> _next_frame_ns = 0;
+/// Never destroyed; the thread is stopped at exit (_StopFrameScheduler),
+/// before the registries it draws from are.
+FrameScheduler* const _frame_scheduler = new FrameScheduler();
+/// Serializes SetStatusbarRedrawInterval.
+static std::mutex _frame_control_mutex;
+
+std::int64_t _SteadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * \brief Returns true (and starts a new frame) if the redraw interval has
+ * passed since the last frame.
+ */
+bool _TryStartFrame(const unsigned int interval_ms) {
+  const std::int64_t now = _SteadyNowNs();
+  std::int64_t next = _next_frame_ns.load(std::memory_order_relaxed);
+  if (now < next) return false;
+  const std::int64_t interval_ns =
+      static_cast<std::int64_t>(interval_ms) * 1000000;
+  return _next_frame_ns.compare_exchange_strong(next, now + interval_ns,
+                                                std::memory_order_relaxed);
+}
+
+/**
+ * \brief Postpones the statusbar redraw of a sink to the next frame.
+ */
+void _MarkFrameDirty(const sink::SinkHandle& sink_handle) {
+  FrameScheduler& scheduler = *_frame_scheduler;
+  std::lock_guard<std::mutex> lock(scheduler.mutex);
+  for (const sink::SinkHandle& dirty : scheduler.dirty_sinks) {
+    if (dirty.idx == sink_handle.idx && dirty.id == sink_handle.id) return;
+  }
+  scheduler.dirty_sinks.push_back(sink_handle);
+  if (scheduler.dirty_sinks.size() == 1) scheduler.wake.notify_one();
+}
+
+/**
+ * \brief Redraws the statusbars of a dirty sink. Sinks destroyed in the
+ * meantime are skipped.
+ */
+int _DrawFrame(const sink::SinkHandle& sink_handle) {
+  std::mutex* write_mutex_ptr = nullptr;
+  if (sink::get_mutex_ptr(sink_handle, write_mutex_ptr) !=
+      kStatusbarLogSuccess) {
+    return kStatusbarLogSuccess;
+  }
+  std::unique_lock<std::mutex> write_lock(*write_mutex_ptr, std::defer_lock);
+  std::unique_lock<std::mutex> registry_lock(_statusbar_registry_mutex,
+                                             std::defer_lock);
+  std::lock(write_lock, registry_lock);
+  StatusbarFrame frame;
+  _BeginFrame(sink_handle, frame);
+  int err = _RedrawStatusbars(sink_handle, write_lock, frame);
+  const int frame_err = _CommitFrame(sink_handle, frame);
+  if (err == kStatusbarLogSuccess && frame_err != kStatusbarLogSuccess) {
+    err = frame_err - 5;
+  }
+  _ConditionalFlush(sink_handle);
+  return err;
+}
+
+/**
+ * \brief Draws the pending frames of all dirty sinks.
+ *
+ * \return statusbar_log::kStatusbarLogSuccess (i.e. 0) or the first error of
+ * _RedrawStatusbars.
+ */
+int _DrawPendingFrames() {
+  std::vector<sink::SinkHandle> dirty_sinks;
+  {
+    std::lock_guard<std::mutex> lock(_frame_scheduler->mutex);
+    dirty_sinks.swap(_frame_scheduler->dirty_sinks);
+  }
+  int err = kStatusbarLogSuccess;
+  for (const sink::SinkHandle& sink_handle : dirty_sinks) {
+    const int frame_err = _DrawFrame(sink_handle);
+    if (err == kStatusbarLogSuccess) err = frame_err;
+  }
+  return err;
+}
+
+/**
+ * \brief Body of the scheduler thread: draws a frame for the dirty sinks once
+ * the redraw interval since the last frame has passed, i.e. at the latest one
+ * interval after a burst of log lines ended.
+ */
+void _FrameSchedulerLoop(FrameScheduler* scheduler) {
+  std::unique_lock<std::mutex> lock(scheduler->mutex);
+  while (true) {
+    scheduler->wake.wait(lock, [scheduler] {
+      return scheduler->stop || !scheduler->dirty_sinks.empty();
+    });
+    if (scheduler->stop) break;
+
+    const std::int64_t next = _next_frame_ns.load(std::memory_order_relaxed);
+    if (_SteadyNowNs() < next) {
+      scheduler->wake.wait_until(
+          lock, std::chrono::steady_clock::time_point(
+                    std::chrono::nanoseconds(next)));
+      continue;
+    }
+    _next_frame_ns.store(
+        _SteadyNowNs() +
+            static_cast<std::int64_t>(_redraw_interval_ms.load()) * 1000000,
+        std::memory_order_relaxed);
+
+    lock.unlock();
+    _DrawPendingFrames();
+    lock.lock();
+  }
+  lock.unlock();
+  _DrawPendingFrames();
+}
+
+/**
+ * \brief Stops the scheduler thread and draws the frames still pending
+ * (registered with std::atexit).
+ */
+void _StopFrameScheduler() {
+  FrameScheduler& scheduler = *_frame_scheduler;
+  if (scheduler.thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(scheduler.mutex);
+      scheduler.stop = true;
+    }
+    scheduler.wake.notify_one();
+    scheduler.thread.join();
+  }
+  // Lines that were marked dirty while the thread stopped.
+  _DrawPendingFrames();
+}
+
+/**
+ * \struct StatusbarRenderer
+ * \brief The render thread drawing updated statusbars at a fixed rate (see
+ * statusbar_log::SetStatusbarRenderRate).
+ */
+// clang-format off
+typedef struct {
+  std::mutex mutex;              ///< Guards `stop` and `thread`.
+  std::condition_variable wake;  ///< Signalled on stop.
+  bool stop;                     ///< Set to make the thread exit.
+  std::thread thread;            ///< The render thread (joinable while the rate is > 0).
+} StatusbarRenderer;
+// clang-format on
+
+/// Time the spinner of rendered bars takes for one step.
+constexpr std::int64_t kRenderSpinnerStepNs = 100000000;
+/// Never destroyed; the thread is stopped at exit (_StopStatusbarRenderer),
+/// before the registries it draws from are.
+StatusbarRenderer* const _statusbar_renderer = new StatusbarRenderer();
+/// Serializes SetStatusbarRenderRate.
+static std::mutex _render_control_mutex;
+
+/**
+ * \brief Draws the stale bars of a statusbar, i.e. the bars whose percentage
+ * changed since they were last drawn, into a frame of its sink. The caller
+ * holds the write lock of the statusbar's sink and the registry lock.
+ *
+ * \return statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or the
+ * error code of _DrawStatusbarComponent minus 5 (-6 to -13) if a bar could not
+ * be drawn. Errors are printed once per statusbar.
+ */
+int _RenderStatusbar(const std::size_t slot_idx,
+                     std::unique_lock<std::mutex>& write_lock,
+                     const std::size_t spin_idx, StatusbarFrame& frame) {
+  Statusbar& statusbar = _statusbar_registry[slot_idx];
+  // After a terminal resize all bars are redrawn once, completely.
+  if (_CheckTerminalResized(statusbar.sink_handle)) {
+    return _RedrawStatusbars(statusbar.sink_handle, write_lock, frame);
+  }
+
+  int err = kStatusbarLogSuccess;
+  std::string postfix;
+  for (std::size_t j = 0; j < statusbar.num_bars; ++j) {
+    BarRecord& bar = _bar_arena[statusbar.first_bar + j];
+    if (!bar.stale) continue;
+    bar.stale = false;
+    bar.spin_idx = spin_idx;
+    const int bar_err_code =
+        _DrawStatusbarComponent(statusbar.sink_handle, write_lock, bar,
+                                _ExpandPostfix(slot_idx, j, postfix), frame);
+    // Truncation (-3) is expected on narrow terminals.
+    if (bar_err_code != kStatusbarLogSuccess && bar_err_code != -3 &&
+        err == kStatusbarLogSuccess) {
+      err = bar_err_code - 5;
+      if (!statusbar.error_reported) {
+        statusbar.error_reported = true;
+        printf(
+            "ERROR [statusbarlog.cc]: Render thread failed drawing statusbar "
+            "with ID %u at bar idx %zu (error code %d)\n",
+            _statusbar_registry.Id(slot_idx), j, bar_err_code);
+      }
+    }
+  }
+  return err;
+}
+
+/**
+ * \brief Draws every statusbar updated since the last frame, together with
+ * the parents of the updated bars, in one write per sink. Statusbars and
+ * sinks destroyed in the meantime are skipped.
+ *
+ * \return statusbar_log::kStatusbarLogSuccess (i.e. 0) or the first error of
+ * _RenderStatusbar.
+ */
+int _RenderDirtyStatusbars() {
+  const std::size_t spin_idx =
+      static_cast<std::size_t>(_SteadyNowNs() / kRenderSpinnerStepNs);
+  // Statusbars with stale bars, found in one pass under the registry lock.
+  std::array<unsigned int, kMaxStatusbarHandles> stale_ids{};
+  std::array<sink::SinkHandle, kMaxStatusbarHandles> stale_sinks;
+  std::size_t num_slots;
+  {
+    std::lock_guard<std::mutex> registry_lock(_statusbar_registry_mutex);
+    num_slots = _statusbar_registry.size();
+    for (std::size_t i = 0; i < num_slots; ++i) {
+      if (_live_statusbars[i].dirty.exchange(false,
+                                             std::memory_order_seq_cst) &&
+          _statusbar_registry.Id(i) != 0) {
+        _SyncLivePercentages(i);
+      }
+    }
+    for (std::size_t i = 0; i < num_slots; ++i) {
+      const Statusbar& statusbar = _statusbar_registry[i];
+      const BarRecord* bars = _bar_arena.data() + statusbar.first_bar;
+      if (_statusbar_registry.Id(i) != 0 &&
+          std::any_of(bars, bars + statusbar.num_bars,
+                      [](const BarRecord& bar) { return bar.stale; })) {
+        stale_ids[i] = _statusbar_registry.Id(i);
+        stale_sinks[i] = statusbar.sink_handle;
+      }
+    }
+  }
+
+  int err = kStatusbarLogSuccess;
+  StatusbarFrame frame;
+  for (std::size_t i = 0; i < num_slots; ++i) {
+    if (stale_ids[i] == 0) continue;
+    const sink::SinkHandle sink_handle = stale_sinks[i];
+    std::mutex* write_mutex_ptr = nullptr;
+    if (sink::get_mutex_ptr(sink_handle, write_mutex_ptr) !=
+        kStatusbarLogSuccess) {
+      continue;
+    }
+    std::unique_lock<std::mutex> write_lock(*write_mutex_ptr, std::defer_lock);
+    std::unique_lock<std::mutex> registry_lock(_statusbar_registry_mutex,
+                                               std::defer_lock);
+    std::lock(write_lock, registry_lock);
+
+    // All statusbars of the sink go into one frame.
+    _BeginFrame(sink_handle, frame);
+    for (std::size_t k = i; k < num_slots; ++k) {
+      const unsigned int slot_id = stale_ids[k];
+      if (slot_id == 0 || stale_sinks[k].idx != sink_handle.idx ||
+          stale_sinks[k].id != sink_handle.id) {
+        continue;
+      }
+      stale_ids[k] = 0;
+      // Destroyed (and maybe reused) while no lock was held.
+      if (_statusbar_registry.Id(k) != slot_id) continue;
+      const int render_err = _RenderStatusbar(k, write_lock, spin_idx, frame);
+      if (err == kStatusbarLogSuccess) err = render_err;
+    }
+    const int frame_err = _CommitFrame(sink_handle, frame);
+    if (err == kStatusbarLogSuccess && frame_err != kStatusbarLogSuccess) {
+      err = frame_err - 5;
+    }
+    _ConditionalFlush(sink_handle);
+  }
+  return err;
+}
+
+/**
+ * \brief Draws the stale ancestors of a bar that share its sink into the
+ * frame of the bar, so a child update and its parents go out in the same
+ * write. The caller holds the write lock of the sink and the registry lock.
+ *
+ * \return true if ancestors on other sinks are stale (the caller draws them
+ * with _RenderDirtyStatusbars once it released its locks).
+ */
+bool _DrawStaleAncestors(std::size_t slot_idx, std::size_t bar_idx,
+                         std::unique_lock<std::mutex>& write_lock,
+                         StatusbarFrame& frame) {
+  const sink::SinkHandle sink_handle =
+      _statusbar_registry[slot_idx].sink_handle;
+  bool pending = false;
+  std::string postfix;
+  while (true) {
+    const BarLink link = _Bar(slot_idx, bar_idx).parent;
+    if (link.id == 0 || _statusbar_registry.Id(link.slot_idx) != link.id) {
+      return pending;
+    }
+    slot_idx = link.slot_idx;
+    bar_idx = link.bar_idx;
+    const sink::SinkHandle& parent_sink =
+        _statusbar_registry[slot_idx].sink_handle;
+    BarRecord& bar = _Bar(slot_idx, bar_idx);
+    if (!bar.stale) continue;
+    if (parent_sink.idx != sink_handle.idx ||
+        parent_sink.id != sink_handle.id) {
+      pending = true;
+      continue;
+    }
+    bar.stale = false;
+    bar.spin_idx = bar.spin_idx + 1;
+    // Errors are reported once the parent is redrawn after a log line.
+    _DrawStatusbarComponent(sink_handle, write_lock, bar,
+                            _ExpandPostfix(slot_idx, bar_idx, postfix), frame);
+  }
+}
+
+/**
+ * \brief Body of the render thread: draws the dirty statusbars once per
+ * frame. Frames missed while drawing are skipped, not caught up.
+ */
+void _StatusbarRenderLoop(StatusbarRenderer* renderer) {
+  std::unique_lock<std::mutex> lock(renderer->mutex);
+  std::chrono::steady_clock::time_point next_frame =
+      std::chrono::steady_clock::now();
+  while (!renderer->stop) {
+    const unsigned int rate_hz =
+        std::max(_render_rate_hz.load(std::memory_order_relaxed), 1u);
+    next_frame += std::chrono::nanoseconds(1000000000 / rate_hz);
+    next_frame = std::max(next_frame, std::chrono::steady_clock::now());
+    if (renderer->wake.wait_until(lock, next_frame,
+                                  [renderer] { return renderer->stop; })) {
+      break;
+    }
+    lock.unlock();
+    _RenderDirtyStatusbars();
+    lock.lock();
+  }
+}
+
+/**
+ * \brief Stops the render thread (registered with std::atexit).
+ */
+void _StopStatusbarRenderer() {
+  StatusbarRenderer& renderer = *_statusbar_renderer;
+  {
+    std::lock_guard<std::mutex> lock(renderer.mutex);
+    renderer.stop = true;
+  }
+  renderer.wake.notify_one();
+  if (renderer.thread.joinable()) renderer.thread.join();
+}
+
+/**
+ * \brief Writes a formatted log line to a sink and redraws the active
+ * statusbars below it.
+ *
+ * With a redraw interval (see statusbar_log::SetStatusbarRedrawInterval) the
+ * statusbars are only redrawn if the interval since the last frame has
+ * passed, otherwise the redraw is left to the next frame.
+ *
+ * Used by statusbar_log::LogV when logging synchronously and by the writer
+ * thread when logging asynchronously.
+ *
+ * \return Same codes as statusbar_log::LogV.
+ */
+int _WriteLogLine(const sink::SinkHandle& sink_handle,
+                  const LogLevel log_level, const char* line,
+                  const std::size_t len) {
+  std::mutex* write_mutex_ptr = nullptr;
+  int err = sink::get_mutex_ptr(sink_handle, write_mutex_ptr);
+  if (err != kStatusbarLogSuccess) return err;
+
+  std::unique_lock<std::mutex> write_lock(*write_mutex_ptr, std::defer_lock);
+  std::unique_lock<std::mutex> registry_lock(_statusbar_registry_mutex,
+                                             std::defer_lock);
+  std::lock(write_lock, registry_lock);
+
+  const bool statusbars_active = _statusbar_registry.active() > 0;
+
+  int move = 0;
+  if (statusbars_active) {
+    for (const BarRecord& bar : _bar_arena) {
+      int current_pos = bar.position;
+      if (current_pos > move) {
+        move = current_pos;
+      }
+    }
+  }
+
+  // With statusbars the line is composed into the frame of the redrawn bars.
+  StatusbarFrame frame{};
+  if (statusbars_active) _BeginFrame(sink_handle, frame);
+
+  static constexpr char kClearSeq[] = "\r\033[2K\r";
+  if (frame.composed) {
+    _FrameMoveTo(frame, move);
+    frame.buffer.append(kClearSeq, sizeof(kClearSeq) - 1);
+    frame.buffer.append(line, len);
+    // The line moved the cursor down by one, which leaves it `move` lines
+    // above the line below the statusbars again.
+  } else {
+    sink::MoveCursorUp(sink_handle, move);
+    if (statusbars_active) {
+      _WriteTerminalSequence(sink_handle, kClearSeq, sizeof(kClearSeq) - 1);
+    }
+
+    ssize_t written = sink::SinkWrite(sink_handle, line, len);
+    if (written <= 0) {
+      std::cout << "ERROR [" << kFilename << "]: "
+                << "Sink Write Failed in _WriteLogLine!\n";
+      return -6;
+    }
+
+    sink::MoveCursorUp(sink_handle, -move);
+  }
+
+  if (statusbars_active) {
+    // The line scrolled the bars, their terminal lines are unknown now.
+    _InvalidateRenderedBars();
+    const unsigned int interval_ms =
+        _redraw_interval_ms.load(std::memory_order_relaxed);
+    if (interval_ms == 0 || _TryStartFrame(interval_ms)) {
+      err = _RedrawStatusbars(sink_handle, write_lock, frame);
+    } else {
+      _MarkFrameDirty(sink_handle);
+    }
+  }
+  if (_CommitFrame(sink_handle, frame) != kStatusbarLogSuccess &&
+      err == kStatusbarLogSuccess) {
+    err = -6;
+  }
+
+  // The line and the redrawn statusbars leave in one write.
+  _ConditionalFlush(sink_handle, log_level);
+  write_lock.unlock();
+  registry_lock.unlock();
+  return err;
+}
+
+/**
+ * \brief Writes a formatted log line to a sink that is not a terminal, without
+ * touching the statusbars.
+ *
+ * \return Same codes as statusbar_log::LogV.
+ */
+int _WritePlainLogLine(const sink::SinkHandle& sink_handle,
+                       const LogLevel log_level, const char* line,
+                       const std::size_t len) {
+  std::unique_lock<std::mutex> write_lock;
+  const int err = sink::get_unique_lock(sink_handle, write_lock);
+  if (err != kStatusbarLogSuccess) return err;
+  write_lock.lock();
+
+  if (sink::SinkWrite(sink_handle, line, len) <= 0) {
+    std::cout << "ERROR [" << kFilename << "]: "
+              << "Sink Write Failed in _WritePlainLogLine!\n";
+    return -6;
+  }
+  _ConditionalFlush(sink_handle, log_level);
+  return kStatusbarLogSuccess;
+}
+
+/**
+ * \brief Records a formatted log line on a flight recorder sink, dumping it if
+ * the level asks for it. Takes no lock, recorders never draw statusbars.
+ *
+ * \return Same codes as statusbar_log::LogV.
+ */
+int _WriteFlightRecorderLogLine(const sink::SinkHandle& sink_handle,
+                                const LogLevel log_level, const char* line,
+                                const std::size_t len) {
+  const int err =
+      sink::SinkWriteFlightRecorderLog(sink_handle, log_level, line, len);
+  if (err < -5) {
+    std::cout << "ERROR [" << kFilename << "]: "
+              << "Flight recorder failed in _WriteFlightRecorderLogLine!\n";
+    return -6;
+  }
+  return err;
+}
+
+/**
+ * \brief Hands a formatted log line to the children of a tee sink.
+ *
+ * Terminal children get the line like a direct log call (statusbars redrawn
+ * below it), flight recorders record it, all others get the plain line.
+ * Children whose level threshold is below `log_level` and children destroyed
+ * in the meantime are skipped.
+ *
+ * \return Same codes as statusbar_log::LogV (the first error of a child).
+ */
+int _WriteTeeLogLine(const sink::SinkHandle& sink_handle,
+                     const LogLevel log_level, const char* line,
+                     const std::size_t len) {
+  sink::SinkTeeChildren children;
+  std::size_t count = 0;
+  int err = sink::GetSinkTeeChildren(sink_handle, children, count);
+  if (err != kStatusbarLogSuccess) return err;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    if (log_level > children[i].max_log_level) continue;
+    sink::SinkCapabilities capabilities;
+    if (sink::GetSinkCapabilities(children[i].sink, capabilities) !=
+        kStatusbarLogSuccess) {
+      continue;
+    }
+    int child_err;
+    if (capabilities.type == sink::kSinkFlightRecorder) {
+      child_err = _WriteFlightRecorderLogLine(children[i].sink, log_level,
+                                              line, len);
+    } else if (capabilities.supports_escapes) {
+      child_err = _WriteLogLine(children[i].sink, log_level, line, len);
+    } else {
+      child_err =
+          _WritePlainLogLine(children[i].sink, log_level, line, len);
+    }
+    if (err == kStatusbarLogSuccess) err = child_err;
+  }
+  return err;
+}
+
+/**
+ * \brief Writes a formatted log line to a sink, fanning it out if the sink is
+ * a tee and recording it if the sink is a flight recorder.
+ *
+ * \return Same codes as statusbar_log::LogV.
+ */
+int _DispatchLogLine(const sink::SinkHandle& sink_handle,
+                     const LogLevel log_level, const char* line,
+                     const std::size_t len) {
+  sink::SinkType sink_type = sink::kSinkInvalid;
+  if (sink::get_sink_type(sink_handle, sink_type) == kStatusbarLogSuccess) {
+    if (sink_type == sink::kSinkTee) {
+      return _WriteTeeLogLine(sink_handle, log_level, line, len);
+    }
+    if (sink_type == sink::kSinkFlightRecorder) {
+      return _WriteFlightRecorderLogLine(sink_handle, log_level, line, len);
+    }
+  }
+  return _WriteLogLine(sink_handle, log_level, line, len);
+}
+
+/**
+ * \brief Claims a free slot for a producer.
+ *
+ * The caller formats its line into the slot and publishes it with
+ * _AsyncPublishSlot.
+ *
+ * \return The claimed slot or nullptr if the queue is full.
+ */
+AsyncLogSlot* _AsyncTryClaimFree(AsyncLogger& logger, std::size_t& pos) {
+  pos = logger.enqueue_pos.load(std::memory_order_relaxed);
+  while (true) {
+    AsyncLogSlot* slot = &logger.slots[pos & logger.mask];
+    const std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+    const std::intptr_t dif =
+        static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+    if (dif == 0) {
+      if (logger.enqueue_pos.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        return slot;
+      }
+    } else if (dif < 0) {
+      return nullptr;
+    } else {
+      pos = logger.enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * \brief Makes a slot claimed with _AsyncTryClaimFree visible to the writer.
+ */
+void _AsyncPublishSlot(AsyncLogSlot* slot, const std::size_t pos) {
+  slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+/**
+ * \brief Claims the oldest queued slot.
+ *
+ * The caller must hand the slot back with _AsyncReleaseSlot once it is done
+ * with it.
+ *
+ * \return The claimed slot or nullptr if the queue is empty.
+ */
+AsyncLogSlot* _AsyncTryClaim(AsyncLogger& logger, std::size_t& pos) {
+  pos = logger.dequeue_pos.load(std::memory_order_relaxed);
+  while (true) {
+    AsyncLogSlot* slot = &logger.slots[pos & logger.mask];
+    const std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+    const std::intptr_t dif =
+        static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+    if (dif == 0) {
+      if (logger.dequeue_pos.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        return slot;
+      }
+    } else if (dif < 0) {
+      return nullptr;
+    } else {
+      pos = logger.dequeue_pos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * \brief Hands a slot claimed with _AsyncTryClaim back to the producers.
+ */
+void _AsyncReleaseSlot(AsyncLogger& logger, AsyncLogSlot* slot,
+                       const std::size_t pos) {
+  slot->sequence.store(pos + logger.mask + 1, std::memory_order_release);
+  logger.completed.fetch_add(1, std::memory_order_release);
+  logger.completed.notify_all();
+}
+
+/**
+ * \brief Wakes the writer thread if it is waiting for new messages.
+ */
+void _AsyncWakeWriter(AsyncLogger& logger) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (logger.writer_sleeping.load(std::memory_order_relaxed)) {
+    logger.wake.fetch_add(1, std::memory_order_release);
+    logger.wake.notify_one();
+  }
+}
+
+/**
+ * \brief Producer side of asynchronous logging: claims a free slot according
+ * to the overflow policy.
+ *
+ * The caller formats its line into the slot and publishes it with
+ * _AsyncPublishSlot.
+ *
+ * \return Same codes as statusbar_log::LogV.
+ */
+int _AsyncClaimLine(AsyncLogger& logger, AsyncLogSlot*& slot,
+                    std::size_t& pos) {
+  while ((slot = _AsyncTryClaimFree(logger, pos)) == nullptr) {
+    if (logger.policy == kAsyncOverflowDropNewest) {
+      logger.dropped_newest.fetch_add(1, std::memory_order_relaxed);
+      return -14;
+    }
+
+    if (logger.policy == kAsyncOverflowDropOldest) {
+      std::size_t oldest_pos;
+      AsyncLogSlot* oldest = _AsyncTryClaim(logger, oldest_pos);
+      if (oldest) {
+        _AsyncReleaseSlot(logger, oldest, oldest_pos);
+        logger.dropped_oldest.fetch_add(1, std::memory_order_relaxed);
+      }
+      continue;
+    }
+
+    // kAsyncOverflowBlock: sleep until the writer completes another slot. The
+    // snapshot is taken before retrying so a slot freed in between is not
+    // missed.
+    const std::uint64_t completed =
+        logger.completed.load(std::memory_order_acquire);
+    if ((slot = _AsyncTryClaimFree(logger, pos)) != nullptr) break;
+    _AsyncWakeWriter(logger);
+    logger.completed.wait(completed, std::memory_order_acquire);
+  }
+  return kStatusbarLogSuccess;
+}
+
+/**
+ * \brief Writes the line of a claimed slot and hands the slot back.
+ */
+void _AsyncWriteSlot(AsyncLogger& logger, AsyncLogSlot* slot,
+                     const std::size_t pos) {
+  const int err = _DispatchLogLine(slot->sink_handle, slot->log_level,
+                                   slot->line, slot->len);
+  _AsyncReleaseSlot(logger, slot, pos);
+  if (err == kStatusbarLogSuccess) {
+    logger.written.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    logger.failed.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * \brief Body of the writer thread: writes queued lines until asked to stop
+ * and the queue is drained.
+ */
+void _AsyncWriterLoop(AsyncLogger* logger) {
+  _is_async_writer_thread = true;
+  std::size_t pos;
+  while (true) {
+    AsyncLogSlot* slot = _AsyncTryClaim(*logger, pos);
+    if (slot) {
+      _AsyncWriteSlot(*logger, slot, pos);
+      continue;
+    }
+    if (logger->stop.load(std::memory_order_acquire)) break;
+
+    // Announce that we are going to sleep, then look at the queue once more:
+    // a producer either sees the flag or its message is found here.
+    const std::uint32_t seen = logger->wake.load(std::memory_order_acquire);
+    logger->writer_sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    slot = _AsyncTryClaim(*logger, pos);
+    if (slot) {
+      logger->writer_sleeping.store(false, std::memory_order_relaxed);
+      _AsyncWriteSlot(*logger, slot, pos);
+      continue;
+    }
+    if (!logger->stop.load(std::memory_order_acquire)) {
+      logger->wake.wait(seen, std::memory_order_acquire);
+    }
+    logger->writer_sleeping.store(false, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * \brief Drains the queue and stops the writer thread (registered with
+ * std::atexit).
+ */
+void _StopAsyncLoggingAtExit() { StopAsyncLogging(); }
+
+/// Number of filenames that can have their own runtime log level.
+constexpr std::size_t kMaxModuleLogLevels = 64;
+/// Marks a per-sink or per-module level that is not set.
+constexpr int kLogLevelUnset = -1;
+
+/**
+ * \struct ModuleLogLevel
+ * \brief Runtime log level of one filename/module.
+ *
+ * Entries are only ever appended (under _log_level_mutex) and published by
+ * bumping _module_log_level_count, so `hash` and `name` can be read without a
+ * lock. Clearing an entry only resets `level`.
+ */
+// clang-format off
+typedef struct {
+  std::uint64_t hash;       ///< FNV-1a hash of `name`.
+  std::string name;         ///< The filename/module.
+  std::atomic<int> level;   ///< Level or kLogLevelUnset.
+} ModuleLogLevel;
+// clang-format on
+
+/// Global runtime level (statusbar_log::SetLogLevel).
+std::atomic<int> _global_log_level = kLogLevel;
+/// Highest level any message can currently pass (global and all overrides),
+/// the single relaxed load in front of every log call.
+std::atomic<int> _max_runtime_log_level = kLogLevel;
+/// True while per-sink or per-module levels are set.
+std::atomic<bool> _has_log_level_overrides = false;
+/// Per-sink levels indexed by sink handle idx: (sink id << 8) | (level + 1),
+/// 0 if not set.
+std::array<std::atomic<std::uint64_t>, sink::kMaxSinkHandles>
+    _sink_log_levels = {};
+std::array<ModuleLogLevel, kMaxModuleLogLevels> _module_log_levels;
+std::atomic<std::size_t> _module_log_level_count = 0;
+/// Serializes the runtime level setters.
+static std::mutex _log_level_mutex;
+
+std::uint64_t _HashFilename(const char* data, const std::size_t len) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (std::size_t i = 0; i < len; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/**
+ * \brief Returns the runtime level set for a filename/module or
+ * kLogLevelUnset.
+ */
+int _ModuleLogLevel(const std::string& filename) {
+  const std::size_t count =
+      _module_log_level_count.load(std::memory_order_acquire);
+  if (count == 0) return kLogLevelUnset;
+  const std::uint64_t hash = _HashFilename(filename.data(), filename.size());
+  for (std::size_t i = 0; i < count; ++i) {
+    const ModuleLogLevel& entry = _module_log_levels[i];
+    if (entry.hash == hash && entry.name == filename) {
+      return entry.level.load(std::memory_order_relaxed);
+    }
+  }
+  return kLogLevelUnset;
+}
+
+/**
+ * \brief Returns the runtime level set for a sink or kLogLevelUnset.
+ */
+int _SinkLogLevel(const sink::SinkHandle& sink_handle) {
+  if (sink_handle.idx >= _sink_log_levels.size()) return kLogLevelUnset;
+  const std::uint64_t packed =
+      _sink_log_levels[sink_handle.idx].load(std::memory_order_relaxed);
+  if (packed == 0 || (packed >> 8) != sink_handle.id) return kLogLevelUnset;
+  return static_cast<int>(packed & 0xff) - 1;
+}
+
+/**
+ * \brief Recomputes _max_runtime_log_level and _has_log_level_overrides.
+ * Must be called with _log_level_mutex held.
+ */
+void _UpdateRuntimeLogLevelSummary() {
+  int max_level = _global_log_level.load(std::memory_order_relaxed);
+  bool has_overrides = false;
+  for (const std::atomic<std::uint64_t>& sink_level : _sink_log_levels) {
+    const std::uint64_t packed = sink_level.load(std::memory_order_relaxed);
+    if (packed == 0) continue;
+    has_overrides = true;
+    max_level = std::max(max_level, static_cast<int>(packed & 0xff) - 1);
+  }
+  const std::size_t count =
+      _module_log_level_count.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < count; ++i) {
+    const int level =
+        _module_log_levels[i].level.load(std::memory_order_relaxed);
+    if (level == kLogLevelUnset) continue;
+    has_overrides = true;
+    max_level = std::max(max_level, level);
+  }
+  _has_log_level_overrides.store(has_overrides, std::memory_order_relaxed);
+  _max_runtime_log_level.store(max_level, std::memory_order_relaxed);
+}
+
+/**
+ * \brief Runtime level filter used by all log calls.
+ *
+ * The common case (no message of this level can pass) costs one relaxed load
+ * and a branch. Only if overrides could let the message through the
+ * module, sink and global levels are resolved (in that order of precedence).
+ */
+inline bool _IsLogLevelEnabled(const LogLevel log_level,
+                               const std::string& filename,
+                               const sink::SinkHandle& sink_handle) {
+  if (log_level > _max_runtime_log_level.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  if (!_has_log_level_overrides.load(std::memory_order_relaxed)) return true;
+
+  int level = _ModuleLogLevel(filename);
+  if (level == kLogLevelUnset) level = _SinkLogLevel(sink_handle);
+  if (level == kLogLevelUnset) {
+    level = _global_log_level.load(std::memory_order_relaxed);
+  }
+  return log_level <= level;
+}
+
+}  // namespace
+
+namespace detail {
+
+int BeginLogLine(const LogLevel log_level, const std::string& filename,
+                 sink::SinkHandle sink_handle, LogLine& line) {
+  line.sink_handle = sink_handle;
+  line.log_level = log_level;
+  line.filename = &filename;
+  line.async_logger = nullptr;
+  line.async_slot = nullptr;
+  line.async_pos = 0;
+
+  sink::SinkType sink_type = sink::kSinkInvalid;
+  const int type_err = sink::get_sink_type(sink_handle, sink_type);
+  if (type_err != kStatusbarLogSuccess) return type_err;
+  line.binary = (sink_type == sink::kSinkBinary);
+
+  if (!line.binary && !_is_async_writer_thread &&
+      _async_logger.load(std::memory_order_relaxed) != nullptr) {
+    _async_producers.fetch_add(1, std::memory_order_seq_cst);
+    AsyncLogger* logger = _async_logger.load(std::memory_order_seq_cst);
+    if (logger) {
+      int err = sink::IsValidSinkHandle(sink_handle);
+      AsyncLogSlot* slot = nullptr;
+      if (err == kStatusbarLogSuccess) {
+        err = _AsyncClaimLine(*logger, slot, line.async_pos);
+      }
+      if (err != kStatusbarLogSuccess) {
+        _async_producers.fetch_sub(1, std::memory_order_release);
+        return err;
+      }
+      // The producer count stays raised until CommitLogLine published the
+      // slot, so StopAsyncLogging cannot tear the queue down underneath us.
+      line.async_logger = logger;
+      line.async_slot = slot;
+      line.line = slot->line;
+      line.capacity = kAsyncLineCapacity;
+    } else {
+      _async_producers.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  if (!line.async_logger) {
+    // Only reused once the line has been written, so a nested log call (e.g.
+    // an error while redrawing the statusbars) may safely overwrite it.
+    thread_local char buffer[kLogLineBufferCapacity];
+    line.line = buffer;
+    line.capacity = kLogLineBufferCapacity;
   }
 
+  if (line.binary) {
+    // Room for the length of the "%s" argument in front of the message.
+    line.message = line.line + sizeof(std::uint32_t);
+    line.message_capacity = kMaxLogLength;
+    return kStatusbarLogSuccess;
+  }
+
+  const std::size_t header_len =
+      _FormatLogLineHeader(line.line, log_level, filename);
+  line.message = line.line + header_len;
+  line.message_capacity = kMaxLogLength;
   return kStatusbarLogSuccess;
 }
 
-/**
- * \brief Function used only by that StatusbarLog module to draw a single status
- * bar at a certain position.
- *
- * This function draws a single status bar (not multiple stacked ones) from
- * primitive variables.
- *
- * Example single statusbar:
- * "prefix string"[########/       ] 50% "postfix string"
- *
- * the bar can be drawn at an arbitrary postion above or on the cursur using the
- * `move` parameter.
- *
- * \param[in] SinkHandle Struct to use for writing.
- * \param[in] write_lock Unique lock of the sink to write to (should already be
- * locked).
- * \param[in] percent: Progress percentage (0-100).
- * \param[in] bar_width: Total bar width (characters excluding prefix, postfix,
- * percentage, '[' and '[').
- * \param[in] prefix: Text before the bar.
- * \param[in] postfix: Text after the bar.
- * \param[in, out] spinner_idx: Index for spinner animation (incremented on
- * call).
- * \param[in] move: Vertical offset from cursor (positive = up).
- *
- * \details Using the spinner_idx the spinner character can cycle through { |,
- * /, -, \ } on each update.
- *
- * \return Returns statusbar_log::kStatusbarLogSuccess (i.e. 0) on success, or
- * one of these error/warning codes:
- *         -  statusbar_log::kStatusbarLogSuccess (i.e. 0): Success (no errors)
- *         - -1: Terminal width detection failed (Windows)
- *         - -2: Terminal width detection failed (Linux)
- *         - -3: Truncantion was needed (bar exeeds terminal width)
- *         - -4: Both terminal width detection failed (Window) AND truncation
- * was needed
- *         - -5: Both terminal width detection failed (Linux) AND truncation was
- *         - -6: Invalid percentage given
- *         - -7: write_lock not owned (cannot print without write_lock owned)
- *         - -8: Sink write failed.
- * needed
- */
-int _DrawStatusbarComponent(const sink::SinkHandle& sink_handle,
-                            std::unique_lock<std::mutex>& write_lock,
-                            const double percent, const unsigned int bar_width,
-                            const std::string& prefix,
-                            const std::string& postfix,
-                            std::size_t& spinner_idx, const int move) {
-  if (!write_lock.owns_lock()) {
-    return -7;
+bool ShouldLog(const LogLevel log_level, const std::string& filename,
+               const sink::SinkHandle& sink_handle) {
+  return log_level <= kLogLevel &&
+         _IsLogLevelEnabled(log_level, filename, sink_handle);
+}
+
+int CommitLogLine(LogLine& line, std::size_t message_len) {
+  if (line.binary) {
+    // The decoder sanitizes, store the message as the argument of "%s".
+    const std::uint32_t len = static_cast<std::uint32_t>(
+        std::min<std::size_t>(message_len, line.message_capacity));
+    std::memcpy(line.line, &len, sizeof(len));
+    const int err = sink::SinkWriteBinaryLog(
+        line.sink_handle, line.log_level, *line.filename, "%s", line.line,
+        sizeof(len) + len);
+    return (err < -5) ? -6 : err;
   }
-  if (percent > 100.0 || percent < 0.0) {
-    write_lock.unlock();
 
-    LogErr(kFilename, sink_handle,
-           "Failed to update statusbar: Invalid percentage.");
-    write_lock.lock();
-    return -5;
+  // Reserve one byte for the trailing '\n'.
+  const std::size_t message_space =
+      static_cast<std::size_t>(line.line + line.capacity - line.message) - 1;
+  message_len = std::min<std::size_t>(message_len, line.message_capacity);
+  message_len =
+      SanitizeInPlace(line.message, message_len, message_space, true);
+  line.message[message_len] = '\n';
+  const std::size_t len =
+      static_cast<std::size_t>(line.message - line.line) + message_len + 1;
+
+  if (!line.async_logger) {
+    return _DispatchLogLine(line.sink_handle, line.log_level, line.line, len);
   }
 
-  int err = kStatusbarLogSuccess;
-  static const std::array<char, 4> spinner = {'|', '/', '-', '\\'};
-  spinner_idx %= spinner.size();
-  char spin_char = spinner[spinner_idx];
+  AsyncLogger& logger = *static_cast<AsyncLogger*>(line.async_logger);
+  AsyncLogSlot* slot = static_cast<AsyncLogSlot*>(line.async_slot);
+  slot->sink_handle = line.sink_handle;
+  slot->log_level = line.log_level;
+  slot->len = len;
+  _AsyncPublishSlot(slot, line.async_pos);
+  logger.enqueued.fetch_add(1, std::memory_order_relaxed);
+  _AsyncWakeWriter(logger);
+  _async_producers.fetch_sub(1, std::memory_order_release);
+  return kStatusbarLogSuccess;
+}
 
-  const unsigned int fill =
-      std::floor((percent * static_cast<double>(bar_width)) / 100.0);
-  const unsigned int empty = bar_width - fill;
+}  // namespace detail
 
-  std::ostringstream oss;
-  oss << prefix;
-  oss << "[";
-  oss << std::string(fill, '#');
-  if (empty > 0) {
-    oss << spin_char;
-    oss << std::string(empty - 1, ' ');
-  } else {
-    oss << std::string(empty, ' ');
+int LogV(const LogLevel log_level, const std::string& filename,
+         sink::SinkHandle sink_handle, const char* fmt, va_list args) {
+  if (log_level > kLogLevel) return kStatusbarLogSuccess;
+  if (!_IsLogLevelEnabled(log_level, filename, sink_handle)) {
+    return kStatusbarLogSuccess;
   }
-  oss << "] ";
-  oss << std::fixed << std::setprecision(2) << std::setw(6) << percent;
-  oss << postfix;
-  std::string status_str = oss.str();
 
-  int term_width;
-  if (sink::SinkIsTty(sink_handle)) {
-    err = _GetTerminalWidth(term_width);
-  } else {
-    term_width = INT_MAX;
-  }
+  detail::LogLine line;
+  int err = detail::BeginLogLine(log_level, filename, sink_handle, line);
+  if (err != kStatusbarLogSuccess) return err;
 
-  if (status_str.length() > static_cast<size_t>(term_width)) {
-    status_str = status_str.substr(0, term_width - 1);
-    switch (err) {
-      case kStatusbarLogSuccess:
-        err = -3;
-        break;
-      case -1:
-        err = -4;
-        break;
-      case -2:
-        err = -5;
-        break;
+  if (line.binary) {
+    // Defer formatting: store the raw arguments. Calls the encoder can not
+    // represent fall through and are stored as formatted text.
+    const long args_len = binary_log::detail::EncodeArgs(
+        fmt, args, line.line,
+        std::min<std::size_t>(line.capacity, binary_log::kMaxArgsLength));
+    if (args_len >= 0) {
+      err = sink::SinkWriteBinaryLog(sink_handle, log_level, filename, fmt,
+                                     line.line,
+                                     static_cast<std::size_t>(args_len));
+      return (err < -5) ? -6 : err;
     }
   }
 
-  sink::MoveCursorUp(sink_handle, move);
-  ClearCurrentLine(sink_handle);
-  ssize_t written = sink::SinkWriteStr(sink_handle, status_str);
-  if (written <= 0) {
-    std::cout << "ERROR [" << kFilename << "]: "
-              << "Sink Write Failed in _DrawStatusbarComponent!\n";
-    return -8;
-  }
-  _ConditionalFlush(sink_handle);
-  sink::MoveCursorUp(sink_handle, -move);
-
-  return err;
+  va_list args_copy;
+  va_copy(args_copy, args);
+  const int printed = std::vsnprintf(line.message, line.message_capacity + 1,
+                                     fmt, args_copy);
+  va_end(args_copy);
+  return detail::CommitLogLine(
+      line, printed < 0 ? 0 : static_cast<std::size_t>(printed));
 }
 
-}  // namespace
+int SetLogLevel(const LogLevel log_level) {
+  if (log_level > kLogLevel) return -1;
+  std::lock_guard<std::mutex> level_lock(_log_level_mutex);
+  _global_log_level.store(log_level, std::memory_order_relaxed);
+  _UpdateRuntimeLogLevelSummary();
+  return kStatusbarLogSuccess;
+}
 
-void SaveCursorPosition(sink::SinkHandle sink_handle) {
-  std::cout << "\033[s";  // ANSI escape code to save cursor position
-  _ConditionalFlush(sink_handle);
+LogLevel GetLogLevel() {
+  return static_cast<LogLevel>(
+      _global_log_level.load(std::memory_order_relaxed));
 }
 
-void RestoreCursorPosition(sink::SinkHandle sink_handle) {
-  std::cout << "\033[u";  // ANSI escape code to restore cursor position
-  _ConditionalFlush(sink_handle);
+int SetSinkLogLevel(const sink::SinkHandle& sink_handle,
+                    const LogLevel log_level) {
+  if (log_level > kLogLevel) return -1;
+  const int err = sink::IsValidSinkHandle(sink_handle);
+  if (err != kStatusbarLogSuccess) return -2;
+  if (sink_handle.idx >= _sink_log_levels.size()) return -2;
+
+  std::lock_guard<std::mutex> level_lock(_log_level_mutex);
+  const std::uint64_t packed =
+      (static_cast<std::uint64_t>(sink_handle.id) << 8) |
+      static_cast<std::uint64_t>(log_level + 1);
+  _sink_log_levels[sink_handle.idx].store(packed, std::memory_order_relaxed);
+  _UpdateRuntimeLogLevelSummary();
+  return kStatusbarLogSuccess;
 }
 
-void ClearToEndOfLine(sink::SinkHandle sink_handle) {
-  std::cout << "\033[0K";  // ANSI escape code to clear to end of line
-  _ConditionalFlush(sink_handle);
+int ClearSinkLogLevel(const sink::SinkHandle& sink_handle) {
+  if (sink_handle.idx >= _sink_log_levels.size()) return -2;
+  std::lock_guard<std::mutex> level_lock(_log_level_mutex);
+  if (_SinkLogLevel(sink_handle) == kLogLevelUnset) return -2;
+  _sink_log_levels[sink_handle.idx].store(0, std::memory_order_relaxed);
+  _UpdateRuntimeLogLevelSummary();
+  return kStatusbarLogSuccess;
 }
 
-void ClearFromStartOfLine(sink::SinkHandle sink_handle) {
-  std::cout << "\033[1K";  // ANSI escape code to clear to end of line
-  _ConditionalFlush(sink_handle);
+int SetModuleLogLevel(const std::string& filename, const LogLevel log_level) {
+  if (log_level > kLogLevel) return -1;
+  std::lock_guard<std::mutex> level_lock(_log_level_mutex);
+
+  const std::uint64_t hash = _HashFilename(filename.data(), filename.size());
+  const std::size_t count =
+      _module_log_level_count.load(std::memory_order_relaxed);
+  std::size_t i = 0;
+  while (i < count && (_module_log_levels[i].hash != hash ||
+                       _module_log_levels[i].name != filename)) {
+    ++i;
+  }
+  if (i == count) {
+    if (count == kMaxModuleLogLevels) return -2;
+    _module_log_levels[i].hash = hash;
+    _module_log_levels[i].name = filename;
+    _module_log_levels[i].level.store(log_level, std::memory_order_relaxed);
+    _module_log_level_count.store(count + 1, std::memory_order_release);
+  } else {
+    _module_log_levels[i].level.store(log_level, std::memory_order_relaxed);
+  }
+  _UpdateRuntimeLogLevelSummary();
+  return kStatusbarLogSuccess;
 }
 
-void ClearLine(sink::SinkHandle sink_handle) {
-  std::cout << "\033[2K";
-  _ConditionalFlush(sink_handle);
+int ClearModuleLogLevel(const std::string& filename) {
+  std::lock_guard<std::mutex> level_lock(_log_level_mutex);
+  const std::uint64_t hash = _HashFilename(filename.data(), filename.size());
+  const std::size_t count =
+      _module_log_level_count.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < count; ++i) {
+    if (_module_log_levels[i].hash == hash &&
+        _module_log_levels[i].name == filename &&
+        _module_log_levels[i].level.load(std::memory_order_relaxed) !=
+            kLogLevelUnset) {
+      _module_log_levels[i].level.store(kLogLevelUnset,
+                                        std::memory_order_relaxed);
+      _UpdateRuntimeLogLevelSummary();
+      return kStatusbarLogSuccess;
+    }
+  }
+  return -1;
 }
 
-void ClearCurrentLine(sink::SinkHandle sink_handle) {
-  std::cout << "\r"        // Return to line start
-            << "\033[2K";  // Clear entire line
-  _ConditionalFlush(sink_handle);
+void ResetLogLevels() {
+  std::lock_guard<std::mutex> level_lock(_log_level_mutex);
+  _global_log_level.store(kLogLevel, std::memory_order_relaxed);
+  for (std::atomic<std::uint64_t>& sink_level : _sink_log_levels) {
+    sink_level.store(0, std::memory_order_relaxed);
+  }
+  const std::size_t count =
+      _module_log_level_count.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < count; ++i) {
+    _module_log_levels[i].level.store(kLogLevelUnset,
+                                      std::memory_order_relaxed);
+  }
+  _UpdateRuntimeLogLevelSummary();
 }
 
-int LogV(const LogLevel log_level, const std::string& filename,
-         sink::SinkHandle sink_handle, const char* fmt, va_list args) {
-  if (log_level > kLogLevel) return kStatusbarLogSuccess;
-  std::mutex* write_mutex_ptr = nullptr;
-  int err = sink::get_mutex_ptr(sink_handle, write_mutex_ptr);
-  if (err != kStatusbarLogSuccess) return err;
+int StartAsyncLogging(std::size_t capacity, AsyncOverflowPolicy policy) {
+  std::lock_guard<std::mutex> control_lock(_async_control_mutex);
+  if (_async_logger.load(std::memory_order_acquire) != nullptr) return -1;
+  if (capacity == 0 || capacity > kMaxAsyncQueueCapacity) return -2;
 
-  std::unique_lock<std::mutex> write_lock(*write_mutex_ptr, std::defer_lock);
-  std::unique_lock<std::mutex> registry_lock(_statusbar_registry_mutex,
-                                             std::defer_lock);
-  std::lock(write_lock, registry_lock);
+  std::size_t num_slots = 2;
+  while (num_slots < capacity) num_slots <<= 1;
 
-  const bool statusbars_active = !_statusbar_registry.empty();
-  // sink::SinkType sink_type;
-  // err = sink::GetSinkType(sink_handle, sink_type);
-  // if (err != kStatusbarLogSuccess) return err;
+  AsyncLogger* logger = nullptr;
+  try {
+    logger = new AsyncLogger();
+    logger->slots = std::make_unique<AsyncLogSlot[]>(num_slots);
+  } catch (...) {
+    delete logger;
+    return -3;
+  }
+  for (std::size_t i = 0; i < num_slots; ++i) {
+    logger->slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  logger->mask = num_slots - 1;
+  logger->policy = policy;
 
-  const char* prefix = "";
-  // clang-format off
-  switch(log_level){
-    case kLogLevelErr: prefix = "ERROR"; break;
-    case kLogLevelWrn: prefix = "WARNING"; break;
-    case kLogLevelInf: prefix = "INFO"; break;
-    case kLogLevelDbg: prefix = "DEBUG"; break;
-    default: break;
+  try {
+    logger->writer = std::thread(_AsyncWriterLoop, logger);
+  } catch (...) {
+    delete logger;
+    return -4;
   }
-  // clang-format on
 
-  int move = 0;
-  if (statusbars_active) {
-    for (std::size_t i = 0; i < _statusbar_registry.size(); ++i) {
-      for (std::size_t j = 0; j < _statusbar_registry[i].positions.size();
-           ++j) {
-        int current_pos = _statusbar_registry[i].positions[j];
-        if (current_pos > move) {
-          move = current_pos;
-        }
-      }
+  _async_logger.store(logger, std::memory_order_seq_cst);
+  // Messages still queued when main returns are written before the sinks and
+  // the statusbar registry are destroyed.
+  static std::once_flag atexit_once;
+  std::call_once(atexit_once, [] { std::atexit(_StopAsyncLoggingAtExit); });
+  return kStatusbarLogSuccess;
+}
+
+int StopAsyncLogging() {
+  std::lock_guard<std::mutex> control_lock(_async_control_mutex);
+  AsyncLogger* logger =
+      _async_logger.exchange(nullptr, std::memory_order_seq_cst);
+  if (!logger) return -1;
+
+  // New log calls now take the synchronous path, wait for the ones already
+  // queueing.
+  while (_async_producers.load(std::memory_order_seq_cst) != 0) {
+    std::this_thread::yield();
+  }
+
+  logger->stop.store(true, std::memory_order_release);
+  logger->wake.fetch_add(1, std::memory_order_release);
+  logger->wake.notify_one();
+  logger->writer.join();
+  delete logger;
+  return kStatusbarLogSuccess;
+}
+
+int FlushAsyncLogging() {
+  if (_is_async_writer_thread) return -1;
+
+  _async_producers.fetch_add(1, std::memory_order_seq_cst);
+  AsyncLogger* logger = _async_logger.load(std::memory_order_seq_cst);
+  if (logger) {
+    const std::uint64_t target =
+        logger->enqueue_pos.load(std::memory_order_acquire);
+    std::uint64_t completed = logger->completed.load(std::memory_order_acquire);
+    while (completed < target) {
+      _AsyncWakeWriter(*logger);
+      logger->completed.wait(completed, std::memory_order_acquire);
+      completed = logger->completed.load(std::memory_order_acquire);
     }
   }
+  _async_producers.fetch_sub(1, std::memory_order_release);
+  return kStatusbarLogSuccess;
+}
 
-  va_list args_copy;
-  sink::MoveCursorUp(sink_handle, move);
-  if (statusbars_active) printf("\r\033[2K\r");
-  va_copy(args_copy, args);
-  unsigned int size = std::vsnprintf(nullptr, 0, fmt, args_copy);
-  va_end(args_copy);
-  size = std::min(size, kMaxLogLength);
-  std::vector<char> buffer(size + 1);
-  va_copy(args_copy, args);
-  std::vsnprintf(buffer.data(), buffer.size(), fmt, args_copy);
-  va_end(args_copy);
-  std::string message = _SanitizeStringWithNewline(buffer.data());
+bool IsAsyncLoggingActive() {
+  return _async_logger.load(std::memory_order_acquire) != nullptr;
+}
 
-  std::string sanitized_filename = _SanitizeStringWithNewline(filename);
-  if (sanitized_filename.length() > kMaxFilenameLength) {
-    sanitized_filename.resize(kMaxFilenameLength - 3);
-    sanitized_filename += "...";
+int GetAsyncLogStats(AsyncLogStats& stats) {
+  stats = AsyncLogStats{0, 0, 0, 0, 0};
+  _async_producers.fetch_add(1, std::memory_order_seq_cst);
+  AsyncLogger* logger = _async_logger.load(std::memory_order_seq_cst);
+  if (logger) {
+    stats.enqueued = logger->enqueued.load(std::memory_order_relaxed);
+    stats.written = logger->written.load(std::memory_order_relaxed);
+    stats.failed = logger->failed.load(std::memory_order_relaxed);
+    stats.dropped_newest =
+        logger->dropped_newest.load(std::memory_order_relaxed);
+    stats.dropped_oldest =
+        logger->dropped_oldest.load(std::memory_order_relaxed);
   }
+  _async_producers.fetch_sub(1, std::memory_order_release);
+  return logger ? kStatusbarLogSuccess : -1;
+}
 
-  std::string formatted_message =
-      std::string(prefix) + " [" + sanitized_filename + "]: " + message + "\n";
-  ssize_t written = sink::SinkWriteStr(sink_handle, formatted_message);
-  if (written <= 0) {
-    std::cout << "ERROR [" << kFilename << "]: "
-              << "Sink Write Failed in _DrawStatusbarComponent!\n";
-    return -6;
+int SetStatusbarRedrawInterval(const unsigned int interval_ms) {
+  if (interval_ms > kMaxStatusbarRedrawInterval) return -1;
+
+  std::lock_guard<std::mutex> control_lock(_frame_control_mutex);
+  FrameScheduler& scheduler = *_frame_scheduler;
+  if (interval_ms > 0 && !scheduler.thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(scheduler.mutex);
+      scheduler.stop = false;
+    }
+    try {
+      scheduler.thread = std::thread(_FrameSchedulerLoop, &scheduler);
+    } catch (...) {
+      return -2;
+    }
+    static std::once_flag atexit_once;
+    std::call_once(atexit_once, [] { std::atexit(_StopFrameScheduler); });
   }
 
-  _ConditionalFlush(sink_handle);
-  sink::MoveCursorUp(sink_handle, -move);
+  _redraw_interval_ms.store(interval_ms, std::memory_order_relaxed);
+  // The next log line starts a frame with the new interval.
+  _next_frame_ns.store(0, std::memory_order_relaxed);
 
-  if (statusbars_active) {
-    for (std::size_t i = 0; i < _statusbar_registry.size(); ++i) {
-      for (std::size_t j = 0; j < _statusbar_registry[i].positions.size();
-           ++j) {
-        int bar_err_code = _DrawStatusbarComponent(
-            sink_handle, write_lock, _statusbar_registry[i].percentages[j],
-            _statusbar_registry[i].bar_sizes[j],
-            _statusbar_registry[i].prefixes[j],
-            _statusbar_registry[i].postfixes[j],
-            _statusbar_registry[i].spin_idxs[j],
-            _statusbar_registry[i].positions[j]);
-        if ((bar_err_code != kStatusbarLogSuccess) &&
-            !_statusbar_registry[i].error_reported) {
-          std::string why;
-          bool is_critical_error = false;
-          switch (bar_err_code) {
-            case -1:
-              is_critical_error = true;
-              why = "Terminal width detection failed (Windows)";
-              break;
-            case -2:
-              is_critical_error = true;
-              why = "Terminal width detection failed (Linux)";
-              break;
-            case -3:
-              is_critical_error = false;
-              why = "Truncantion was needed (bar exeeds terminal width)";
-              break;
-            case -4:
-              is_critical_error = true;
-              why =
-                  "Both terminal width detection failed (Window) AND "
-                  "truncation";
-              break;
-            case -5:
-              is_critical_error = true;
-              why =
-                  "Both terminal width detection failed (Linux) AND truncation";
-              break;
-            case -6:
-              is_critical_error = true;
-              why = "Invalid percentage given";
-              break;
-            default:
-              is_critical_error = true;
-              why = "Unknown _DrawStatusbarComponent error!";
-              break;
-          }
-          if (is_critical_error) {
-            _statusbar_registry[i].error_reported = true;
-            write_lock.unlock();
-            registry_lock.unlock();
-            printf(
-                "ERROR [statusbarlog.cc]: LogV(...) failed updating "
-                "statusbar: %s on statusbar with ID %zu at bar idx %zu",
-                why.c_str(), i, j);
-            return bar_err_code - 5;
-          }
-        }
-      }
+  if (interval_ms == 0 && scheduler.thread.joinable()) {
+    // Also draws the lines that still saw the old interval.
+    _StopFrameScheduler();
+  } else {
+    scheduler.wake.notify_one();
+  }
+  return kStatusbarLogSuccess;
+}
+
+void NotifyTerminalResized() {
+  _terminal_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned int GetStatusbarRedrawInterval() {
+  return _redraw_interval_ms.load(std::memory_order_relaxed);
+}
+
+int FlushStatusbarRedraws() {
+  const int err = _DrawPendingFrames();
+  const int render_err = _RenderDirtyStatusbars();
+  return (err != kStatusbarLogSuccess) ? err : render_err;
+}
+
+int SetStatusbarRenderRate(const unsigned int rate_hz) {
+  if (rate_hz > kMaxStatusbarRenderRate) return -1;
+
+  std::lock_guard<std::mutex> control_lock(_render_control_mutex);
+  StatusbarRenderer& renderer = *_statusbar_renderer;
+  if (rate_hz > 0) {
+    _render_rate_hz.store(rate_hz, std::memory_order_relaxed);
+    if (renderer.thread.joinable()) return kStatusbarLogSuccess;
+    {
+      std::lock_guard<std::mutex> lock(renderer.mutex);
+      renderer.stop = false;
     }
+    try {
+      renderer.thread = std::thread(_StatusbarRenderLoop, &renderer);
+    } catch (...) {
+      _render_rate_hz.store(0, std::memory_order_relaxed);
+      return -2;
+    }
+    static std::once_flag atexit_once;
+    std::call_once(atexit_once, [] { std::atexit(_StopStatusbarRenderer); });
+    return kStatusbarLogSuccess;
   }
 
-  write_lock.unlock();
-  registry_lock.unlock();
+  _render_rate_hz.store(0, std::memory_order_relaxed);
+  if (renderer.thread.joinable()) {
+    _StopStatusbarRenderer();
+    // Updates stored after the last frame of the thread.
+    _RenderDirtyStatusbars();
+  }
   return kStatusbarLogSuccess;
 }
 
+unsigned int GetStatusbarRenderRate() {
+  return _render_rate_hz.load(std::memory_order_relaxed);
+}
+
 int CreateStatusbarHandle(StatusbarHandle& statusbar_handle,
                           const sink::SinkHandle sink_handle,
                           const std::vector<unsigned int> _positions,
                           const std::vector<unsigned int> _bar_sizes,
                           const std::vector<std::string> _prefixes,
-                          const std::vector<std::string> _postfixes) {
+                          const std::vector<std::string> _postfixes,
+                          const std::vector<std::uint64_t> _totals) {
   int err = sink::IsValidSinkHandle(sink_handle);
   if (err != kStatusbarLogSuccess) {
     std::cout << "ERROR [" << kFilename << "]: "
@@ -617,9 +2549,20 @@ int CreateStatusbarHandle(StatusbarHandle& statusbar_handle,
            _postfixes.size());
     return -3;
   }
+  if (!_totals.empty() && _totals.size() != _positions.size()) {
+    LogErr(kFilename, sink_handle,
+           "Failed to create statusbar_handle '_totals' must be empty or have "
+           "one entry per bar! Got: '_positions': %zu, '_totals': %zu.",
+           _positions.size(), _totals.size());
+    return -3;
+  }
 
-  if (_statusbar_registry.size() - _statusbar_free_handles.size() >=
-      kMaxStatusbarHandles) {
+  bool full;
+  {
+    std::lock_guard<std::mutex> registry_lock(_statusbar_registry_mutex);
+    full = _statusbar_registry.active() >= kMaxStatusbarHandles;
+  }
+  if (full) {
     LogErr(kFilename, sink_handle,
            "Failed to create statusbar handle. Maximum number of status bars "
            "(%zu) reached",
@@ -639,82 +2582,97 @@ int CreateStatusbarHandle(StatusbarHandle& statusbar_handle,
   std::unique_lock<std::mutex> write_lock(*write_mutex_ptr, std::defer_lock);
   std::unique_lock<std::mutex> registry_lock(_statusbar_registry_mutex,
                                              std::defer_lock);
-  std::unique_lock<std::mutex> id_count_lock(_statusbar_id_count_mutex,
-                                             std::defer_lock);
-  std::lock(write_lock, registry_lock, id_count_lock);
+  std::lock(write_lock, registry_lock);
 
-  _statusbar_handle_id_count++;
-  if (_statusbar_handle_id_count == 0) {
-    write_lock.unlock();
-    registry_lock.unlock();
-    LogWrn(kFilename, sink_handle,
-           "Max number of possible statusbar handle ids reached, looping back "
-           "to 1");
-    std::lock(write_lock, registry_lock);
-    _statusbar_handle_id_count++;
-  }
+  std::size_t slot_idx;
+  unsigned int slot_id;
+  // Only fails if other threads filled the registry since the check above.
+  if (!_statusbar_registry.Claim(slot_idx, slot_id)) return -4;
 
   const std::size_t num_bars = _positions.size();
-  const std::vector<double> percentages(num_bars, 0.0);
-  const std::vector<std::size_t> spin_idxs(num_bars, 0);
-
-  std::vector<std::string> sanitized_prefixes;
-  sanitized_prefixes.reserve(_prefixes.size());
-  std::vector<std::string> sanitized_postfixes;
-  sanitized_postfixes.reserve(_postfixes.size());
-  std::vector<unsigned int> sanitized_bar_sizes;
-  sanitized_bar_sizes.reserve(_bar_sizes.size());
-  for (std::size_t i = 0; i < _prefixes.size(); ++i) {
+  const std::int64_t created_ns = _CoarseNowNs();
+  const std::size_t first_bar = _bar_arena.size();
+  // Amortized, the arena only grows when more bars are active than ever.
+  _bar_arena.resize(first_bar + num_bars);
+  for (std::size_t i = 0; i < num_bars; ++i) {
+    BarRecord& bar = _bar_arena[first_bar + i];
+    bar.percent = 0.0;
+    bar.position = _positions[i];
+    bar.bar_size = std::min<unsigned int>(_bar_sizes[i], kMaxBarWidth);
+    bar.spin_idx = 0;
+    bar.parent = BarLink{};
+    bar.child_weight = 0.0;
+    bar.weighted_sum = 0.0;
+    bar.rate = 0.0;
+    bar.rate_percent = 0.0;
+    bar.rate_time = created_ns;
+    bar.rate_known = false;
+    bar.stale = false;
+    bar.rendered_len = 0;
+
+    // Replacement characters that do not fit are cut off.
     std::string _prefix = _prefixes[i];
     if (_prefix.length() > kMaxPrefixLength) {
       _prefix.resize(kMaxPrefixLength - 3);
       _prefix += "...";
     }
-    sanitized_prefixes.push_back(_SanitizeString(_prefix));
+    std::memcpy(bar.prefix, _prefix.data(), _prefix.size());
+    bar.prefix_len = static_cast<std::uint16_t>(detail::SanitizeInPlace(
+        bar.prefix, _prefix.size(), kMaxPrefixLength, false));
 
     std::string _postfix = _postfixes[i];
     if (_postfix.length() > kMaxPostfixLength) {
       _postfix.resize(kMaxPostfixLength - 3);
       _postfix += "...";
     }
-    sanitized_postfixes.push_back(_SanitizeString(_postfix));
-
-    sanitized_bar_sizes.push_back(
-        std::min<unsigned int>(_bar_sizes[i], kMaxBarWidth));
-  }
-
-  if (!_statusbar_free_handles.empty()) {
-    StatusbarHandle free_handle = _statusbar_free_handles.back();
-    _statusbar_free_handles.pop_back();
-    statusbar_handle.idx = free_handle.idx;
-    _statusbar_registry[statusbar_handle.idx] = {sink_handle,
-                                                 percentages,
-                                                 _positions,
-                                                 sanitized_bar_sizes,
-                                                 sanitized_prefixes,
-                                                 sanitized_postfixes,
-                                                 spin_idxs,
-                                                 _statusbar_handle_id_count,
-                                                 false};
-  } else {
-    statusbar_handle.idx = _statusbar_registry.size();
-    _statusbar_registry.emplace_back(
-        Statusbar{sink_handle, percentages, _positions, sanitized_bar_sizes,
-                  sanitized_prefixes, sanitized_postfixes, spin_idxs,
-                  _statusbar_handle_id_count, false});
+    std::memcpy(bar.postfix, _postfix.data(), _postfix.size());
+    bar.postfix_len = static_cast<std::uint16_t>(detail::SanitizeInPlace(
+        bar.postfix, _postfix.size(), kMaxPostfixLength, false));
+  }
+
+  LiveStatusbar& live = _live_statusbars[slot_idx];
+  // Kept from earlier statusbars in the slot if large enough.
+  if (live.bar_capacity < num_bars) {
+    live.bars.reset(new LiveBar[num_bars]);
+    live.bar_capacity = num_bars;
+  }
+  bool counted = false;
+  for (std::size_t j = 0; j < num_bars; ++j) {
+    LiveBar& live_bar = live.bars[j];
+    live_bar.percent.store(0.0, std::memory_order_relaxed);
+    live_bar.updated_ns.store(created_ns, std::memory_order_relaxed);
+    live_bar.derived.store(false, std::memory_order_relaxed);
+    live_bar.total = _totals.empty() ? 0 : _totals[j];
+    counted = counted || live_bar.total > 0;
+  }
+  if (counted) {
+    if (live.progress_capacity < num_bars) {
+      live.progress.reset(new PaddedCounter[num_bars * kProgressShards]);
+      live.progress_capacity = num_bars;
+    }
+    for (std::size_t j = 0; j < num_bars * kProgressShards; ++j) {
+      live.progress[j].value.store(0, std::memory_order_relaxed);
+    }
   }
+  live.num_bars = num_bars;
+  live.dirty.store(false, std::memory_order_relaxed);
+
+  _statusbar_registry[slot_idx] = {sink_handle, first_bar, num_bars, false};
+  _statusbar_registry.Publish(slot_idx, slot_id);
 
-  statusbar_handle.id = _statusbar_handle_id_count;
+  statusbar_handle.idx = slot_idx;
+  statusbar_handle.id = slot_id;
   statusbar_handle.valid = true;
+  std::string postfix;
+  StatusbarFrame frame;
+  _BeginFrame(sink_handle, frame);
   for (std::size_t idx = 0; idx < num_bars; idx++) {
-    _DrawStatusbarComponent(
-        sink_handle, write_lock, 0.0,
-        _statusbar_registry[statusbar_handle.idx].bar_sizes[idx],
-        _statusbar_registry[statusbar_handle.idx].prefixes[idx],
-        _statusbar_registry[statusbar_handle.idx].postfixes[idx],
-        _statusbar_registry[statusbar_handle.idx].spin_idxs[idx],
-        _statusbar_registry[statusbar_handle.idx].positions[idx]);
+    _DrawStatusbarComponent(sink_handle, write_lock,
+                            _bar_arena[first_bar + idx],
+                            _ExpandPostfix(slot_idx, idx, postfix), frame);
   }
+  _CommitFrame(sink_handle, frame);
+  _ConditionalFlush(sink_handle);
   return kStatusbarLogSuccess;
 }
 
@@ -729,8 +2687,12 @@ int DestroyStatusbarHandle(StatusbarHandle& statusbar_handle) {
     return err;
   }
 
-  sink::SinkHandle& sink_handle =
-      _statusbar_registry[statusbar_handle.idx].sink_handle;
+  sink::SinkHandle sink_handle;
+  {
+    // Copied under the lock, the statusbar may be destroyed concurrently.
+    std::lock_guard<std::mutex> registry_lock(_statusbar_registry_mutex);
+    sink_handle = _statusbar_registry[statusbar_handle.idx].sink_handle;
+  }
   err = sink::IsValidSinkHandle(sink_handle);
   if (err != kStatusbarLogSuccess) {
     std::cout << "ERROR [" << kFilename
@@ -754,36 +2716,73 @@ int DestroyStatusbarHandle(StatusbarHandle& statusbar_handle) {
   std::unique_lock<std::mutex> registry_lock(_statusbar_registry_mutex,
                                              std::defer_lock);
   std::lock(write_lock, registry_lock);
+  // Another thread destroyed the statusbar in the meantime.
+  if (_IsValidStatusbarHandle(statusbar_handle) != kStatusbarLogSuccess) {
+    return -3;
+  }
 
   Statusbar& target = _statusbar_registry[statusbar_handle.idx];
-
-  for (std::size_t i = 0; i < target.positions.size(); i++) {
-    sink::MoveCursorUp(sink_handle, target.positions[i]);
-    ClearCurrentLine(sink_handle);
-    sink::MoveCursorUp(sink_handle, -target.positions[i]);
+  BarRecord* target_bars = _bar_arena.data() + target.first_bar;
+
+  StatusbarFrame frame;
+  _BeginFrame(sink_handle, frame);
+  for (std::size_t i = 0; i < target.num_bars; i++) {
+    if (frame.composed) {
+      _FrameMoveTo(frame, target_bars[i].position);
+      frame.buffer.append(kClearLineSeq, sizeof(kClearLineSeq) - 1);
+      continue;
+    }
+    const int position = static_cast<int>(target_bars[i].position);
+    sink::MoveCursorUp(sink_handle, position);
+    _ClearCurrentLine(sink_handle);
+    sink::MoveCursorUp(sink_handle, -position);
   }
+  _CommitFrame(sink_handle, frame);
   sink::FlushSinkHandle(sink_handle);
 
   target.sink_handle = sink::SinkHandle();
-  target.percentages.clear();
-  target.positions.clear();
-  target.bar_sizes.clear();
+  for (std::size_t i = 0; i < target.num_bars; i++) {
+    std::fill(std::begin(target_bars[i].prefix),
+              std::end(target_bars[i].prefix), '\0');
+    std::fill(std::begin(target_bars[i].postfix),
+              std::end(target_bars[i].postfix), '\0');
+  }
 
-  for (std::string& str : target.prefixes) {
-    std::fill(str.begin(), str.end(), '\0');
+  // The records behind the destroyed ones close the gap.
+  const std::size_t first_bar = target.first_bar;
+  const std::size_t num_bars = target.num_bars;
+  _bar_arena.erase(_bar_arena.begin() + first_bar,
+                   _bar_arena.begin() + first_bar + num_bars);
+  for (Statusbar& statusbar : _statusbar_registry) {
+    if (statusbar.num_bars > 0 && statusbar.first_bar > first_bar) {
+      statusbar.first_bar -= num_bars;
+    }
   }
-  for (std::string& str : target.postfixes) {
-    std::fill(str.begin(), str.end(), '\0');
+  target.first_bar = 0;
+  target.num_bars = 0;
+  // Children keep their progress but lose the link to the destroyed parent.
+  // A destroyed child stays counted in its parent with its last percentage.
+  for (BarRecord& bar : _bar_arena) {
+    if (bar.parent.slot_idx == statusbar_handle.idx &&
+        bar.parent.id == statusbar_handle.id) {
+      bar.parent.id = 0;
+    }
   }
-  target.prefixes.clear();
-  target.postfixes.clear();
-
-  target.id = 0;
-  target.spin_idxs.clear();
+  _statusbar_registry.Unpublish(statusbar_handle.idx);
+  // Lock-free updaters that saw the handle as valid are done within a few
+  // instructions, later ones see it unpublished.
+  LiveStatusbar& live = _live_statusbars[statusbar_handle.idx];
+  for (PaddedCounter& users : live.users) {
+    while (users.value.load(std::memory_order_seq_cst) != 0) {
+      std::this_thread::yield();
+    }
+  }
+  // The arrays are kept for the next statusbar in the slot.
+  live.num_bars = 0;
+  _statusbar_registry.Release(statusbar_handle.idx);
 
   statusbar_handle.valid = false;
   statusbar_handle.id = 0;
-  _statusbar_free_handles.push_back(statusbar_handle);
 
   write_lock.unlock();
   registry_lock.unlock();
@@ -792,8 +2791,34 @@ int DestroyStatusbarHandle(StatusbarHandle& statusbar_handle) {
 
 int UpdateStatusbar(StatusbarHandle& statusbar_handle, const std::size_t idx,
                     const double percent) {
-  sink::SinkHandle& sink_handle =
-      _statusbar_registry[statusbar_handle.idx].sink_handle;
+  // With a render thread only the percentage is stored. Invalid arguments
+  // fall through to the locked path below, which reports them.
+  if (_render_rate_hz.load(std::memory_order_relaxed) > 0 &&
+      _IsValidStatusbarHandle(statusbar_handle) == kStatusbarLogSuccess &&
+      percent >= 0.0 && percent <= 100.0) {
+    LiveStatusbar& live = _live_statusbars[statusbar_handle.idx];
+    std::atomic<std::uint64_t>& users = live.users[_ProgressShard()].value;
+    users.fetch_add(1, std::memory_order_seq_cst);
+    const bool stored =
+        _statusbar_registry.Id(statusbar_handle.idx) == statusbar_handle.id &&
+        idx < live.num_bars && live.bars[idx].total == 0 &&
+        !live.bars[idx].derived.load(std::memory_order_relaxed);
+    if (stored) {
+      live.bars[idx].percent.store(percent, std::memory_order_relaxed);
+      live.bars[idx].updated_ns.store(_CoarseNowNs(),
+                                      std::memory_order_relaxed);
+      live.dirty.store(true, std::memory_order_release);
+    }
+    users.fetch_sub(1, std::memory_order_release);
+    if (stored) return kStatusbarLogSuccess;
+  }
+
+  sink::SinkHandle sink_handle;
+  {
+    // Copied under the lock, the statusbar may be destroyed concurrently.
+    std::lock_guard<std::mutex> registry_lock(_statusbar_registry_mutex);
+    sink_handle = _statusbar_registry[statusbar_handle.idx].sink_handle;
+  }
   int err = sink::IsValidSinkHandle(sink_handle);
   if (err != kStatusbarLogSuccess) {
     std::cout << "ERROR [" << kFilename
@@ -838,7 +2863,7 @@ int UpdateStatusbar(StatusbarHandle& statusbar_handle, const std::size_t idx,
 
   Statusbar& statusbar = _statusbar_registry[statusbar_handle.idx];
 
-  if (idx >= statusbar.percentages.size()) {
+  if (idx >= statusbar.num_bars) {
     write_lock.unlock();
     registry_lock.unlock();
     LogErr(kFilename, sink_handle,
@@ -846,12 +2871,59 @@ int UpdateStatusbar(StatusbarHandle& statusbar_handle, const std::size_t idx,
     return -8;
   }
 
-  statusbar.percentages[idx] = percent;
-  statusbar.spin_idxs[idx] = statusbar.spin_idxs[idx] + 1;
+  LiveStatusbar& live = _live_statusbars[statusbar_handle.idx];
+  if (live.bars[idx].total != 0) {
+    write_lock.unlock();
+    registry_lock.unlock();
+    LogErr(kFilename, sink_handle,
+           "Failed to update statusbar: Bar %zu counts progress, use "
+           "AddStatusbarProgress.",
+           idx);
+    return -9;
+  }
+
+  BarRecord& bar = _bar_arena[statusbar.first_bar + idx];
+  if (bar.child_weight > 0.0) {
+    write_lock.unlock();
+    registry_lock.unlock();
+    LogErr(kFilename, sink_handle,
+           "Failed to update statusbar: Bar %zu shows the progress of its "
+           "children.",
+           idx);
+    return -10;
+  }
+
+  const std::int64_t now_ns = _CoarseNowNs();
+  _SetBarPercent(statusbar_handle.idx, idx, percent, now_ns);
+  live.bars[idx].percent.store(percent, std::memory_order_relaxed);
+  live.bars[idx].updated_ns.store(now_ns, std::memory_order_relaxed);
+  bar.spin_idx = bar.spin_idx + 1;
+
+  StatusbarFrame frame;
+  _BeginFrame(sink_handle, frame);
+  // After a terminal resize all bars are redrawn once, completely.
+  if (_CheckTerminalResized(sink_handle)) {
+    _RedrawStatusbars(sink_handle, write_lock, frame);
+    const bool ancestors_pending =
+        _DrawStaleAncestors(statusbar_handle.idx, idx, write_lock, frame);
+    _CommitFrame(sink_handle, frame);
+    _ConditionalFlush(sink_handle);
+    write_lock.unlock();
+    registry_lock.unlock();
+    if (ancestors_pending) _RenderDirtyStatusbars();
+    return kStatusbarLogSuccess;
+  }
+
+  std::string postfix;
   int bar_error_code = _DrawStatusbarComponent(
-      sink_handle, write_lock, percent, statusbar.bar_sizes[idx],
-      statusbar.prefixes[idx], statusbar.postfixes[idx],
-      statusbar.spin_idxs[idx], statusbar.positions[idx]);
+      sink_handle, write_lock, bar,
+      _ExpandPostfix(statusbar_handle.idx, idx, postfix), frame);
+  bar.stale = false;
+  const bool ancestors_pending =
+      _DrawStaleAncestors(statusbar_handle.idx, idx, write_lock, frame);
+  const int frame_err = _CommitFrame(sink_handle, frame);
+  if (bar_error_code == kStatusbarLogSuccess) bar_error_code = frame_err;
+  _ConditionalFlush(sink_handle);
 
   if (bar_error_code != kStatusbarLogSuccess && !statusbar.error_reported) {
     statusbar.error_reported = true;
@@ -876,15 +2948,132 @@ int UpdateStatusbar(StatusbarHandle& statusbar_handle, const std::size_t idx,
             "Terminal width detection failed (Linux) and truncation was "
             "needed";
         break;
+      default:
+        why = "Unknown _DrawStatusbarComponent error";
+        break;
     }
+    const unsigned int statusbar_id = statusbar_handle.id;
     write_lock.unlock();
     registry_lock.unlock();
     LogErr(kFilename, sink_handle, "%s on statusbar with ID %u at bar idx %zu!",
-           why, statusbar.id, idx);
+           why, statusbar_id, idx);
+    if (ancestors_pending) _RenderDirtyStatusbars();
+    return kStatusbarLogSuccess;
   }
 
   write_lock.unlock();
   registry_lock.unlock();
+  if (ancestors_pending) _RenderDirtyStatusbars();
+  return kStatusbarLogSuccess;
+}
+
+int AddStatusbarProgress(const StatusbarHandle& statusbar_handle,
+                         const std::size_t idx, const std::uint64_t delta) {
+  int err = _IsValidStatusbarHandle(statusbar_handle);
+  if (err != kStatusbarLogSuccess) return err;
+
+  LiveStatusbar& live = _live_statusbars[statusbar_handle.idx];
+  const std::size_t shard = _ProgressShard();
+  std::atomic<std::uint64_t>& users = live.users[shard].value;
+  users.fetch_add(1, std::memory_order_seq_cst);
+  if (_statusbar_registry.Id(statusbar_handle.idx) != statusbar_handle.id) {
+    err = -3;
+  } else if (idx >= live.num_bars) {
+    err = -5;
+  } else if (live.bars[idx].total == 0) {
+    err = -6;
+  } else {
+    live.progress[idx * kProgressShards + shard].value.fetch_add(
+        delta, std::memory_order_seq_cst);
+    // The shared time stamp is written at most once per clock tick.
+    const std::int64_t now_ns = _CoarseNowNs();
+    std::atomic<std::int64_t>& updated_ns = live.bars[idx].updated_ns;
+    if (updated_ns.load(std::memory_order_relaxed) != now_ns) {
+      updated_ns.store(now_ns, std::memory_order_relaxed);
+    }
+    // Only the first update after a frame writes the shared flag. Seeing it
+    // set (seq_cst) means the frame clearing it will also see this update.
+    if (!live.dirty.load(std::memory_order_seq_cst)) {
+      live.dirty.store(true, std::memory_order_seq_cst);
+    }
+  }
+  users.fetch_sub(1, std::memory_order_release);
+  return err;
+}
+
+int SetStatusbarParent(const StatusbarHandle& child_handle,
+                       const std::size_t child_idx,
+                       const StatusbarHandle& parent_handle,
+                       const std::size_t parent_idx, const double weight) {
+  {
+    std::lock_guard<std::mutex> registry_lock(_statusbar_registry_mutex);
+    if (_IsValidStatusbarHandle(child_handle) != kStatusbarLogSuccess) {
+      return -1;
+    }
+    if (_IsValidStatusbarHandle(parent_handle) != kStatusbarLogSuccess) {
+      return -2;
+    }
+    if (child_idx >= _statusbar_registry[child_handle.idx].num_bars ||
+        parent_idx >= _statusbar_registry[parent_handle.idx].num_bars) {
+      return -3;
+    }
+    if (!(weight > 0.0) || !std::isfinite(weight)) return -4;
+
+    // The parent must not be the child or one of its descendants.
+    std::size_t slot_idx = parent_handle.idx;
+    std::size_t bar_idx = parent_idx;
+    while (true) {
+      if (slot_idx == child_handle.idx && bar_idx == child_idx) return -5;
+      const BarLink& link = _Bar(slot_idx, bar_idx).parent;
+      if (link.id == 0 || _statusbar_registry.Id(link.slot_idx) != link.id) {
+        break;
+      }
+      slot_idx = link.slot_idx;
+      bar_idx = link.bar_idx;
+    }
+    BarRecord& child = _Bar(child_handle.idx, child_idx);
+    BarRecord& parent = _Bar(parent_handle.idx, parent_idx);
+    const BarLink& current = child.parent;
+    if (current.id != 0 && _statusbar_registry.Id(current.slot_idx) ==
+                               current.id) {
+      return -6;
+    }
+    if (_live_statusbars[parent_handle.idx].bars[parent_idx].total != 0) {
+      return -7;
+    }
+
+    _SyncLivePercentages(child_handle.idx);
+    // A bar's own percentage is replaced by the mean of its children.
+    if (parent.child_weight == 0.0) {
+      parent.weighted_sum = 0.0;
+      _live_statusbars[parent_handle.idx].bars[parent_idx].derived.store(
+          true, std::memory_order_relaxed);
+    }
+    parent.child_weight += weight;
+    parent.weighted_sum += weight * child.percent;
+    child.parent = {parent_handle.idx, parent_handle.id, parent_idx, weight};
+    _SetBarPercent(
+        parent_handle.idx, parent_idx,
+        std::clamp(parent.weighted_sum / parent.child_weight, 0.0, 100.0),
+        _CoarseNowNs());
+  }
+  _RenderDirtyStatusbars();
+  return kStatusbarLogSuccess;
+}
+
+int GetStatusbarProgress(const StatusbarHandle& statusbar_handle,
+                         const std::size_t idx, StatusbarProgress& progress) {
+  progress = StatusbarProgress{0.0, 0.0, -1.0};
+  std::lock_guard<std::mutex> registry_lock(_statusbar_registry_mutex);
+  const int err = _IsValidStatusbarHandle(statusbar_handle);
+  if (err != kStatusbarLogSuccess) return err;
+  if (idx >= _statusbar_registry[statusbar_handle.idx].num_bars) return -5;
+
+  _SyncLivePercentages(statusbar_handle.idx);
+  const BarRecord& bar = _Bar(statusbar_handle.idx, idx);
+  progress.percent = bar.percent;
+  progress.rate = _BarRate(statusbar_handle.idx, idx);
+  progress.eta_seconds = _BarEtaSeconds(bar);
   return kStatusbarLogSuccess;
 }
 
@@ -0,0 +1,417 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/src/uring_file.cc
+
+// clang-format off
+
+#include "uring_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define STATUSBARLOG_HAVE_IO_URING 1
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <vector>
+#endif
+
+// clang-format on
+
+namespace statusbar_log {
+namespace detail {
+
+#if defined(STATUSBARLOG_HAVE_IO_URING)
+
+struct UringFile {
+  int fd;       ///< The file
+  int ring_fd;  ///< The io_uring instance
+  void* sq_ring;
+  std::size_t sq_ring_size;
+  void* cq_ring;  ///< Same as sq_ring with IORING_FEAT_SINGLE_MMAP
+  std::size_t cq_ring_size;
+  io_uring_sqe* sqes;
+  std::size_t sqes_size;
+  unsigned int* sq_tail;
+  unsigned int* sq_mask;
+  unsigned int* sq_array;
+  unsigned int* cq_head;
+  unsigned int* cq_tail;
+  unsigned int* cq_mask;
+  io_uring_cqe* cqes;
+
+  std::array<std::unique_ptr<char[]>, kUringFileBuffers> buffers;
+  std::array<std::size_t, kUringFileBuffers> lengths;  ///< Bytes per buffer
+  std::array<std::uint64_t, kUringFileBuffers> offsets;  ///< While in flight
+  std::vector<unsigned int> free_buffers;
+  int filling;               ///< Buffer taking new output (-1 if none)
+  unsigned int in_flight;    ///< Submitted writes not completed yet
+  std::uint64_t end;         ///< File offset of the next submitted write
+  bool failed;               ///< A write failed since the last fence
+};
+
+namespace {
+
+int _UringSetup(const unsigned int entries, io_uring_params& params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+/**
+ * \brief Submits `to_submit` entries and/or waits for `min_complete`
+ * completions, retrying after interrupts.
+ */
+bool _UringEnter(const int ring_fd, const unsigned int to_submit,
+                 const unsigned int min_complete) {
+  const unsigned int flags = (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0;
+  while (::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                   flags, nullptr, 0) < 0) {
+    if (errno != EINTR) return false;
+  }
+  return true;
+}
+
+/**
+ * \brief Checks if the kernel supports IORING_OP_WRITE (Linux 5.6), older
+ * kernels don't know the probe either.
+ */
+bool _UringSupportsWrite(const int ring_fd) {
+  constexpr unsigned int kProbeOps = 256;
+  std::vector<char> storage(sizeof(io_uring_probe) +
+                            kProbeOps * sizeof(io_uring_probe_op));
+  io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+  if (::syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe,
+                kProbeOps) < 0) {
+    return false;
+  }
+  return probe->last_op >= IORING_OP_WRITE &&
+         (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+/**
+ * \brief Maps the rings of a freshly set up io_uring instance.
+ *
+ * \return false if a mapping failed (the ones made are undone by
+ * _UringUnmap).
+ */
+bool _UringMap(UringFile& file, const io_uring_params& params) {
+  file.sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+  file.cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    file.sq_ring_size = file.cq_ring_size =
+        std::max(file.sq_ring_size, file.cq_ring_size);
+  }
+
+  file.sq_ring = ::mmap(nullptr, file.sq_ring_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, file.ring_fd,
+                        IORING_OFF_SQ_RING);
+  if (file.sq_ring == MAP_FAILED) return false;
+  if (single_mmap) {
+    file.cq_ring = file.sq_ring;
+  } else {
+    file.cq_ring = ::mmap(nullptr, file.cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, file.ring_fd,
+                          IORING_OFF_CQ_RING);
+    if (file.cq_ring == MAP_FAILED) return false;
+  }
+  file.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = ::mmap(nullptr, file.sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, file.ring_fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) return false;
+  file.sqes = static_cast<io_uring_sqe*>(sqes);
+
+  char* sq = static_cast<char*>(file.sq_ring);
+  char* cq = static_cast<char*>(file.cq_ring);
+  file.sq_tail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+  file.sq_mask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+  file.sq_array = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+  file.cq_head = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+  file.cq_tail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+  file.cq_mask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+  file.cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  return true;
+}
+
+void _UringUnmap(UringFile& file) {
+  if (file.sqes) ::munmap(file.sqes, file.sqes_size);
+  if (file.cq_ring && file.cq_ring != MAP_FAILED &&
+      file.cq_ring != file.sq_ring) {
+    ::munmap(file.cq_ring, file.cq_ring_size);
+  }
+  if (file.sq_ring && file.sq_ring != MAP_FAILED) {
+    ::munmap(file.sq_ring, file.sq_ring_size);
+  }
+}
+
+/**
+ * \brief Writes the rest of a short write synchronously (rare for regular
+ * files).
+ */
+bool _CompleteShortWrite(UringFile& file, const unsigned int buffer,
+                         std::size_t done) {
+  while (done < file.lengths[buffer]) {
+    const ssize_t rc =
+        ::pwrite(file.fd, file.buffers[buffer].get() + done,
+                 file.lengths[buffer] - done,
+                 static_cast<off_t>(file.offsets[buffer] + done));
+    if (rc < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    done += static_cast<std::size_t>(rc);
+  }
+  return true;
+}
+
+/**
+ * \brief Takes the completions off the ring and frees their buffers, waiting
+ * for at least `min_complete` of them.
+ *
+ * \return false if waiting failed.
+ */
+bool _UringReap(UringFile& file, const unsigned int min_complete) {
+  if (min_complete > 0 && !_UringEnter(file.ring_fd, 0, min_complete)) {
+    file.failed = true;
+    return false;
+  }
+
+  // The kernel publishes completions with the tail, this thread alone moves
+  // the head.
+  unsigned int head = *file.cq_head;
+  const unsigned int tail =
+      std::atomic_ref<unsigned int>(*file.cq_tail).load(
+          std::memory_order_acquire);
+  for (; head != tail; ++head) {
+    const io_uring_cqe& cqe = file.cqes[head & *file.cq_mask];
+    const unsigned int buffer = static_cast<unsigned int>(cqe.user_data);
+    // Writes still waiting when the submitting thread exits are canceled by
+    // the kernel, they are done synchronously instead.
+    const std::size_t done =
+        (cqe.res == -ECANCELED) ? 0 : static_cast<std::size_t>(cqe.res);
+    if ((cqe.res < 0 && cqe.res != -ECANCELED) ||
+        !_CompleteShortWrite(file, buffer, done)) {
+      file.failed = true;
+    }
+    file.free_buffers.push_back(buffer);
+    --file.in_flight;
+  }
+  std::atomic_ref<unsigned int>(*file.cq_head)
+      .store(head, std::memory_order_release);
+  return true;
+}
+
+/**
+ * \brief Submits the buffer being filled as one write at the end of the file.
+ */
+void _UringSubmitFilling(UringFile& file) {
+  const unsigned int buffer = static_cast<unsigned int>(file.filling);
+  file.filling = -1;
+  file.offsets[buffer] = file.end;
+  file.end += file.lengths[buffer];
+
+  // At most kUringFileBuffers writes are in flight, the ring has room for
+  // them.
+  const unsigned int tail = *file.sq_tail;
+  const unsigned int idx = tail & *file.sq_mask;
+  io_uring_sqe& sqe = file.sqes[idx];
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = IORING_OP_WRITE;
+  sqe.fd = file.fd;
+  sqe.addr = reinterpret_cast<std::uint64_t>(file.buffers[buffer].get());
+  sqe.len = static_cast<std::uint32_t>(file.lengths[buffer]);
+  sqe.off = file.offsets[buffer];
+  sqe.user_data = buffer;
+  file.sq_array[idx] = idx;
+  std::atomic_ref<unsigned int>(*file.sq_tail)
+      .store(tail + 1, std::memory_order_release);
+  ++file.in_flight;
+
+  if (!_UringEnter(file.ring_fd, 1, 0)) {
+    // Not submitted, write it directly and release the ring entry again.
+    std::atomic_ref<unsigned int>(*file.sq_tail)
+        .store(tail, std::memory_order_release);
+    --file.in_flight;
+    if (!_CompleteShortWrite(file, buffer, 0)) file.failed = true;
+    file.free_buffers.push_back(buffer);
+  }
+}
+
+}  // namespace
+
+UringFile* OpenUringFile(const std::string& path, int& err) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  const int ring_fd = _UringSetup(kUringFileBuffers, params);
+  if (ring_fd < 0) {
+    err = -1;
+    return nullptr;
+  }
+  if (!_UringSupportsWrite(ring_fd)) {
+    ::close(ring_fd);
+    err = -1;
+    return nullptr;
+  }
+
+  std::unique_ptr<UringFile> file(new UringFile());
+  file->ring_fd = ring_fd;
+  file->fd = -1;
+  if (!_UringMap(*file, params)) {
+    _UringUnmap(*file);
+    ::close(ring_fd);
+    err = -1;
+    return nullptr;
+  }
+
+  file->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+  struct stat st;
+  if (file->fd < 0 || ::fstat(file->fd, &st) != 0) {
+    if (file->fd >= 0) ::close(file->fd);
+    _UringUnmap(*file);
+    ::close(ring_fd);
+    err = -2;
+    return nullptr;
+  }
+  file->end = static_cast<std::uint64_t>(st.st_size);
+
+  for (unsigned int i = 0; i < kUringFileBuffers; ++i) {
+    file->buffers[i] = std::make_unique<char[]>(kUringFileBufferSize);
+    file->free_buffers.push_back(i);
+  }
+  file->filling = -1;
+  file->in_flight = 0;
+  file->failed = false;
+  err = 0;
+  return file.release();
+}
+
+bool UringFileWrite(UringFile* file, const char* buf, std::size_t len) {
+  while (len > 0) {
+    if (file->filling < 0) {
+      if (file->free_buffers.empty() && !_UringReap(*file, 1)) return false;
+      file->filling = static_cast<int>(file->free_buffers.back());
+      file->free_buffers.pop_back();
+      file->lengths[file->filling] = 0;
+    }
+    std::size_t& length = file->lengths[file->filling];
+    const std::size_t n = std::min(len, kUringFileBufferSize - length);
+    std::memcpy(file->buffers[file->filling].get() + length, buf, n);
+    length += n;
+    buf += n;
+    len -= n;
+    if (length == kUringFileBufferSize) {
+      _UringSubmitFilling(*file);
+      _UringReap(*file, 0);
+    }
+  }
+  return !file->failed;
+}
+
+bool UringFileSubmit(UringFile* file) {
+  if (file->filling >= 0 && file->lengths[file->filling] > 0) {
+    _UringSubmitFilling(*file);
+  }
+  _UringReap(*file, 0);
+  return !file->failed;
+}
+
+bool UringFileFence(UringFile* file) {
+  if (file->filling >= 0) {
+    if (file->lengths[file->filling] > 0) {
+      _UringSubmitFilling(*file);
+    } else {
+      file->free_buffers.push_back(static_cast<unsigned int>(file->filling));
+      file->filling = -1;
+    }
+  }
+  while (file->in_flight > 0) {
+    if (!_UringReap(*file, file->in_flight)) break;
+  }
+  const bool ok = !file->failed;
+  file->failed = false;
+  return ok;
+}
+
+bool UringFileTruncate(UringFile* file, const std::uint64_t size) {
+  bool ok = UringFileFence(file);
+  if (::ftruncate(file->fd, static_cast<off_t>(size)) != 0) return false;
+  file->end = size;
+  return ok;
+}
+
+bool CloseUringFile(UringFile* file) {
+  bool ok = UringFileFence(file);
+  _UringUnmap(*file);
+  ::close(file->ring_fd);
+  ok = (::close(file->fd) == 0) && ok;
+  delete file;
+  return ok;
+}
+
+#else  // !defined(STATUSBARLOG_HAVE_IO_URING)
+
+struct UringFile {};
+
+UringFile* OpenUringFile(const std::string& path, int& err) {
+  (void)path;
+  err = -1;
+  return nullptr;
+}
+
+bool UringFileWrite(UringFile* file, const char* buf, std::size_t len) {
+  (void)file;
+  (void)buf;
+  (void)len;
+  return false;
+}
+
+bool UringFileSubmit(UringFile* file) {
+  (void)file;
+  return false;
+}
+
+bool UringFileFence(UringFile* file) {
+  (void)file;
+  return false;
+}
+
+bool UringFileTruncate(UringFile* file, std::uint64_t size) {
+  (void)file;
+  (void)size;
+  return false;
+}
+
+bool CloseUringFile(UringFile* file) {
+  delete file;
+  return true;
+}
+
+#endif  // defined(STATUSBARLOG_HAVE_IO_URING)
+
+}  // namespace detail
+}  // namespace statusbar_log
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/src/uring_file.h
+
+#ifndef STATUSBARLOG_URING_FILE_H_
+#define STATUSBARLOG_URING_FILE_H_
+
+// clang-format off
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// clang-format on
+
+/**
+ * \file uring_file.h
+ * \brief Appending file writer submitting its writes through io_uring, used
+ * by statusbar_log::sink::kSinkUringFile sinks.
+ *
+ * Output is copied into a small pool of buffers. A full buffer is submitted as
+ * one write at the next file offset and the caller continues without waiting
+ * for the disk. Completions are reaped on later writes and in UringFileSubmit;
+ * the caller only blocks once all buffers are in flight, or in UringFileFence.
+ *
+ * Writes go to the end of the file as it was at open, tracked by the
+ * UringFile itself: the file must have no other writer while it is open.
+ *
+ * The ring is set up with the raw io_uring syscalls (Linux 5.6 or newer for
+ * IORING_OP_WRITE), no liburing is needed. On other platforms OpenUringFile
+ * always reports io_uring as unavailable.
+ *
+ * None of the functions are thread safe, the sink serializes the calls.
+ */
+
+namespace statusbar_log {
+namespace detail {
+
+/// io_uring backed file, see OpenUringFile.
+typedef struct UringFile UringFile;
+
+/// Number of buffers (and ring entries) of a UringFile.
+constexpr unsigned int kUringFileBuffers = 8;
+/// Size of each buffer, the largest write submitted at once.
+constexpr std::size_t kUringFileBufferSize = std::size_t{64} << 10;
+
+/**
+ * \brief Opens (or creates) `path` for appending through a new io_uring
+ * instance.
+ *
+ * \param[in] path File to open.
+ * \param[out] err 0 on success, -1 if io_uring (with IORING_OP_WRITE) is not
+ * available, -2 if the file could not be opened.
+ *
+ * \return The file, or nullptr on error.
+ */
+UringFile* OpenUringFile(const std::string& path, int& err);
+
+/**
+ * \brief Appends `len` bytes. Returns once the bytes are copied, full buffers
+ * are submitted but not waited for.
+ *
+ * \return false if a write failed (since the last fence).
+ */
+bool UringFileWrite(UringFile* file, const char* buf, std::size_t len);
+
+/**
+ * \brief Submits the buffered output and reaps the completions that are
+ * already there, without waiting for the disk.
+ *
+ * \return false if a write failed (since the last fence).
+ */
+bool UringFileSubmit(UringFile* file);
+
+/**
+ * \brief Submits the buffered output and waits until every submitted write
+ * has completed.
+ *
+ * \return false if a write failed since the last fence.
+ */
+bool UringFileFence(UringFile* file);
+
+/**
+ * \brief Fences, then truncates the file to `size` bytes. Later writes
+ * continue at `size`.
+ *
+ * \return false if a write or the truncation failed.
+ */
+bool UringFileTruncate(UringFile* file, std::uint64_t size);
+
+/**
+ * \brief Fences, then closes the file and the ring and frees `file`.
+ *
+ * \return false if a write failed or the file could not be closed.
+ */
+bool CloseUringFile(UringFile* file);
+
+}  // namespace detail
+}  // namespace statusbar_log
+
+#endif  // STATUSBARLOG_URING_FILE_H_
@@ -22,6 +22,7 @@
 #include <unistd.h>
 
 #include <atomic>
+#include <cstddef>
 #include <cstring>
 
 #include "statusbarlog/statusbarlog.h"
@@ -42,6 +43,21 @@ void SetupTestOutputDirectory();
 std::string GenerateTestLogFilename(const std::string& test_suite,
                                     const std::string& test_name);
 
+/**
+ * \brief Path of a file a test writes itself (e.g. the file of a file sink),
+ * unique per test: `<test_output_dir>/<suite>_<name><suffix>`.
+ *
+ * Creates test_output_dir if needed.
+ */
+std::string GenerateTestOutputFilename(const std::string& test_suite,
+                                       const std::string& test_name,
+                                       const std::string& suffix);
+
+/**
+ * \brief Reads the whole file at `path` ("" if it can't be opened).
+ */
+std::string ReadFileContents(const std::string& path);
+
 int RedirectCreateStatusbarHandle(
     statusbar_log::StatusbarHandle& statusbar_handle,
     const statusbar_log::sink::SinkHandle& sink_handle,
@@ -70,6 +86,18 @@ int RedirectToStrLog(std::string& capture_stdout,
 
 std::string StripAnsiEscapeSequences(const std::string& s);
 
+/**
+ * \brief Starts counting the heap allocations (global operator new) made by
+ * the calling thread.
+ */
+void StartCountingAllocations();
+
+/**
+ * \brief Stops counting and returns the number of heap allocations made by the
+ * calling thread since StartCountingAllocations().
+ */
+std::size_t StopCountingAllocations();
+
 }  // namespace test
 }  // namespace statusbar_log
 
@@ -16,11 +16,31 @@
 
 // clang-format off
 
+#include <fcntl.h>
 #include <gtest/gtest.h>
-
-#include <vector>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "line_diff.h"
+#include "sanitize.h"
+#include "slot_map.h"
+#include "statusbarlog/binary_log.h"
 #include "statusbarlog/statusbarlog.h"
 #include "statusbarlog/sink.h"
 #include "statusbarlog_test.h"
@@ -42,12 +62,62 @@ class StatusbarTestBase : public ::testing::Test {
     return statusbar_log::test::GenerateTestLogFilename(
         test_info->test_suite_name(), test_info->name());
   }
+  std::string GetTestOutputFilename(const std::string& suffix) {
+    const auto* test_info =
+        ::testing::UnitTest::GetInstance()->current_test_info();
+    return statusbar_log::test::GenerateTestOutputFilename(
+        test_info->test_suite_name(), test_info->name(), suffix);
+  }
   void SetUp() override { statusbar_log::sink::CreateSinkStdout(sink_handle_); }
   void TearDown() override {
     statusbar_log::sink::DestroySinkHandle(sink_handle_);
   }
 };
 
+// ==================================================
+// Base Test Fixture for tests writing to a file sink
+// ==================================================
+
+class FileSinkTestBase : public StatusbarTestBase {
+ protected:
+  statusbar_log::sink::SinkHandle file_sink_handle_{};
+  std::string path_;  ///< File of the test, removed before and after it
+
+  void SetUp() override {
+    this->path_ = this->GetTestOutputFilename(".txt");
+    std::filesystem::remove(this->path_);
+  }
+  void TearDown() override {
+    if (this->file_sink_handle_.valid) {
+      statusbar_log::sink::DestroySinkHandle(this->file_sink_handle_);
+    }
+    std::filesystem::remove(this->path_);
+  }
+
+  /// Creates file_sink_handle_ as a plain file sink writing to path_.
+  void CreateFileSink() {
+    ASSERT_EQ(statusbar_log::sink::CreateSinkFile(this->file_sink_handle_,
+                                                  this->path_),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+
+  /// Flushes the sink (if still alive) and reads the whole file.
+  std::string ReadFile() {
+    if (this->file_sink_handle_.valid) {
+      statusbar_log::sink::FlushSinkHandle(this->file_sink_handle_);
+    }
+    return statusbar_log::test::ReadFileContents(this->path_);
+  }
+
+  std::vector<std::string> ReadLines() {
+    std::istringstream in(this->ReadFile());
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+    return lines;
+  }
+};
+
 // ==================================================
 // HandleManagementTest
 // ==================================================
@@ -373,6 +443,42 @@ TEST_F(HandleManagementTest, DestroyAlreadyDestroyedHandle) {
       << "Should not be able to destroy already destroyed handle";
 }
 
+TEST_F(HandleManagementTest, ConcurrentDestroyFreesSlotOnce) {
+  statusbar_log::StatusbarHandle handle;
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(handle, this->sink_handle_,
+                                                 {1}, {10}, {"a"}, {"b"}),
+            statusbar_log::kStatusbarLogSuccess);
+
+  // Every thread destroys its own copy of the same handle.
+  constexpr int kThreads = 4;
+  std::vector<statusbar_log::StatusbarHandle> copies(kThreads, handle);
+  std::atomic<int> destroyed{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      if (statusbar_log::DestroyStatusbarHandle(copies[t]) ==
+          statusbar_log::kStatusbarLogSuccess) {
+        destroyed.fetch_add(1);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(destroyed.load(), 1);
+
+  // A slot freed twice would be handed out to both new statusbars.
+  statusbar_log::StatusbarHandle first;
+  statusbar_log::StatusbarHandle second;
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(first, this->sink_handle_, {1},
+                                                 {10}, {"a"}, {"b"}),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(second, this->sink_handle_,
+                                                 {2}, {10}, {"a"}, {"b"}),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_NE(first.idx, second.idx);
+  statusbar_log::DestroyStatusbarHandle(first);
+  statusbar_log::DestroyStatusbarHandle(second);
+}
+
 // ==================================================
 // StatusbarUpdateTest
 // ==================================================
@@ -778,6 +884,2394 @@ TEST_F(LogTest, LogFormatStringTest) {
                "\n");
 }
 
+TEST_F(LogTest, SynchronousLogDoesNotAllocate) {
+  const std::string path = this->GetTestOutputFilename(".txt");
+  std::filesystem::remove(path);
+  statusbar_log::sink::SinkHandle file_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkFile(file_sink_handle, path),
+            statusbar_log::kStatusbarLogSuccess);
+  const char* name = "worker";
+
+  // The first call may set up the stream buffer of the sink.
+  ASSERT_EQ(statusbar_log::LogErr(kFilename, file_sink_handle, "warm up"),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::test::StartCountingAllocations();
+  for (int i = 0; i < 100; ++i) {
+    statusbar_log::LogErr(kFilename, file_sink_handle,
+                          "%s %d finished with %.2f%%\t\x01", name, i,
+                          i * 0.5);
+  }
+  const std::size_t allocations =
+      statusbar_log::test::StopCountingAllocations();
+  EXPECT_EQ(allocations, 0u) << "LogV allocated on the synchronous path";
+
+  statusbar_log::sink::FlushSinkHandle(file_sink_handle);
+  std::istringstream in(statusbar_log::test::ReadFileContents(path));
+  std::string line;
+  std::getline(in, line);
+  std::getline(in, line);
+  EXPECT_EQ(line,
+            "ERROR [statusbarlog_test.cc]: worker 0 finished with "
+            "0.00%\t\xEF\xBF\xBD");
+
+  statusbar_log::sink::DestroySinkHandle(file_sink_handle);
+  std::filesystem::remove(path);
+}
+
+#if defined(__cpp_lib_format)
+class LogFmtTest : public FileSinkTestBase {
+ protected:
+  void SetUp() override {
+    FileSinkTestBase::SetUp();
+    this->CreateFileSink();
+  }
+};
+
+TEST_F(LogFmtTest, MatchesPrintfOutput) {
+  EXPECT_EQ(statusbar_log::LogFmt<statusbar_log::kLogLevelWrn>(
+                kFilename, this->file_sink_handle_,
+                "int:{} s:{} f:{:.2f} c:{}", -1, std::string("ok"), 3.14159,
+                'Z'),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::LogWrn(kFilename, this->file_sink_handle_,
+                        "int:%i s:%s f:%.2f c:%c", -1, "ok", 3.14159, 'Z');
+  EXPECT_EQ(this->ReadFile(),
+            "WARNING [statusbarlog_test.cc]: int:-1 s:ok f:3.14 c:Z\n"
+            "WARNING [statusbarlog_test.cc]: int:-1 s:ok f:3.14 c:Z\n");
+}
+
+TEST_F(LogFmtTest, DiscardsMessagesAboveLogLevel) {
+  EXPECT_EQ(
+      statusbar_log::LogDbgFmt(kFilename, this->file_sink_handle_, "{}", 1),
+      statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "");
+}
+
+TEST_F(LogFmtTest, TruncatesAndSanitizes) {
+  const std::string long_message(statusbar_log::kMaxLogLength + 100, 'x');
+  statusbar_log::LogErrFmt(kFilename, this->file_sink_handle_, "{}",
+                           long_message);
+  statusbar_log::LogErrFmt(kFilename, this->file_sink_handle_, "a{}b",
+                           '\x1b');
+  EXPECT_EQ(this->ReadFile(),
+            "ERROR [statusbarlog_test.cc]: " +
+                long_message.substr(0, statusbar_log::kMaxLogLength) +
+                "\nERROR [statusbarlog_test.cc]: a\xEF\xBF\xBD"
+                "b\n");
+}
+#endif  // defined(__cpp_lib_format)
+
+// ==================================================
+// Runtime log levels
+// ==================================================
+
+class RuntimeLogLevelTest : public FileSinkTestBase {
+ protected:
+  void SetUp() override {
+    FileSinkTestBase::SetUp();
+    this->CreateFileSink();
+  }
+  void TearDown() override {
+    statusbar_log::ResetLogLevels();
+    FileSinkTestBase::TearDown();
+  }
+};
+
+TEST_F(RuntimeLogLevelTest, GlobalLevelFiltersMessages) {
+  ASSERT_EQ(statusbar_log::SetLogLevel(statusbar_log::kLogLevelErr),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::GetLogLevel(), statusbar_log::kLogLevelErr);
+  statusbar_log::LogWrn(kFilename, this->file_sink_handle_, "filtered");
+  statusbar_log::LogErr(kFilename, this->file_sink_handle_, "kept");
+
+  ASSERT_EQ(statusbar_log::SetLogLevel(statusbar_log::kLogLevelInf),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "kept again");
+
+  EXPECT_EQ(this->ReadLines(),
+            (std::vector<std::string>{
+                "ERROR [statusbarlog_test.cc]: kept",
+                "INFO [statusbarlog_test.cc]: kept again"}));
+}
+
+TEST_F(RuntimeLogLevelTest, LevelsCannotExceedCompileTimeCeiling) {
+  EXPECT_EQ(statusbar_log::SetLogLevel(statusbar_log::kLogLevelDbg), -1);
+  EXPECT_EQ(statusbar_log::SetSinkLogLevel(this->file_sink_handle_,
+                                           statusbar_log::kLogLevelDbg),
+            -1);
+  EXPECT_EQ(
+      statusbar_log::SetModuleLogLevel(kFilename, statusbar_log::kLogLevelDbg),
+      -1);
+  EXPECT_EQ(statusbar_log::GetLogLevel(), statusbar_log::kLogLevel);
+}
+
+TEST_F(RuntimeLogLevelTest, ModuleOverridesSinkOverridesGlobal) {
+  ASSERT_EQ(statusbar_log::SetLogLevel(statusbar_log::kLogLevelOff),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::SetSinkLogLevel(this->file_sink_handle_,
+                                           statusbar_log::kLogLevelWrn),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::SetModuleLogLevel("verbose.cc",
+                                             statusbar_log::kLogLevelInf),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::SetModuleLogLevel("quiet.cc",
+                                             statusbar_log::kLogLevelOff),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "sink filtered");
+  statusbar_log::LogWrn(kFilename, this->file_sink_handle_, "sink kept");
+  statusbar_log::LogInf("verbose.cc", this->file_sink_handle_, "module kept");
+  statusbar_log::LogErr("quiet.cc", this->file_sink_handle_,
+                        "module filtered");
+
+  ASSERT_EQ(statusbar_log::ClearModuleLogLevel("quiet.cc"),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::ClearModuleLogLevel("quiet.cc"), -1);
+  statusbar_log::LogErr("quiet.cc", this->file_sink_handle_, "sink again");
+
+  ASSERT_EQ(statusbar_log::ClearSinkLogLevel(this->file_sink_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::LogErr(kFilename, this->file_sink_handle_, "global filtered");
+
+  EXPECT_EQ(this->ReadLines(),
+            (std::vector<std::string>{
+                "WARNING [statusbarlog_test.cc]: sink kept",
+                "INFO [verbose.cc]: module kept",
+                "ERROR [quiet.cc]: sink again"}));
+}
+
+TEST_F(RuntimeLogLevelTest, LevelsChangeWhileLogging) {
+  std::atomic<bool> done = false;
+  std::thread toggler([&done] {
+    while (!done.load()) {
+      statusbar_log::SetLogLevel(statusbar_log::kLogLevelErr);
+      statusbar_log::SetModuleLogLevel("toggled.cc",
+                                       statusbar_log::kLogLevelInf);
+      statusbar_log::ResetLogLevels();
+    }
+  });
+  for (int i = 0; i < 500; ++i) {
+    statusbar_log::LogErr("toggled.cc", this->file_sink_handle_, "line %d", i);
+  }
+  done = true;
+  toggler.join();
+
+  EXPECT_EQ(this->ReadLines().size(), 500u)
+      << "Errors are enabled by every level set in this test";
+}
+
+// ==================================================
+// Statusbar redraw frames
+// ==================================================
+
+class RedrawIntervalTest : public FileSinkTestBase {
+ protected:
+  statusbar_log::StatusbarHandle statusbar_handle_{};
+
+  void SetUp() override {
+    FileSinkTestBase::SetUp();
+    this->CreateFileSink();
+    ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                  this->statusbar_handle_, this->file_sink_handle_, {1}, {10},
+                  {"redraw_bar"}, {""}),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+  void TearDown() override {
+    statusbar_log::SetStatusbarRedrawInterval(0);
+    statusbar_log::DestroyStatusbarHandle(this->statusbar_handle_);
+    FileSinkTestBase::TearDown();
+  }
+
+  static std::size_t CountBarDraws(const std::string& content) {
+    std::size_t count = 0;
+    for (std::size_t pos = content.find("redraw_bar"); pos != std::string::npos;
+         pos = content.find("redraw_bar", pos + 1)) {
+      ++count;
+    }
+    return count;
+  }
+};
+
+TEST_F(RedrawIntervalTest, ZeroIntervalRedrawsAfterEveryLine) {
+  EXPECT_EQ(statusbar_log::GetStatusbarRedrawInterval(), 0u);
+  const std::size_t draws_before = CountBarDraws(this->ReadFile());
+
+  for (int i = 0; i < 20; ++i) {
+    statusbar_log::LogInf(kFilename, this->file_sink_handle_, "line %d", i);
+  }
+
+  EXPECT_EQ(CountBarDraws(this->ReadFile()) - draws_before, 20u);
+}
+
+TEST_F(RedrawIntervalTest, FramesCoalesceRedraws) {
+  ASSERT_EQ(statusbar_log::SetStatusbarRedrawInterval(60000),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::GetStatusbarRedrawInterval(), 60000u);
+  const std::size_t draws_before = CountBarDraws(this->ReadFile());
+
+  for (int i = 0; i < 100; ++i) {
+    statusbar_log::LogInf(kFilename, this->file_sink_handle_, "line %d", i);
+  }
+
+  std::string content = this->ReadFile();
+  EXPECT_NE(content.find("INFO [statusbarlog_test.cc]: line 99\n"),
+            std::string::npos)
+      << "Log lines are written immediately";
+  EXPECT_EQ(CountBarDraws(content) - draws_before, 1u)
+      << "Only the first line starts a frame within the interval";
+
+  EXPECT_EQ(statusbar_log::FlushStatusbarRedraws(),
+            statusbar_log::kStatusbarLogSuccess);
+  content = this->ReadFile();
+  EXPECT_EQ(CountBarDraws(content) - draws_before, 2u);
+  EXPECT_GT(content.rfind("redraw_bar"), content.find("line 99"));
+}
+
+TEST_F(RedrawIntervalTest, PendingFrameIsDrawnAfterBurst) {
+  ASSERT_EQ(statusbar_log::SetStatusbarRedrawInterval(20),
+            statusbar_log::kStatusbarLogSuccess);
+
+  for (int i = 0; i < 50; ++i) {
+    statusbar_log::LogInf(kFilename, this->file_sink_handle_, "line %d", i);
+  }
+
+  // The scheduler thread draws the trailing frame about 20ms later.
+  std::string content;
+  for (int attempt = 0; attempt < 200; ++attempt) {
+    content = this->ReadFile();
+    if (content.rfind("redraw_bar") > content.find("line 49")) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_NE(content.find("line 49"), std::string::npos);
+  EXPECT_GT(content.rfind("redraw_bar"), content.find("line 49"));
+}
+
+TEST_F(RedrawIntervalTest, PendingFrameIsDrawnAtExit) {
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  const std::string path = this->GetTestOutputFilename("_exit.txt");
+  std::filesystem::remove(path);
+
+  // The child exits within the interval, with the last frame still pending.
+  EXPECT_EXIT(
+      {
+        statusbar_log::sink::SinkHandle sink_handle;
+        statusbar_log::sink::CreateSinkFile(sink_handle, path);
+        statusbar_log::StatusbarHandle handle;
+        statusbar_log::CreateStatusbarHandle(handle, sink_handle, {1}, {10},
+                                             {"redraw_bar"}, {""});
+        statusbar_log::SetStatusbarRedrawInterval(60000);
+        for (int i = 0; i < 100; ++i) {
+          statusbar_log::LogInf(kFilename, sink_handle, "line %d", i);
+        }
+        std::exit(0);
+      },
+      ::testing::ExitedWithCode(0), "");
+
+  const std::string content = statusbar_log::test::ReadFileContents(path);
+  std::filesystem::remove(path);
+  ASSERT_NE(content.find("line 99"), std::string::npos);
+  EXPECT_GT(content.rfind("redraw_bar"), content.find("line 99"))
+      << "The pending frame was not drawn at exit";
+}
+
+TEST_F(RedrawIntervalTest, RejectsTooLargeInterval) {
+  EXPECT_EQ(statusbar_log::SetStatusbarRedrawInterval(
+                statusbar_log::kMaxStatusbarRedrawInterval + 1),
+            -1);
+  EXPECT_EQ(statusbar_log::GetStatusbarRedrawInterval(), 0u);
+}
+
+// ==================================================
+// Statusbar render thread
+// ==================================================
+
+class StatusbarRenderRateTest : public RedrawIntervalTest {
+ protected:
+  void TearDown() override {
+    statusbar_log::SetStatusbarRenderRate(0);
+    RedrawIntervalTest::TearDown();
+  }
+};
+
+TEST_F(StatusbarRenderRateTest, UpdatesAreDrawnWithTheNextFrame) {
+  // The first frame of a 1 Hz render thread is due in a second.
+  ASSERT_EQ(statusbar_log::SetStatusbarRenderRate(1),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::GetStatusbarRenderRate(), 1u);
+  const std::size_t draws_before = CountBarDraws(this->ReadFile());
+
+  for (int i = 0; i <= 50; ++i) {
+    ASSERT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, i),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+  EXPECT_EQ(CountBarDraws(this->ReadFile()), draws_before)
+      << "Updates only store the percentage";
+
+  EXPECT_EQ(statusbar_log::FlushStatusbarRedraws(),
+            statusbar_log::kStatusbarLogSuccess);
+  const std::string content = this->ReadFile();
+  EXPECT_EQ(CountBarDraws(content) - draws_before, 1u)
+      << "All updates since the last frame are drawn once";
+  EXPECT_NE(content.find(" 50.00"), std::string::npos);
+
+  EXPECT_EQ(statusbar_log::FlushStatusbarRedraws(),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(CountBarDraws(this->ReadFile()) - draws_before, 1u)
+      << "Frames without updates draw nothing";
+}
+
+TEST_F(StatusbarRenderRateTest, RenderThreadDrawsLatestPercentage) {
+  ASSERT_EQ(statusbar_log::SetStatusbarRenderRate(50),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 42.0),
+            statusbar_log::kStatusbarLogSuccess);
+
+  std::string content;
+  for (int attempt = 0; attempt < 200; ++attempt) {
+    content = this->ReadFile();
+    if (content.find(" 42.00") != std::string::npos) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_NE(content.find(" 42.00"), std::string::npos);
+}
+
+TEST_F(StatusbarRenderRateTest, LogLinesRedrawLatestPercentage) {
+  ASSERT_EQ(statusbar_log::SetStatusbarRenderRate(1),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 37.0),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "render line");
+
+  const std::string content = this->ReadFile();
+  ASSERT_NE(content.find("render line"), std::string::npos);
+  EXPECT_GT(content.find(" 37.00"), content.find("render line"));
+}
+
+TEST_F(StatusbarRenderRateTest, StoppingDrawsLastFrame) {
+  ASSERT_EQ(statusbar_log::SetStatusbarRenderRate(1),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 64.0),
+            statusbar_log::kStatusbarLogSuccess);
+
+  ASSERT_EQ(statusbar_log::SetStatusbarRenderRate(0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::GetStatusbarRenderRate(), 0u);
+  EXPECT_NE(this->ReadFile().find(" 64.00"), std::string::npos);
+}
+
+TEST_F(StatusbarRenderRateTest, InvalidUpdatesAreStillRejected) {
+  ASSERT_EQ(statusbar_log::SetStatusbarRenderRate(60),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 101.0),
+            -7);
+  EXPECT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 1, 10.0),
+            -8);
+}
+
+TEST_F(StatusbarRenderRateTest, DestroyWhileUpdating) {
+  ASSERT_EQ(statusbar_log::SetStatusbarRenderRate(60),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::StatusbarHandle handle = this->statusbar_handle_;
+  std::atomic<bool> started{false};
+  int update_err = statusbar_log::kStatusbarLogSuccess;
+  std::thread updater([&] {
+    for (std::size_t i = 0; update_err == statusbar_log::kStatusbarLogSuccess;
+         ++i) {
+      update_err = statusbar_log::UpdateStatusbar(handle, 0, i % 101);
+      started.store(true);
+    }
+  });
+  while (!started.load()) std::this_thread::yield();
+
+  EXPECT_EQ(statusbar_log::DestroyStatusbarHandle(this->statusbar_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+  updater.join();
+  EXPECT_NE(update_err, statusbar_log::kStatusbarLogSuccess)
+      << "Updates through the destroyed handle fail";
+}
+
+TEST_F(StatusbarRenderRateTest, RejectsTooHighRate) {
+  EXPECT_EQ(statusbar_log::SetStatusbarRenderRate(
+                statusbar_log::kMaxStatusbarRenderRate + 1),
+            -1);
+  EXPECT_EQ(statusbar_log::GetStatusbarRenderRate(), 0u);
+}
+
+// ==================================================
+// Statusbar progress counters
+// ==================================================
+
+class StatusbarProgressTest : public FileSinkTestBase {
+ protected:
+  statusbar_log::StatusbarHandle statusbar_handle_{};
+
+  void SetUp() override {
+    FileSinkTestBase::SetUp();
+    this->CreateFileSink();
+    ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                  this->statusbar_handle_, this->file_sink_handle_, {2, 1},
+                  {10, 10}, {"counted", "percent"}, {"", ""}, {16000, 0}),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+  void TearDown() override {
+    statusbar_log::SetStatusbarRenderRate(0);
+    statusbar_log::DestroyStatusbarHandle(this->statusbar_handle_);
+    FileSinkTestBase::TearDown();
+  }
+};
+
+TEST_F(StatusbarProgressTest, CountsFromManyThreads) {
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 8; ++t) {
+    workers.emplace_back([this] {
+      for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(statusbar_log::AddStatusbarProgress(this->statusbar_handle_,
+                                                      0, 1),
+                  statusbar_log::kStatusbarLogSuccess);
+      }
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+  EXPECT_EQ(this->ReadFile().find(" 50.00"), std::string::npos)
+      << "Adding progress doesn't draw";
+
+  EXPECT_EQ(statusbar_log::FlushStatusbarRedraws(),
+            statusbar_log::kStatusbarLogSuccess);
+  // The spinner character depends on the time of the frame.
+  const std::string content = this->ReadFile();
+  EXPECT_NE(content.find("counted[#####"), std::string::npos);
+  EXPECT_NE(content.find("    ]  50.00"), std::string::npos);
+}
+
+TEST_F(StatusbarProgressTest, RenderThreadDrawsCounts) {
+  ASSERT_EQ(statusbar_log::SetStatusbarRenderRate(50),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(
+      statusbar_log::AddStatusbarProgress(this->statusbar_handle_, 0, 4000),
+      statusbar_log::kStatusbarLogSuccess);
+
+  std::string content;
+  for (int attempt = 0; attempt < 200; ++attempt) {
+    content = this->ReadFile();
+    if (content.find(" 25.00") != std::string::npos) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_NE(content.find(" 25.00"), std::string::npos);
+}
+
+TEST_F(StatusbarProgressTest, ProgressIsCappedAtTotal) {
+  ASSERT_EQ(
+      statusbar_log::AddStatusbarProgress(this->statusbar_handle_, 0, 20000),
+      statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "progress line");
+
+  const std::string content = this->ReadFile();
+  EXPECT_GT(content.find("counted[##########] 100.00"),
+            content.find("progress line"));
+}
+
+TEST_F(StatusbarProgressTest, RejectsMismatchedBars) {
+  EXPECT_EQ(
+      statusbar_log::AddStatusbarProgress(this->statusbar_handle_, 1, 10), -6)
+      << "Bar without a total";
+  EXPECT_EQ(
+      statusbar_log::AddStatusbarProgress(this->statusbar_handle_, 2, 10), -5);
+  EXPECT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 10.0),
+            -9)
+      << "Counted bars are not set by percentage";
+  EXPECT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 1, 10.0),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::StatusbarHandle stale = this->statusbar_handle_;
+  ASSERT_EQ(statusbar_log::DestroyStatusbarHandle(this->statusbar_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::AddStatusbarProgress(stale, 0, 1), -3);
+}
+
+TEST_F(StatusbarProgressTest, CreateRejectsMismatchedTotals) {
+  statusbar_log::StatusbarHandle handle{};
+  EXPECT_EQ(statusbar_log::CreateStatusbarHandle(handle,
+                                                 this->file_sink_handle_,
+                                                 {1}, {10}, {""}, {""},
+                                                 {100, 100}),
+            -3);
+  EXPECT_FALSE(handle.valid);
+}
+
+// ==================================================
+// Statusbar hierarchies
+// ==================================================
+
+class StatusbarHierarchyTest : public FileSinkTestBase {
+ protected:
+  statusbar_log::StatusbarHandle stages_{};
+
+  void SetUp() override {
+    FileSinkTestBase::SetUp();
+    this->CreateFileSink();
+    ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                  this->stages_, this->file_sink_handle_, {3, 2, 1},
+                  {10, 10, 10}, {"stage", "task_a", "task_b"}, {"", "", ""}),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+  void TearDown() override {
+    statusbar_log::SetStatusbarRenderRate(0);
+    statusbar_log::DestroyStatusbarHandle(this->stages_);
+    FileSinkTestBase::TearDown();
+  }
+
+  static std::string ReadContent(
+      const statusbar_log::sink::SinkHandle& sink_handle,
+      const std::string& path) {
+    statusbar_log::sink::FlushSinkHandle(sink_handle);
+    return statusbar_log::test::ReadFileContents(path);
+  }
+
+  /**
+   * \brief Percentage of the last drawn bar with the given prefix ("" if
+   * none). File sinks drop the lines below a bar when drawing it, so only
+   * the last bar drawn into a file is reliably found.
+   */
+  std::string LastPercent(const std::string& prefix) {
+    return LastPercent(prefix, this->file_sink_handle_, this->path_);
+  }
+  static std::string LastPercent(
+      const std::string& prefix,
+      const statusbar_log::sink::SinkHandle& sink_handle,
+      const std::string& path) {
+    const std::string content = ReadContent(sink_handle, path);
+    const std::size_t bar = content.rfind(prefix + "[");
+    if (bar == std::string::npos) return "";
+    const std::size_t end = content.find(']', bar);
+    return content.substr(end + 2, 6);
+  }
+};
+
+TEST_F(StatusbarHierarchyTest, ParentShowsWeightedMeanOfChildren) {
+  ASSERT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 1, this->stages_,
+                                              0, 3.0),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 2, this->stages_,
+                                              0, 1.0),
+            statusbar_log::kStatusbarLogSuccess);
+
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->stages_, 1, 100.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->LastPercent("stage"), " 75.00")
+      << "The parent is redrawn with the child";
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->stages_, 2, 20.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->LastPercent("stage"), " 80.00");
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->stages_, 1, 40.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->LastPercent("stage"), " 35.00");
+
+  EXPECT_EQ(statusbar_log::UpdateStatusbar(this->stages_, 0, 10.0), -10)
+      << "Parents are not updated directly";
+}
+
+TEST_F(StatusbarHierarchyTest, ChangesPropagateAcrossStatusbars) {
+  const std::string pipeline_path =
+      this->GetTestOutputFilename("_pipeline.txt");
+  std::filesystem::remove(pipeline_path);
+  statusbar_log::sink::SinkHandle pipeline_sink{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkFile(pipeline_sink, pipeline_path),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::StatusbarHandle pipeline{};
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(pipeline, pipeline_sink, {1},
+                                                 {10}, {"pipeline"}, {""}),
+            statusbar_log::kStatusbarLogSuccess);
+  // pipeline <- stage <- task_a, and a counted bar of a third statusbar.
+  statusbar_log::StatusbarHandle counted{};
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                counted, this->file_sink_handle_, {5}, {10}, {"counted"},
+                {""}, {200}),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 1, this->stages_,
+                                              0, 1.0),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(
+      statusbar_log::SetStatusbarParent(this->stages_, 0, pipeline, 0, 1.0),
+      statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::SetStatusbarParent(counted, 0, pipeline, 0, 1.0),
+            statusbar_log::kStatusbarLogSuccess);
+
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->stages_, 1, 60.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->LastPercent("stage"), " 60.00");
+  EXPECT_EQ(LastPercent("pipeline", pipeline_sink, pipeline_path), " 30.00");
+
+  ASSERT_EQ(statusbar_log::AddStatusbarProgress(counted, 0, 100),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::FlushStatusbarRedraws(),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(LastPercent("pipeline", pipeline_sink, pipeline_path), " 55.00");
+
+  // A destroyed child stays counted, a destroyed parent unlinks.
+  ASSERT_EQ(statusbar_log::DestroyStatusbarHandle(counted),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->stages_, 1, 80.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(LastPercent("pipeline", pipeline_sink, pipeline_path), " 65.00");
+  ASSERT_EQ(statusbar_log::DestroyStatusbarHandle(pipeline),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->stages_, 1, 90.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->LastPercent("stage"), " 90.00");
+
+  statusbar_log::sink::DestroySinkHandle(pipeline_sink);
+  std::filesystem::remove(pipeline_path);
+}
+
+TEST_F(StatusbarHierarchyTest, RenderThreadDrawsParentsInTheSameFrame) {
+  ASSERT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 2, this->stages_,
+                                              0, 1.0),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::SetStatusbarRenderRate(1),
+            statusbar_log::kStatusbarLogSuccess);
+
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->stages_, 2, 30.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::UpdateStatusbar(this->stages_, 0, 10.0), -10);
+  EXPECT_EQ(statusbar_log::FlushStatusbarRedraws(),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->LastPercent("task_b"), " 30.00");
+  EXPECT_EQ(this->LastPercent("stage"), " 30.00");
+}
+
+TEST_F(StatusbarHierarchyTest, RejectsInvalidLinks) {
+  statusbar_log::StatusbarHandle invalid{};
+  EXPECT_EQ(
+      statusbar_log::SetStatusbarParent(invalid, 0, this->stages_, 0, 1.0),
+      -1);
+  EXPECT_EQ(
+      statusbar_log::SetStatusbarParent(this->stages_, 0, invalid, 0, 1.0),
+      -2);
+  EXPECT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 3, this->stages_,
+                                              0, 1.0),
+            -3);
+  EXPECT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 1, this->stages_,
+                                              0, 0.0),
+            -4);
+  EXPECT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 0, this->stages_,
+                                              0, 1.0),
+            -5);
+  ASSERT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 1, this->stages_,
+                                              0, 1.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 0, this->stages_,
+                                              1, 1.0),
+            -5)
+      << "Cycle";
+  EXPECT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 1, this->stages_,
+                                              2, 1.0),
+            -6);
+
+  statusbar_log::StatusbarHandle counted{};
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                counted, this->file_sink_handle_, {4}, {10}, {"counted"},
+                {""}, {10}),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::SetStatusbarParent(this->stages_, 2, counted, 0,
+                                              1.0),
+            -7);
+  statusbar_log::DestroyStatusbarHandle(counted);
+}
+
+TEST_F(StatusbarHierarchyTest, BarsSurviveDestroyingEarlierStatusbars) {
+  const std::string tasks_path = this->GetTestOutputFilename("_tasks.txt");
+  std::filesystem::remove(tasks_path);
+  statusbar_log::sink::SinkHandle tasks_sink{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkFile(tasks_sink, tasks_path),
+            statusbar_log::kStatusbarLogSuccess);
+  // The bars of `filler` sit between those of stages_ and tasks.
+  statusbar_log::StatusbarHandle filler{};
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                filler, this->file_sink_handle_, {5, 4}, {10, 10},
+                {"filler_a", "filler_b"}, {"", ""}),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::StatusbarHandle tasks{};
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(tasks, tasks_sink, {2, 1},
+                                                 {10, 10}, {"copy", "verify"},
+                                                 {" files", " sums"}),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::SetStatusbarParent(tasks, 1, this->stages_, 0, 1.0),
+            statusbar_log::kStatusbarLogSuccess);
+
+  ASSERT_EQ(statusbar_log::DestroyStatusbarHandle(filler),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(tasks, 1, 40.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_NE(this->ReadContent(tasks_sink, tasks_path)
+                .find("verify[####/     ]  40.00 sums"),
+            std::string::npos);
+  EXPECT_EQ(this->LastPercent("stage"), " 40.00");
+
+  // A statusbar created after the gap closed gets bars of its own.
+  statusbar_log::StatusbarHandle late{};
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                late, this->file_sink_handle_, {6}, {10}, {"late"}, {""}),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(late, 0, 70.0),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::StatusbarProgress progress;
+  ASSERT_EQ(statusbar_log::GetStatusbarProgress(tasks, 1, progress),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(progress.percent, 40.0);
+  ASSERT_EQ(statusbar_log::GetStatusbarProgress(this->stages_, 0, progress),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(progress.percent, 40.0);
+  ASSERT_EQ(statusbar_log::GetStatusbarProgress(late, 0, progress),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(progress.percent, 70.0);
+
+  statusbar_log::DestroyStatusbarHandle(late);
+  statusbar_log::DestroyStatusbarHandle(tasks);
+  statusbar_log::sink::DestroySinkHandle(tasks_sink);
+  std::filesystem::remove(tasks_path);
+}
+
+// ==================================================
+// Statusbar throughput and ETA
+// ==================================================
+
+class StatusbarRateTest : public FileSinkTestBase {
+ protected:
+  statusbar_log::StatusbarHandle statusbar_handle_{};
+
+  void SetUp() override {
+    FileSinkTestBase::SetUp();
+    this->CreateFileSink();
+    ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                  this->statusbar_handle_, this->file_sink_handle_, {2, 1},
+                  {10, 10}, {"percent", "counted"},
+                  {" {rate} eta {eta}", " {rate}"}, {0, 1000}),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+  void TearDown() override {
+    statusbar_log::DestroyStatusbarHandle(this->statusbar_handle_);
+    FileSinkTestBase::TearDown();
+  }
+};
+
+TEST_F(StatusbarRateTest, UnknownBeforeProgress) {
+  statusbar_log::StatusbarProgress progress{};
+  ASSERT_EQ(statusbar_log::GetStatusbarProgress(this->statusbar_handle_, 0,
+                                                progress),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(progress.percent, 0.0);
+  EXPECT_EQ(progress.rate, 0.0);
+  EXPECT_LT(progress.eta_seconds, 0.0);
+  EXPECT_NE(this->ReadFile().find("?%/s eta --:--"), std::string::npos);
+
+  EXPECT_EQ(statusbar_log::GetStatusbarProgress(this->statusbar_handle_, 2,
+                                                progress),
+            -5);
+}
+
+TEST_F(StatusbarRateTest, EstimatesRateAndEtaFromUpdates) {
+  for (int step = 1; step <= 3; ++step) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0,
+                                             step * 10.0),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+
+  statusbar_log::StatusbarProgress progress{};
+  ASSERT_EQ(statusbar_log::GetStatusbarProgress(this->statusbar_handle_, 0,
+                                                progress),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(progress.percent, 30.0);
+  // 10% per 100ms, loosely: sleeps may take longer on a loaded machine.
+  EXPECT_GT(progress.rate, 20.0);
+  EXPECT_LT(progress.rate, 150.0);
+  EXPECT_GT(progress.eta_seconds, 70.0 / 150.0);
+  EXPECT_LT(progress.eta_seconds, 70.0 / 20.0);
+
+  const std::string content = this->ReadFile();
+  EXPECT_NE(content.find("%/s eta 00:0"), std::string::npos) << content;
+
+  ASSERT_EQ(
+      statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 100.0),
+      statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::GetStatusbarProgress(this->statusbar_handle_, 0,
+                                                progress),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(progress.eta_seconds, 0.0);
+}
+
+TEST_F(StatusbarRateTest, CountedBarsReportUnitsPerSecond) {
+  for (int step = 0; step < 3; ++step) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(
+        statusbar_log::AddStatusbarProgress(this->statusbar_handle_, 1, 50),
+        statusbar_log::kStatusbarLogSuccess);
+    // Each query applies the counters like a frame would.
+    statusbar_log::StatusbarProgress progress{};
+    ASSERT_EQ(statusbar_log::GetStatusbarProgress(this->statusbar_handle_, 1,
+                                                  progress),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+
+  statusbar_log::StatusbarProgress progress{};
+  ASSERT_EQ(statusbar_log::GetStatusbarProgress(this->statusbar_handle_, 1,
+                                                progress),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(progress.percent, 15.0);
+  // 50 units per 100ms.
+  EXPECT_GT(progress.rate, 100.0);
+  EXPECT_LT(progress.rate, 750.0);
+
+  EXPECT_EQ(statusbar_log::FlushStatusbarRedraws(),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_NE(this->ReadFile().find("/s"), std::string::npos);
+}
+
+// ==================================================
+// Terminal output
+// ==================================================
+
+/**
+ * \brief Runs the tests with stdout connected to a pseudo terminal, whose
+ * output is read back from the master side.
+ */
+class TerminalTest : public StatusbarTestBase {
+ protected:
+  int master_fd_ = -1;
+  int saved_stdout_fd_ = -1;
+  statusbar_log::sink::SinkHandle tty_sink_handle_{};
+  statusbar_log::StatusbarHandle statusbar_handle_{};
+
+  void SetUp() override {
+    this->master_fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    ASSERT_GE(this->master_fd_, 0);
+    ASSERT_EQ(grantpt(this->master_fd_), 0);
+    ASSERT_EQ(unlockpt(this->master_fd_), 0);
+    const int slave_fd = open(ptsname(this->master_fd_), O_RDWR | O_NOCTTY);
+    ASSERT_GE(slave_fd, 0);
+    fcntl(this->master_fd_, F_SETFL, O_NONBLOCK);
+
+    std::cout.flush();
+    std::fflush(stdout);
+    this->saved_stdout_fd_ = dup(STDOUT_FILENO);
+    dup2(slave_fd, STDOUT_FILENO);
+    close(slave_fd);
+    this->SetWidth(80);
+
+    ASSERT_EQ(statusbar_log::sink::CreateSinkStdout(this->tty_sink_handle_),
+              statusbar_log::kStatusbarLogSuccess);
+    ASSERT_TRUE(statusbar_log::sink::SinkIsTty(this->tty_sink_handle_));
+    ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                  this->statusbar_handle_, this->tty_sink_handle_, {1}, {10},
+                  {"tty_bar "}, {""}),
+              statusbar_log::kStatusbarLogSuccess);
+    this->ReadTerminal();
+  }
+  void TearDown() override {
+    statusbar_log::DestroyStatusbarHandle(this->statusbar_handle_);
+    statusbar_log::sink::DestroySinkHandle(this->tty_sink_handle_);
+    std::cout.flush();
+    std::fflush(stdout);
+    if (this->saved_stdout_fd_ >= 0) {
+      dup2(this->saved_stdout_fd_, STDOUT_FILENO);
+      close(this->saved_stdout_fd_);
+    }
+    if (this->master_fd_ >= 0) close(this->master_fd_);
+  }
+
+  void SetWidth(const unsigned short columns) {
+    winsize size{};
+    size.ws_row = 24;
+    size.ws_col = columns;
+    ioctl(STDOUT_FILENO, TIOCSWINSZ, &size);
+  }
+
+  std::string ReadTerminal() {
+    std::cout.flush();
+    std::fflush(stdout);
+    std::string output;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(this->master_fd_, buf, sizeof(buf))) > 0) {
+      output.append(buf, static_cast<std::size_t>(n));
+    }
+    return output;
+  }
+};
+
+TEST_F(TerminalTest, UpdatesOnlyWriteChangedCharacters) {
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 50.0),
+            statusbar_log::kStatusbarLogSuccess);
+  const std::string output = this->ReadTerminal();
+  EXPECT_EQ(output.find("tty_bar"), std::string::npos)
+      << "The unchanged prefix is not written again";
+  // "[|         ]   0.00" -> "[#####/    ]  50.00"
+  EXPECT_NE(output.find("\033[10G#####/\033[23G5"), std::string::npos);
+}
+
+TEST_F(TerminalTest, LogLineAndBarsAreComposedIntoOneFrame) {
+  statusbar_log::StatusbarHandle stacked{};
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(
+                stacked, this->tty_sink_handle_, {3, 2}, {10, 10},
+                {"upper ", "lower "}, {"", ""}),
+            statusbar_log::kStatusbarLogSuccess);
+  this->ReadTerminal();
+
+  ASSERT_EQ(statusbar_log::LogErr(kFilename, this->tty_sink_handle_, "framed"),
+            statusbar_log::kStatusbarLogSuccess);
+  const std::string output = this->ReadTerminal();
+  const std::size_t line = output.find("framed");
+  const std::size_t tty_bar = output.find("tty_bar [", line);
+  const std::size_t upper = output.find("upper [", line);
+  const std::size_t lower = output.find("lower [", line);
+  ASSERT_NE(line, std::string::npos) << output;
+  ASSERT_NE(tty_bar, std::string::npos) << output;
+  ASSERT_NE(upper, std::string::npos) << output;
+  ASSERT_NE(lower, std::string::npos) << output;
+  // The cursor goes from bar to bar (1 -> 3 -> 2) instead of returning below
+  // the statusbars after each (the terminal turns "\n" into "\r\n").
+  EXPECT_EQ(output.substr(upper - 9, 9), "\033[2A\r\033[2K") << output;
+  EXPECT_EQ(output.substr(lower - 7, 7), "\r\n\r\033[2K") << output;
+  EXPECT_EQ(output.find("\033[1A", line), std::string::npos) << output;
+
+  statusbar_log::DestroyStatusbarHandle(stacked);
+}
+
+TEST_F(TerminalTest, ResizeRedrawsWithNewWidth) {
+  // The cached width is used until the resize is signalled.
+  this->SetWidth(20);
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 10.0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadTerminal().find("tty_bar"), std::string::npos);
+
+  std::raise(SIGWINCH);
+  ASSERT_EQ(statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 20.0),
+            statusbar_log::kStatusbarLogSuccess);
+  const std::string output = this->ReadTerminal();
+  EXPECT_NE(output.find("tty_bar [##-       "), std::string::npos)
+      << "The bar is redrawn completely and cut to the new width: " << output;
+  EXPECT_EQ(output.find("20.00"), std::string::npos) << output;
+}
+
+TEST_F(TerminalTest, ZeroWidthTerminalDrawsUncutBar) {
+  this->SetWidth(0);
+  statusbar_log::NotifyTerminalResized();
+  EXPECT_NO_THROW(
+      statusbar_log::UpdateStatusbar(this->statusbar_handle_, 0, 30.0));
+  const std::string output = this->ReadTerminal();
+  EXPECT_NE(output.find("tty_bar [###"), std::string::npos) << output;
+  EXPECT_NE(output.find("]  30.00"), std::string::npos)
+      << "A width of 0 does not cut the bar: " << output;
+}
+
+/// si_signo seen by the SA_SIGINFO handler of ChainsPreviousSiginfoHandler.
+volatile std::sig_atomic_t chained_siginfo_signo = 0;
+
+TEST(ResizeSignalTest, ChainsPreviousSiginfoHandler) {
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  // The child installs its handler before the library installs its own.
+  EXPECT_EXIT(
+      {
+        struct sigaction previous {};
+        previous.sa_sigaction = [](int, siginfo_t* info, void*) {
+          chained_siginfo_signo = info->si_signo;
+        };
+        sigemptyset(&previous.sa_mask);
+        previous.sa_flags = SA_SIGINFO;
+        sigaction(SIGWINCH, &previous, nullptr);
+
+        const int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+        grantpt(master_fd);
+        unlockpt(master_fd);
+        dup2(open(ptsname(master_fd), O_RDWR | O_NOCTTY), STDOUT_FILENO);
+        winsize size{};
+        size.ws_row = 24;
+        size.ws_col = 80;
+        ioctl(STDOUT_FILENO, TIOCSWINSZ, &size);
+        statusbar_log::sink::SinkHandle sink_handle;
+        statusbar_log::sink::CreateSinkStdout(sink_handle);
+        statusbar_log::StatusbarHandle handle;
+        statusbar_log::CreateStatusbarHandle(handle, sink_handle, {1}, {10},
+                                             {"tty_bar "}, {""});
+
+        struct sigaction current {};
+        sigaction(SIGWINCH, nullptr, &current);
+        if (current.sa_sigaction == previous.sa_sigaction) std::_Exit(2);
+        std::raise(SIGWINCH);
+        std::_Exit(chained_siginfo_signo == SIGWINCH ? 0 : 1);
+      },
+      ::testing::ExitedWithCode(0), "");
+}
+
+TEST_F(TerminalTest, WritesAreBufferedUntilFlush) {
+  const std::string text = "buffered output";
+  ASSERT_EQ(statusbar_log::sink::SinkWriteStr(this->tty_sink_handle_, text),
+            static_cast<ssize_t>(text.size()));
+  EXPECT_EQ(this->ReadTerminal(), "");
+  ASSERT_EQ(statusbar_log::sink::FlushSinkHandle(this->tty_sink_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadTerminal(), text);
+}
+
+TEST_F(TerminalTest, CapabilitiesDetectedAtCreation) {
+  statusbar_log::sink::SinkCapabilities capabilities{};
+  ASSERT_EQ(statusbar_log::sink::GetSinkCapabilities(this->tty_sink_handle_,
+                                                     capabilities),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(capabilities.type, statusbar_log::sink::kSinkStdout);
+  EXPECT_EQ(capabilities.fd, STDOUT_FILENO);
+  EXPECT_TRUE(capabilities.is_tty);
+  EXPECT_TRUE(capabilities.supports_escapes);
+  EXPECT_TRUE(capabilities.buffered);
+}
+
+class SinkCapabilitiesTest : public StatusbarTestBase {};
+
+TEST_F(SinkCapabilitiesTest, FileSinkIsBufferedAndNoTty) {
+  statusbar_log::sink::SinkHandle file_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkFile(file_sink_handle,
+                                                this->GetTestLogFilename()),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::sink::SinkCapabilities capabilities{};
+  ASSERT_EQ(
+      statusbar_log::sink::GetSinkCapabilities(file_sink_handle, capabilities),
+      statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(capabilities.type, statusbar_log::sink::kSinkFileOwned);
+  EXPECT_EQ(capabilities.fd, -1);
+  EXPECT_FALSE(capabilities.is_tty);
+  EXPECT_FALSE(capabilities.supports_escapes);
+  EXPECT_TRUE(capabilities.buffered);
+  EXPECT_FALSE(statusbar_log::sink::SinkIsTty(file_sink_handle));
+
+  // Copies of the handle become invalid once the sink is destroyed.
+  const statusbar_log::sink::SinkHandle stale_handle = file_sink_handle;
+  ASSERT_EQ(statusbar_log::sink::DestroySinkHandle(file_sink_handle),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(
+      statusbar_log::sink::GetSinkCapabilities(stale_handle, capabilities), -3);
+  EXPECT_EQ(
+      statusbar_log::sink::GetSinkCapabilities(file_sink_handle, capabilities),
+      -1);
+}
+
+TEST_F(SinkCapabilitiesTest, DestroyWaitsForWritesInFlight) {
+  const std::string path = this->GetTestOutputFilename(".txt");
+  std::filesystem::remove(path);
+  statusbar_log::sink::SinkHandle file_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkFile(file_sink_handle, path),
+            statusbar_log::kStatusbarLogSuccess);
+
+  const std::string line = "0123456789abcdef\n";
+  std::atomic<std::size_t> written_lines = 0;
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 4; ++t) {
+    writers.emplace_back([&, handle = file_sink_handle] {
+      while (true) {
+        const ssize_t rc = statusbar_log::sink::SinkWriteStr(handle, line);
+        if (rc < 0) {
+          EXPECT_EQ(rc, -2) << "Only fails once the sink is destroyed";
+          return;
+        }
+        EXPECT_EQ(rc, static_cast<ssize_t>(line.size()));
+        ++written_lines;
+      }
+    });
+  }
+  while (written_lines < 1000) std::this_thread::yield();
+  ASSERT_EQ(statusbar_log::sink::DestroySinkHandle(file_sink_handle),
+            statusbar_log::kStatusbarLogSuccess);
+  for (std::thread& writer : writers) writer.join();
+
+  // Every accepted write made it to the file, complete.
+  std::istringstream in(statusbar_log::test::ReadFileContents(path));
+  std::size_t lines = 0;
+  for (std::string read_line; std::getline(in, read_line); ++lines) {
+    ASSERT_EQ(read_line + "\n", line);
+  }
+  EXPECT_EQ(lines, written_lines.load());
+  std::filesystem::remove(path);
+}
+
+TEST(LineDiffTest, WritesOnlyChangedCharacters) {
+  std::string out;
+  EXPECT_TRUE(statusbar_log::detail::AppendLineDiff(out, "ab[##/   ]  40.00",
+                                                    "ab[##/   ]  40.00"));
+  EXPECT_EQ(out, "") << "Equal lines need no output";
+
+  out.clear();
+  EXPECT_TRUE(statusbar_log::detail::AppendLineDiff(out, "ab[##/   ]  40.00",
+                                                    "ab[###-  ]  50.00"));
+  EXPECT_EQ(out, "\033[6G#-\033[13G5");
+
+  out.clear();
+  EXPECT_TRUE(statusbar_log::detail::AppendLineDiff(out, "abcdef", "xbcyef"));
+  EXPECT_EQ(out, "\033[1Gxbcy") << "Close runs are merged";
+
+  out.clear();
+  EXPECT_TRUE(statusbar_log::detail::AppendLineDiff(out, "abcdef", "abc"));
+  EXPECT_EQ(out, "\033[4G\033[K") << "Shorter lines are cut";
+
+  out.clear();
+  EXPECT_TRUE(statusbar_log::detail::AppendLineDiff(out, "abc", "xbcdef"));
+  EXPECT_EQ(out, "\033[1Gx\033[4Gdef");
+
+  out.clear();
+  EXPECT_FALSE(statusbar_log::detail::AppendLineDiff(
+      out, "\xEF\xBF\xBD" "abc", "\xEF\xBF\xBD" "abd"))
+      << "Columns of non-ASCII lines are unknown";
+}
+
+// ==================================================
+// Moving up in file sinks
+// ==================================================
+
+class FileSinkCursorTest : public FileSinkTestBase {};
+
+TEST_F(FileSinkCursorTest, MoveUpRemovesLastLines) {
+  ASSERT_EQ(
+      statusbar_log::sink::CreateSinkFile(this->file_sink_handle_, path_),
+      statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "a\nb\nc\n");
+
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 1),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "a\nb\nc");
+
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "C\n");
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 2),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "a\nb");
+
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 5),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "");
+
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, -2),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "\n\n");
+}
+
+TEST_F(FileSinkCursorTest, MoveUpBeyondRememberedLinesScansFile) {
+  {
+    std::ofstream existing(this->path_, std::ios::binary);
+    existing << "l1\nl2\nl3\n";
+  }
+  ASSERT_EQ(
+      statusbar_log::sink::CreateSinkFile(this->file_sink_handle_, path_),
+      statusbar_log::kStatusbarLogSuccess);
+  for (int i = 0; i < 200; ++i) {
+    statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "x\n");
+  }
+
+  // More lines than the sink remembers, reaching into the existing content.
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 201),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "l1\nl2\nl3");
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 1),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "l1\nl2");
+
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "\nl3\nl4\n");
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 2),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "l1\nl2\nl3");
+}
+
+#ifndef _WIN32
+TEST_F(FileSinkCursorTest, TerminalSequencesAreNotWrittenToStdout) {
+  this->CreateFileSink();
+  // A statusbar that existed once must not make later lines clear stdout.
+  statusbar_log::sink::SinkHandle stdout_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkStdout(stdout_sink_handle),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::StatusbarHandle handle;
+  ASSERT_EQ(statusbar_log::CreateStatusbarHandle(handle, stdout_sink_handle,
+                                                 {1}, {10}, {"a"}, {"b"}),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::DestroyStatusbarHandle(handle),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::DestroySinkHandle(stdout_sink_handle);
+  std::cout.flush();
+
+  const std::string stdout_path = this->GetTestOutputFilename("_stdout.txt");
+  const int saved_stdout = ::dup(STDOUT_FILENO);
+  const int captured =
+      ::open(stdout_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  ASSERT_GE(captured, 0);
+  ::dup2(captured, STDOUT_FILENO);
+  for (int i = 0; i < 3; ++i) {
+    statusbar_log::LogErr(kFilename, this->file_sink_handle_, "line %d", i);
+  }
+  statusbar_log::ClearCurrentLine(this->file_sink_handle_);
+  statusbar_log::SaveCursorPosition(this->file_sink_handle_);
+  std::cout.flush();
+  ::dup2(saved_stdout, STDOUT_FILENO);
+  ::close(saved_stdout);
+  ::close(captured);
+
+  EXPECT_EQ(statusbar_log::test::ReadFileContents(stdout_path), "");
+  std::filesystem::remove(stdout_path);
+  EXPECT_EQ(this->ReadLines().size(), 3u);
+  EXPECT_EQ(this->ReadFile().find('\033'), std::string::npos);
+}
+#endif
+
+// ==================================================
+// Memory mapped file sinks
+// ==================================================
+
+class MappedFileSinkTest : public FileSinkTestBase {};
+
+#ifndef _WIN32
+TEST_F(MappedFileSinkTest, AppendsAndTrimsOnDestroy) {
+  {
+    std::ofstream existing(this->path_, std::ios::binary);
+    existing << "old\n";
+  }
+  ASSERT_EQ(statusbar_log::sink::CreateSinkMappedFile(this->file_sink_handle_,
+                                                      this->path_),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::SinkCapabilities capabilities{};
+  ASSERT_EQ(statusbar_log::sink::GetSinkCapabilities(this->file_sink_handle_,
+                                                     capabilities),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(capabilities.type, statusbar_log::sink::kSinkMappedFile);
+  EXPECT_FALSE(capabilities.buffered);
+  EXPECT_EQ(statusbar_log::sink::SinkWriteStr(this->file_sink_handle_,
+                                              "a\nb\n"),
+            4);
+
+  // Readers see the output right away, followed by the preallocated rest.
+  const std::string content = this->ReadFile();
+  ASSERT_EQ(content.size(), statusbar_log::sink::kSinkMappedFileChunkSize);
+  EXPECT_EQ(content.substr(0, 8), "old\na\nb\n");
+  EXPECT_EQ(content.find_first_not_of('\0', 8), std::string::npos);
+
+  ASSERT_EQ(statusbar_log::sink::DestroySinkHandle(this->file_sink_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "old\na\nb\n");
+}
+
+TEST_F(MappedFileSinkTest, GrowsBeyondOneChunk) {
+  ASSERT_EQ(statusbar_log::sink::CreateSinkMappedFile(this->file_sink_handle_,
+                                                      this->path_),
+            statusbar_log::kStatusbarLogSuccess);
+  const std::string block(1 << 16, 'x');
+  const std::size_t blocks =
+      statusbar_log::sink::kSinkMappedFileChunkSize / block.size() + 2;
+  for (std::size_t i = 0; i < blocks; ++i) {
+    ASSERT_EQ(statusbar_log::sink::SinkWriteStr(this->file_sink_handle_,
+                                                block),
+              static_cast<ssize_t>(block.size()));
+  }
+  ASSERT_EQ(statusbar_log::sink::DestroySinkHandle(this->file_sink_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+
+  const std::string content = this->ReadFile();
+  EXPECT_EQ(content.size(), blocks * block.size());
+  EXPECT_EQ(content.find_first_not_of('x'), std::string::npos);
+}
+
+TEST_F(MappedFileSinkTest, MoveUpRemovesLastLines) {
+  {
+    std::ofstream existing(this->path_, std::ios::binary);
+    existing << "l1\nl2\n";
+  }
+  ASSERT_EQ(statusbar_log::sink::CreateSinkMappedFile(this->file_sink_handle_,
+                                                      this->path_),
+            statusbar_log::kStatusbarLogSuccess);
+  // Reaches into the existing content, which the sink has to scan.
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 1),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "\na\nb\nc\n");
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 1),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "C\n");
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 2),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, -1),
+            statusbar_log::kStatusbarLogSuccess);
+
+  ASSERT_EQ(statusbar_log::sink::DestroySinkHandle(this->file_sink_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "l1\nl2\na\nb\n");
+}
+#endif  // !_WIN32
+
+// ==================================================
+// io_uring file sinks
+// ==================================================
+
+class UringFileSinkTest : public FileSinkTestBase {
+ protected:
+  void SetUp() override {
+    FileSinkTestBase::SetUp();
+    ASSERT_EQ(statusbar_log::sink::CreateSinkUringFile(this->file_sink_handle_,
+                                                       this->path_),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+};
+
+TEST_F(UringFileSinkTest, FlushWaitsForAllWrites) {
+  statusbar_log::sink::SinkCapabilities capabilities{};
+  ASSERT_EQ(statusbar_log::sink::GetSinkCapabilities(this->file_sink_handle_,
+                                                     capabilities),
+            statusbar_log::kStatusbarLogSuccess);
+  // Without io_uring the sink falls back to a plain file sink.
+  EXPECT_TRUE(capabilities.type == statusbar_log::sink::kSinkUringFile ||
+              capabilities.type == statusbar_log::sink::kSinkFileOwned);
+  EXPECT_TRUE(capabilities.buffered);
+
+  // Enough output to have several writes in flight at once.
+  std::string expected;
+  for (int i = 0; i < 20000; ++i) {
+    const std::string line = "line " + std::to_string(i) + "\n";
+    ASSERT_EQ(statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, line),
+              static_cast<ssize_t>(line.size()));
+    expected += line;
+  }
+  ASSERT_EQ(statusbar_log::sink::FlushSinkHandle(this->file_sink_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), expected);
+}
+
+TEST_F(UringFileSinkTest, MoveUpRemovesLastLines) {
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "a\nb\nc\n");
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 1),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "C\n");
+  EXPECT_EQ(statusbar_log::sink::MoveCursorUp(this->file_sink_handle_, 2),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "\nd\n");
+  ASSERT_EQ(statusbar_log::sink::FlushSinkHandle(this->file_sink_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), "a\nb\nd\n");
+}
+
+#ifdef __linux__
+TEST_F(UringFileSinkTest, LoggedLinesDoNotWaitForCompletion) {
+  // A pipe that is full until read from keeps submitted writes in flight.
+  const std::string fifo_path = this->GetTestOutputFilename(".fifo");
+  std::filesystem::remove(fifo_path);
+  ASSERT_EQ(::mkfifo(fifo_path.c_str(), 0600), 0);
+  const int reader = ::open(fifo_path.c_str(), O_RDONLY | O_NONBLOCK);
+  ASSERT_GE(reader, 0);
+
+  statusbar_log::sink::SinkHandle fifo_sink_handle{};
+  ASSERT_EQ(
+      statusbar_log::sink::CreateSinkUringFile(fifo_sink_handle, fifo_path),
+      statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::SinkCapabilities capabilities{};
+  statusbar_log::sink::GetSinkCapabilities(fifo_sink_handle, capabilities);
+  if (capabilities.type != statusbar_log::sink::kSinkUringFile) {
+    statusbar_log::sink::DestroySinkHandle(fifo_sink_handle);
+    ::close(reader);
+    std::filesystem::remove(fifo_path);
+    GTEST_SKIP() << "io_uring not available";
+  }
+
+  // The pipe is full, so the write submitted by the line's flush (policy
+  // every_write) stays in flight until the pipe is read from.
+  const int writer = ::open(fifo_path.c_str(), O_WRONLY | O_NONBLOCK);
+  ASSERT_GE(writer, 0);
+  const std::string fill(4096, 'x');
+  std::size_t filled = 0;
+  for (ssize_t n; (n = ::write(writer, fill.data(), fill.size())) > 0;) {
+    filled += static_cast<std::size_t>(n);
+  }
+  ::close(writer);
+  std::atomic<bool> logged{false};
+  std::atomic<bool> destroyed{false};
+  std::thread logger([&] {
+    statusbar_log::LogErr(kFilename, fifo_sink_handle, "line");
+    logged.store(true);
+    // The kernel cancels waiting writes of threads that exit.
+    while (!destroyed.load()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!logged.load() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(logged.load()) << "Logging waited for the pipe to be read";
+
+  // Draining the pipe lets the write complete, which the fence of
+  // DestroySinkHandle waits for.
+  std::thread destroyer([&] {
+    statusbar_log::sink::DestroySinkHandle(fifo_sink_handle);
+    destroyed.store(true);
+  });
+  std::string received;
+  char buf[4096];
+  for (bool done = false; !done;) {
+    // Whatever is left after the destroy returned is in the pipe by then.
+    done = logged.load() && destroyed.load();
+    for (ssize_t n; (n = ::read(reader, buf, sizeof(buf))) > 0;) {
+      received.append(buf, static_cast<std::size_t>(n));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  logger.join();
+  destroyer.join();
+  ::close(reader);
+  std::filesystem::remove(fifo_path);
+  EXPECT_EQ(received.find_first_not_of('x'), filled);
+  EXPECT_NE(received.find("line"), std::string::npos);
+}
+#endif  // __linux__
+
+// ==================================================
+// Tee sink
+// ==================================================
+
+class TeeSinkTest : public StatusbarTestBase {
+ protected:
+  statusbar_log::sink::SinkHandle error_sink_handle_{};
+  statusbar_log::sink::SinkHandle info_sink_handle_{};
+  statusbar_log::sink::SinkHandle tee_sink_handle_{};
+  std::string error_path_;
+  std::string info_path_;
+
+  void SetUp() override {
+    this->error_path_ = this->GetTestOutputFilename("_err.txt");
+    this->info_path_ = this->GetTestOutputFilename("_inf.txt");
+    std::filesystem::remove(this->error_path_);
+    std::filesystem::remove(this->info_path_);
+    ASSERT_EQ(statusbar_log::sink::CreateSinkFile(this->error_sink_handle_,
+                                                  this->error_path_),
+              statusbar_log::kStatusbarLogSuccess);
+    ASSERT_EQ(statusbar_log::sink::CreateSinkFile(this->info_sink_handle_,
+                                                  this->info_path_),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+  void TearDown() override {
+    statusbar_log::sink::DestroySinkHandle(this->tee_sink_handle_);
+    statusbar_log::sink::DestroySinkHandle(this->error_sink_handle_);
+    statusbar_log::sink::DestroySinkHandle(this->info_sink_handle_);
+    std::filesystem::remove(this->error_path_);
+    std::filesystem::remove(this->info_path_);
+  }
+
+  std::string ReadFile(const statusbar_log::sink::SinkHandle& sink_handle,
+                       const std::string& path) {
+    statusbar_log::sink::FlushSinkHandle(sink_handle);
+    return statusbar_log::test::ReadFileContents(path);
+  }
+};
+
+TEST_F(TeeSinkTest, ChildrenFilterByLevel) {
+  ASSERT_EQ(statusbar_log::sink::CreateSinkTee(
+                this->tee_sink_handle_,
+                {{this->error_sink_handle_, statusbar_log::kLogLevelErr},
+                 {this->info_sink_handle_, statusbar_log::kLogLevelInf}}),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::sink::SinkCapabilities capabilities{};
+  ASSERT_EQ(statusbar_log::sink::GetSinkCapabilities(this->tee_sink_handle_,
+                                                     capabilities),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(capabilities.type, statusbar_log::sink::kSinkTee);
+  EXPECT_FALSE(capabilities.supports_escapes);
+  EXPECT_TRUE(capabilities.buffered);
+
+  statusbar_log::LogErr(kFilename, this->tee_sink_handle_, "error %d", 1);
+  statusbar_log::LogWrn(kFilename, this->tee_sink_handle_, "warning %d", 2);
+  statusbar_log::LogInf(kFilename, this->tee_sink_handle_, "info %d", 3);
+
+  const std::string errors =
+      this->ReadFile(this->error_sink_handle_, this->error_path_);
+  const std::string infos =
+      this->ReadFile(this->info_sink_handle_, this->info_path_);
+  EXPECT_NE(errors.find("error 1"), std::string::npos);
+  EXPECT_EQ(errors.find("warning 2"), std::string::npos);
+  EXPECT_EQ(errors.find("info 3"), std::string::npos);
+  EXPECT_NE(infos.find("error 1"), std::string::npos);
+  EXPECT_NE(infos.find("warning 2"), std::string::npos);
+  EXPECT_NE(infos.find("info 3"), std::string::npos);
+  // File children get plain lines, no statusbar escape sequences.
+  EXPECT_EQ(infos.find('\x1b'), std::string::npos);
+}
+
+TEST_F(TeeSinkTest, DestroyedChildrenAreSkipped) {
+  ASSERT_EQ(statusbar_log::sink::CreateSinkTee(
+                this->tee_sink_handle_,
+                {{this->error_sink_handle_, statusbar_log::kLogLevelInf},
+                 {this->info_sink_handle_, statusbar_log::kLogLevelInf}}),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::sink::DestroySinkHandle(this->error_sink_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+
+  EXPECT_EQ(
+      statusbar_log::LogErr(kFilename, this->tee_sink_handle_, "still here"),
+      statusbar_log::kStatusbarLogSuccess);
+  EXPECT_NE(this->ReadFile(this->info_sink_handle_, this->info_path_)
+                .find("still here"),
+            std::string::npos);
+
+  statusbar_log::sink::SinkTeeChildren children;
+  std::size_t count = 0;
+  ASSERT_EQ(statusbar_log::sink::GetSinkTeeChildren(this->tee_sink_handle_,
+                                                    children, count),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(count, 2u);
+  EXPECT_EQ(statusbar_log::sink::GetSinkTeeChildren(this->info_sink_handle_,
+                                                    children, count),
+            -5);
+}
+
+TEST_F(TeeSinkTest, CreateRejectsInvalidChildren) {
+  EXPECT_EQ(statusbar_log::sink::CreateSinkTee(this->tee_sink_handle_, {}), -3);
+  EXPECT_EQ(statusbar_log::sink::CreateSinkTee(
+                this->tee_sink_handle_,
+                {{statusbar_log::sink::SinkHandle{},
+                  statusbar_log::kLogLevelInf}}),
+            -4);
+
+  const std::string binary_path = this->GetTestOutputFilename(".sblog");
+  statusbar_log::sink::SinkHandle binary_sink_handle{};
+  ASSERT_EQ(
+      statusbar_log::sink::CreateSinkBinary(binary_sink_handle, binary_path),
+      statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::sink::CreateSinkTee(
+                this->tee_sink_handle_,
+                {{binary_sink_handle, statusbar_log::kLogLevelInf}}),
+            -5);
+  statusbar_log::sink::DestroySinkHandle(binary_sink_handle);
+  std::filesystem::remove(binary_path);
+}
+
+// ==================================================
+// Flight recorder sink
+// ==================================================
+
+class FlightRecorderSinkTest : public FileSinkTestBase {
+ protected:
+  void Create(const std::size_t size, const int dump_log_level) {
+    ASSERT_EQ(statusbar_log::sink::CreateSinkFlightRecorder(
+                  this->file_sink_handle_, this->path_, size, dump_log_level),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+};
+
+TEST_F(FlightRecorderSinkTest, DumpsOnlyOnRequest) {
+  this->Create(4096, statusbar_log::kLogLevelOff);
+  statusbar_log::sink::SinkCapabilities capabilities{};
+  ASSERT_EQ(statusbar_log::sink::GetSinkCapabilities(
+                this->file_sink_handle_, capabilities),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(capabilities.type, statusbar_log::sink::kSinkFlightRecorder);
+  EXPECT_FALSE(capabilities.buffered);
+
+  statusbar_log::LogErr(kFilename, this->file_sink_handle_, "first");
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "raw\n");
+  ASSERT_EQ(statusbar_log::sink::FlushSinkHandle(this->file_sink_handle_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_FALSE(std::filesystem::exists(this->path_));
+
+  ASSERT_EQ(
+      statusbar_log::sink::DumpSinkFlightRecorder(this->file_sink_handle_),
+      statusbar_log::kStatusbarLogSuccess);
+  const std::string first_dump = this->ReadFile();
+  EXPECT_NE(first_dump.find("first"), std::string::npos);
+  EXPECT_EQ(first_dump.substr(first_dump.size() - 4), "raw\n");
+
+  // Later dumps only append what was recorded since.
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "second\n");
+  ASSERT_EQ(
+      statusbar_log::sink::DumpSinkFlightRecorder(this->file_sink_handle_),
+      statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(
+      statusbar_log::sink::DumpSinkFlightRecorder(this->file_sink_handle_),
+      statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), first_dump + "second\n");
+}
+
+TEST_F(FlightRecorderSinkTest, ErrorLinesTriggerDump) {
+  this->Create(4096, statusbar_log::kLogLevelErr);
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "context");
+  statusbar_log::LogWrn(kFilename, this->file_sink_handle_, "warning");
+  EXPECT_FALSE(std::filesystem::exists(this->path_));
+
+  statusbar_log::LogErr(kFilename, this->file_sink_handle_, "failure");
+  const std::string dump = this->ReadFile();
+  const std::size_t context = dump.find("context");
+  const std::size_t failure = dump.find("failure");
+  ASSERT_NE(context, std::string::npos);
+  ASSERT_NE(failure, std::string::npos);
+  EXPECT_LT(context, dump.find("warning"));
+  EXPECT_LT(dump.find("warning"), failure);
+}
+
+TEST_F(FlightRecorderSinkTest, OverwrittenOutputStartsAtCompleteLine) {
+  this->Create(50, statusbar_log::kLogLevelOff);  // Rounded up to 64 bytes.
+  std::string expected;
+  for (int i = 10; i < 30; ++i) {
+    const std::string line = "line " + std::to_string(i) + "\n";
+    statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, line);
+    // 8 bytes per line: the last 64 bytes start in the middle of line 22.
+    if (i > 22) expected += line;
+  }
+  ASSERT_EQ(
+      statusbar_log::sink::DumpSinkFlightRecorder(this->file_sink_handle_),
+      statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadFile(), expected);
+}
+
+TEST_F(FlightRecorderSinkTest, ConcurrentWritersKeepLinesIntact) {
+  this->Create(1 << 20, statusbar_log::kLogLevelOff);
+  constexpr int kThreads = 4;
+  constexpr int kLinesPerThread = 2000;
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kThreads; ++t) {
+    writers.emplace_back([this, t] {
+      for (int i = 0; i < kLinesPerThread; ++i) {
+        const std::string line =
+            "thread " + std::to_string(t) + " line " + std::to_string(i) + "\n";
+        statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, line);
+      }
+    });
+  }
+  for (std::thread& writer : writers) writer.join();
+  ASSERT_EQ(
+      statusbar_log::sink::DumpSinkFlightRecorder(this->file_sink_handle_),
+      statusbar_log::kStatusbarLogSuccess);
+
+  std::istringstream dump(this->ReadFile());
+  std::vector<int> next(kThreads, 0);
+  std::string line;
+  int lines = 0;
+  while (std::getline(dump, line)) {
+    int t = -1;
+    int i = -1;
+    ASSERT_EQ(std::sscanf(line.c_str(), "thread %d line %d", &t, &i), 2)
+        << line;
+    ASSERT_TRUE(t >= 0 && t < kThreads) << line;
+    EXPECT_EQ(i, next[t]++) << "Lines of one thread stay in order";
+    ++lines;
+  }
+  EXPECT_EQ(lines, kThreads * kLinesPerThread);
+}
+
+TEST_F(FlightRecorderSinkTest, DumpsWhileWritersKeepLogging) {
+  this->Create(1 << 16, statusbar_log::kLogLevelOff);
+  constexpr int kThreads = 4;
+  constexpr int kDumps = 50;
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kThreads; ++t) {
+    writers.emplace_back([this, t, &stop] {
+      for (int i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+        const std::string line =
+            "thread " + std::to_string(t) + " line " + std::to_string(i) + "\n";
+        statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, line);
+      }
+    });
+  }
+  // Each dump returns while the writers carry on.
+  for (int d = 0; d < kDumps; ++d) {
+    EXPECT_EQ(statusbar_log::sink::DumpSinkFlightRecorder(
+                  this->file_sink_handle_),
+              statusbar_log::kStatusbarLogSuccess);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  stop.store(true, std::memory_order_relaxed);
+  for (std::thread& writer : writers) writer.join();
+
+  // Overwritten lines are skipped, the dumped ones are complete and in order.
+  std::istringstream dump(this->ReadFile());
+  std::vector<int> last(kThreads, -1);
+  std::string line;
+  int lines = 0;
+  while (std::getline(dump, line)) {
+    int t = -1;
+    int i = -1;
+    ASSERT_EQ(std::sscanf(line.c_str(), "thread %d line %d", &t, &i), 2)
+        << line;
+    ASSERT_TRUE(t >= 0 && t < kThreads) << line;
+    EXPECT_GT(i, last[t]) << line;
+    last[t] = i;
+    ++lines;
+  }
+  EXPECT_GT(lines, 0);
+}
+
+#ifndef _WIN32
+TEST_F(FlightRecorderSinkTest, FatalSignalDumps) {
+  this->Create(4096, statusbar_log::kLogLevelOff);
+  EXPECT_DEATH(
+      {
+        statusbar_log::sink::SinkWriteStr(this->file_sink_handle_,
+                                          "last words\n");
+        std::abort();
+      },
+      "");
+  EXPECT_EQ(this->ReadFile(), "last words\n");
+}
+
+/// Address the child of FaultReachesPreviousHandlerWithSiginfo writes to.
+void* volatile fault_address = reinterpret_cast<void*>(0x10);
+
+TEST_F(FlightRecorderSinkTest, FaultReachesPreviousHandlerWithSiginfo) {
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  // The child installs its handler before the first flight recorder does.
+  EXPECT_EXIT(
+      {
+        struct sigaction previous {};
+        previous.sa_sigaction = [](int, siginfo_t* info, void*) {
+          std::_Exit(info->si_code > 0 && info->si_addr == fault_address ? 3
+                                                                         : 4);
+        };
+        sigemptyset(&previous.sa_mask);
+        previous.sa_flags = SA_SIGINFO;
+        sigaction(SIGSEGV, &previous, nullptr);
+
+        statusbar_log::sink::CreateSinkFlightRecorder(
+            this->file_sink_handle_, this->path_, 4096,
+            statusbar_log::kLogLevelOff);
+        statusbar_log::sink::SinkWriteStr(this->file_sink_handle_,
+                                          "last words\n");
+        *static_cast<volatile int*>(fault_address) = 1;
+      },
+      ::testing::ExitedWithCode(3), "");
+  EXPECT_EQ(this->ReadFile(), "last words\n");
+}
+#endif  // !_WIN32
+
+// ==================================================
+// Flush policies
+// ==================================================
+
+class SinkFlushPolicyTest : public FileSinkTestBase {
+ protected:
+  void SetUp() override {
+    FileSinkTestBase::SetUp();
+    this->CreateFileSink();
+  }
+
+  /// Reads the file without flushing the sink.
+  std::string ReadUnflushed() {
+    return statusbar_log::test::ReadFileContents(this->path_);
+  }
+
+  void SetPolicy(const statusbar_log::sink::SinkFlushPolicy& policy) {
+    ASSERT_EQ(statusbar_log::sink::SetSinkFlushPolicy(this->file_sink_handle_,
+                                                      policy),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+};
+
+TEST_F(SinkFlushPolicyTest, DefaultFlushesEveryWrite) {
+  statusbar_log::sink::SinkFlushPolicy policy{};
+  ASSERT_EQ(statusbar_log::sink::GetSinkFlushPolicy(this->file_sink_handle_,
+                                                    policy),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_TRUE(policy.every_write);
+  EXPECT_EQ(policy.every_ms, 0u);
+
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "visible");
+  EXPECT_NE(this->ReadUnflushed().find("visible"), std::string::npos);
+}
+
+TEST_F(SinkFlushPolicyTest, EveryBytesGathersBlocks) {
+  this->SetPolicy({false, false, 256, 0, 0});
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "short");
+  EXPECT_EQ(this->ReadUnflushed(), "");
+
+  const std::string long_text(300, 'x');
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "%s",
+                        long_text.c_str());
+  const std::string content = this->ReadUnflushed();
+  EXPECT_NE(content.find("short"), std::string::npos);
+  EXPECT_NE(content.find(long_text), std::string::npos);
+}
+
+TEST_F(SinkFlushPolicyTest, OnNewlineWaitsForCompleteLines) {
+  this->SetPolicy({false, true, 0, 0, 0});
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, "partial");
+  ASSERT_EQ(statusbar_log::sink::FlushSinkHandleIfDue(this->file_sink_handle_,
+                                                      0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadUnflushed(), "");
+
+  statusbar_log::sink::SinkWriteStr(this->file_sink_handle_, " line\n");
+  ASSERT_EQ(statusbar_log::sink::FlushSinkHandleIfDue(this->file_sink_handle_,
+                                                      0),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(this->ReadUnflushed(), "partial line\n");
+}
+
+TEST_F(SinkFlushPolicyTest, MaxLogLevelFlushesErrors) {
+  this->SetPolicy({false, false, 0, 0, statusbar_log::kLogLevelErr});
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "context");
+  statusbar_log::LogWrn(kFilename, this->file_sink_handle_, "warning");
+  EXPECT_EQ(this->ReadUnflushed(), "");
+
+  statusbar_log::LogErr(kFilename, this->file_sink_handle_, "failure");
+  const std::string content = this->ReadUnflushed();
+  EXPECT_NE(content.find("context"), std::string::npos);
+  EXPECT_NE(content.find("failure"), std::string::npos);
+}
+
+TEST_F(SinkFlushPolicyTest, TimerFlushesPendingOutput) {
+  this->SetPolicy({false, false, 0, 10, 0});
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "eventually");
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (this->ReadUnflushed().find("eventually") == std::string::npos &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_NE(this->ReadUnflushed().find("eventually"), std::string::npos);
+
+  // Switching the timer off again keeps the output pending.
+  this->SetPolicy({false, false, 0, 0, 0});
+  statusbar_log::LogInf(kFilename, this->file_sink_handle_, "held back");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(this->ReadUnflushed().find("held back"), std::string::npos);
+}
+
+TEST_F(SinkFlushPolicyTest, TeeSinksUseTheirChildrensPolicies) {
+  this->SetPolicy({false, false, 0, 0, statusbar_log::kLogLevelErr});
+  statusbar_log::sink::SinkHandle tee_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkTee(
+                tee_sink_handle,
+                {{this->file_sink_handle_, statusbar_log::kLogLevelInf}}),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::sink::SetSinkFlushPolicy(
+                tee_sink_handle, {true, false, 0, 0, 0}),
+            -6);
+
+  statusbar_log::LogInf(kFilename, tee_sink_handle, "context");
+  EXPECT_EQ(this->ReadUnflushed(), "");
+  statusbar_log::LogErr(kFilename, tee_sink_handle, "failure");
+  EXPECT_NE(this->ReadUnflushed().find("context"), std::string::npos);
+  statusbar_log::sink::DestroySinkHandle(tee_sink_handle);
+}
+
+// ==================================================
+// Slot map
+// ==================================================
+
+TEST(SlotMapTest, ReusedSlotsInvalidateStaleHandles) {
+  statusbar_log::detail::SlotMap<int, 2> slots;
+  statusbar_log::StatusbarHandle first{};
+  statusbar_log::StatusbarHandle second{};
+  ASSERT_TRUE(slots.Claim(first.idx, first.id));
+  ASSERT_TRUE(slots.Claim(second.idx, second.id));
+  first.valid = second.valid = true;
+  EXPECT_EQ(slots.Validate(first), -3) << "Claimed slots are not published yet";
+  slots.Publish(first.idx, first.id);
+  slots.Publish(second.idx, second.id);
+  EXPECT_EQ(slots.Validate(first), 0);
+  EXPECT_EQ(slots.Validate(second), 0);
+  EXPECT_NE(first.id, second.id);
+
+  std::size_t idx;
+  unsigned int id;
+  EXPECT_FALSE(slots.Claim(idx, id)) << "All slots are in use";
+
+  slots.Unpublish(first.idx);
+  EXPECT_TRUE(slots.Release(first.idx));
+  EXPECT_FALSE(slots.Release(first.idx)) << "The slot is already free";
+  EXPECT_EQ(slots.active(), 1u);
+  EXPECT_EQ(slots.Validate(first), -3);
+  ASSERT_TRUE(slots.Claim(idx, id));
+  slots.Publish(idx, id);
+  EXPECT_EQ(idx, first.idx) << "The freed slot is reused";
+  EXPECT_NE(id, first.id) << "with a new generation";
+  EXPECT_EQ(slots.Validate(first), -3);
+
+  statusbar_log::StatusbarHandle out_of_bounds = first;
+  out_of_bounds.idx = 2;
+  EXPECT_EQ(slots.Validate(out_of_bounds), -2);
+  EXPECT_EQ(slots.active(), 2u);
+}
+
+// ==================================================
+// Sanitizing
+// ==================================================
+
+/// Computed by a static initializer of this translation unit, which may run
+/// before the ones of the library.
+const std::size_t kStaticInitReplacedChar =
+    statusbar_log::detail::FindReplacedChar("0123456789abcdef\x01", 17, false);
+
+TEST(SanitizeTest, FindReplacedCharWorksDuringStaticInitialization) {
+  EXPECT_EQ(kStaticInitReplacedChar, 16u);
+}
+
+TEST(SanitizeTest, FindReplacedCharMatchesScalar) {
+  // Offsets and lengths around the 16 and 32 byte blocks, with every special
+  // byte at every position.
+  const char special[] = {'\0', '\t', '\n', '\r', '\x1b', '\x1f',
+                          ' ',   '~',   '\x7f', '\x80', '\xef', '\xff'};
+  std::vector<char> buffer(128, 'a');
+  for (std::size_t offset = 0; offset < 4; ++offset) {
+    for (std::size_t len = 0; len <= 100; len += 3) {
+      for (std::size_t pos = 0; pos < len; ++pos) {
+        for (const char c : special) {
+          const char* data = buffer.data() + offset;
+          buffer[offset + pos] = c;
+          for (const bool allow_newline : {false, true}) {
+            ASSERT_EQ(
+                statusbar_log::detail::FindReplacedChar(data, len,
+                                                        allow_newline),
+                statusbar_log::detail::FindReplacedCharScalar(data, len,
+                                                              allow_newline))
+                << "offset " << offset << ", len " << len << ", pos " << pos
+                << ", byte " << static_cast<int>(c) << " ("
+                << statusbar_log::detail::FindReplacedCharImplementation()
+                << ")";
+          }
+          buffer[offset + pos] = 'a';
+        }
+      }
+    }
+  }
+}
+
+TEST(SanitizeTest, SanitizeStringReplacesControlCharacters) {
+  EXPECT_EQ(statusbar_log::detail::SanitizeString("clean\ttext"),
+            "clean\ttext");
+  EXPECT_EQ(statusbar_log::detail::SanitizeString("a\nb\x1b[2Jc\x7f"),
+            "a\xEF\xBF\xBD" "b\xEF\xBF\xBD[2Jc\xEF\xBF\xBD");
+
+  const std::string long_input = std::string(40, 'x') + '\r' +
+                                 std::string(40, 'y') + "\x01\x02";
+  EXPECT_EQ(statusbar_log::detail::SanitizeString(long_input),
+            std::string(40, 'x') + "\xEF\xBF\xBD" + std::string(40, 'y') +
+                "\xEF\xBF\xBD\xEF\xBF\xBD");
+}
+
+TEST(SanitizeTest, SanitizeInPlaceCutsAtCapacity) {
+  char buffer[64] = {};
+  const std::string input = "ab\x01" "cd\x02" "ef";
+
+  input.copy(buffer, input.size());
+  std::size_t len = statusbar_log::detail::SanitizeInPlace(
+      buffer, input.size(), sizeof(buffer), true);
+  EXPECT_EQ(std::string(buffer, len),
+            "ab\xEF\xBF\xBD" "cd\xEF\xBF\xBD" "ef");
+
+  // Room for the first replacement and one more byte only.
+  input.copy(buffer, input.size());
+  len = statusbar_log::detail::SanitizeInPlace(buffer, input.size(), 6, true);
+  EXPECT_EQ(std::string(buffer, len), "ab\xEF\xBF\xBD" "c");
+
+  // A replacement that does not fit is dropped as a whole.
+  input.copy(buffer, input.size());
+  len = statusbar_log::detail::SanitizeInPlace(buffer, input.size(), 8, true);
+  EXPECT_EQ(std::string(buffer, len), "ab\xEF\xBF\xBD" "cd");
+
+  // Newlines are kept when allowed.
+  const std::string lines = "one\ntwo";
+  lines.copy(buffer, lines.size());
+  len = statusbar_log::detail::SanitizeInPlace(buffer, lines.size(),
+                                               sizeof(buffer), true);
+  EXPECT_EQ(std::string(buffer, len), lines);
+}
+
+// ==================================================
+// Binary logging
+// ==================================================
+
+class BinaryLogTest : public StatusbarTestBase {
+ protected:
+  std::string binary_path_;
+  std::string text_path_;
+  std::string decoded_path_;
+
+  void SetUp() override {
+    this->binary_path_ = this->GetTestOutputFilename(".bin");
+    this->text_path_ = this->GetTestOutputFilename("_text.txt");
+    this->decoded_path_ = this->GetTestOutputFilename("_decoded.txt");
+    this->RemoveFiles();
+  }
+  void TearDown() override { this->RemoveFiles(); }
+
+  void RemoveFiles() {
+    std::filesystem::remove(this->binary_path_);
+    std::filesystem::remove(this->text_path_);
+    std::filesystem::remove(this->decoded_path_);
+  }
+
+  static std::string ReadFile(const std::string& path) {
+    return statusbar_log::test::ReadFileContents(path);
+  }
+};
+
+TEST_F(BinaryLogTest, DecodedOutputMatchesTextOutput) {
+  statusbar_log::sink::SinkHandle binary_sink_handle{};
+  statusbar_log::sink::SinkHandle text_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkBinary(binary_sink_handle,
+                                                  this->binary_path_),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(
+      statusbar_log::sink::CreateSinkFile(text_sink_handle, this->text_path_),
+      statusbar_log::kStatusbarLogSuccess);
+
+  char reused_fmt[32];
+  const std::string long_string(statusbar_log::kMaxLogLength + 10, 'y');
+  for (const statusbar_log::sink::SinkHandle& sink_handle :
+       {binary_sink_handle, text_sink_handle}) {
+    statusbar_log::LogErr(kFilename, sink_handle,
+                          "int: %i, unsigned: %u, hex: %#x, short: %hd, "
+                          "char: %hhu, long long: %lld, size_t: %zu",
+                          -1, 2u, 255u, (short)3, 300u, 1234567890123LL,
+                          (size_t)42);
+    statusbar_log::LogWrn(kFilename, sink_handle,
+                          "f:%.2f e:%e g:%g [%*d] [%-*.*s] %c %% %s", 3.14159,
+                          1e-9, 2.5, 6, 42, 8, 3, "truncate", 'Z', nullptr);
+    statusbar_log::LogInf("other_file.cc", sink_handle,
+                          "control\x01" "chars\tand\nnewline %s",
+                          "a\x1b" "b");
+    statusbar_log::LogErr(kFilename, sink_handle, "%s", long_string.c_str());
+
+    // Same buffer, different format strings.
+    std::snprintf(reused_fmt, sizeof(reused_fmt), "first %%d");
+    statusbar_log::LogErr(kFilename, sink_handle, reused_fmt, 1);
+    std::snprintf(reused_fmt, sizeof(reused_fmt), "second %%d");
+    statusbar_log::LogErr(kFilename, sink_handle, reused_fmt, 2);
+
+    // Not representable, stored as formatted text.
+    statusbar_log::LogErr(kFilename, sink_handle, "wide %ls", L"text");
+  }
+  ASSERT_EQ(statusbar_log::sink::DestroySinkHandle(binary_sink_handle),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(statusbar_log::sink::DestroySinkHandle(text_sink_handle),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::sink::SinkHandle decoded_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkFile(decoded_sink_handle,
+                                                this->decoded_path_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::binary_log::DecodeBinaryLog(this->binary_path_,
+                                                       decoded_sink_handle),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::DestroySinkHandle(decoded_sink_handle);
+
+  EXPECT_EQ(ReadFile(this->decoded_path_), ReadFile(this->text_path_));
+}
+
+TEST_F(BinaryLogTest, DecodeTruncatesHugeStars) {
+  statusbar_log::sink::SinkHandle binary_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkBinary(binary_sink_handle,
+                                                  this->binary_path_),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::LogErr(kFilename, binary_sink_handle, "[%*d] [%.*f]",
+                        std::numeric_limits<int>::max(), 42,
+                        std::numeric_limits<int>::max(), 1.0);
+  ASSERT_EQ(statusbar_log::sink::DestroySinkHandle(binary_sink_handle),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::sink::SinkHandle decoded_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkFile(decoded_sink_handle,
+                                                this->decoded_path_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::binary_log::DecodeBinaryLog(this->binary_path_,
+                                                       decoded_sink_handle),
+            statusbar_log::kStatusbarLogSuccess);
+  statusbar_log::sink::DestroySinkHandle(decoded_sink_handle);
+
+  const std::string decoded = ReadFile(this->decoded_path_);
+  EXPECT_NE(decoded.find("[ "), std::string::npos);
+  EXPECT_LE(decoded.size(), statusbar_log::kMaxLogLength + 256);
+}
+
+TEST_F(BinaryLogTest, RepeatedCallsOnlyStoreArguments) {
+  statusbar_log::sink::SinkHandle binary_sink_handle{};
+  statusbar_log::sink::SinkHandle text_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkBinary(binary_sink_handle,
+                                                  this->binary_path_),
+            statusbar_log::kStatusbarLogSuccess);
+  ASSERT_EQ(
+      statusbar_log::sink::CreateSinkFile(text_sink_handle, this->text_path_),
+      statusbar_log::kStatusbarLogSuccess);
+
+  for (int i = 0; i < 100; ++i) {
+    for (const statusbar_log::sink::SinkHandle& sink_handle :
+         {binary_sink_handle, text_sink_handle}) {
+      statusbar_log::LogErr(kFilename, sink_handle,
+                            "Processed block %d of the input file (%.1f%%)",
+                            i, i * 1.0);
+    }
+  }
+  statusbar_log::sink::DestroySinkHandle(binary_sink_handle);
+  statusbar_log::sink::DestroySinkHandle(text_sink_handle);
+
+  EXPECT_LT(std::filesystem::file_size(this->binary_path_) * 2,
+            std::filesystem::file_size(this->text_path_));
+}
+
+TEST_F(BinaryLogTest, AlternatingFilenamesAreStoredOnce) {
+  statusbar_log::sink::SinkHandle binary_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkBinary(binary_sink_handle,
+                                                  this->binary_path_),
+            statusbar_log::kStatusbarLogSuccess);
+  // Each literal becomes a temporary std::string, usually in the same stack
+  // slot for both call sites.
+  for (int i = 0; i < 100; ++i) {
+    statusbar_log::LogErr("a.cc", binary_sink_handle, "step %d", i);
+    statusbar_log::LogErr("b.cc", binary_sink_handle, "step %d", i);
+  }
+  statusbar_log::sink::DestroySinkHandle(binary_sink_handle);
+
+  const std::string content = ReadFile(this->binary_path_);
+  std::size_t string_records = 0;
+  std::size_t log_records = 0;
+  std::size_t pos = statusbar_log::binary_log::kFileHeaderLength;
+  while (pos + statusbar_log::binary_log::kRecordHeaderLength <=
+         content.size()) {
+    std::uint32_t payload_length;
+    std::memcpy(&payload_length, content.data() + pos + 1,
+                sizeof(payload_length));
+    if (content[pos] == statusbar_log::binary_log::kRecordString) {
+      ++string_records;
+    } else if (content[pos] == statusbar_log::binary_log::kRecordLog) {
+      ++log_records;
+    }
+    pos += statusbar_log::binary_log::kRecordHeaderLength + payload_length;
+  }
+  EXPECT_EQ(pos, content.size());
+  EXPECT_EQ(log_records, 200u);
+  EXPECT_EQ(string_records, 3u) << "The format string and both filenames";
+}
+
+TEST_F(BinaryLogTest, AlternatingFilenamesDoNotAllocate) {
+  statusbar_log::sink::SinkHandle binary_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkBinary(binary_sink_handle,
+                                                  this->binary_path_),
+            statusbar_log::kStatusbarLogSuccess);
+  // Longer than the small string buffer, alternating in one reused buffer.
+  const std::string names[] = {"alternating_source_a.cc",
+                               "alternating_source_b.cc"};
+  std::string filename;
+  filename.reserve(64);
+  for (const std::string& name : names) {
+    filename = name;
+    statusbar_log::LogErr(filename, binary_sink_handle, "step %d", -1);
+  }
+
+  statusbar_log::test::StartCountingAllocations();
+  for (int i = 0; i < 100; ++i) {
+    filename = names[i % 2];
+    statusbar_log::LogErr(filename, binary_sink_handle, "step %d", i);
+  }
+  const std::size_t allocations =
+      statusbar_log::test::StopCountingAllocations();
+  EXPECT_EQ(allocations, 0u) << "Known strings are looked up without copies";
+
+  statusbar_log::sink::DestroySinkHandle(binary_sink_handle);
+}
+
+TEST_F(BinaryLogTest, DecodeRejectsNonBinaryFiles) {
+  {
+    std::ofstream out(this->text_path_);
+    out << "INFO [file.cc]: not a binary log\n";
+  }
+  statusbar_log::sink::SinkHandle decoded_sink_handle{};
+  ASSERT_EQ(statusbar_log::sink::CreateSinkFile(decoded_sink_handle,
+                                                this->decoded_path_),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(statusbar_log::binary_log::DecodeBinaryLog(this->text_path_,
+                                                       decoded_sink_handle),
+            -2);
+  EXPECT_EQ(statusbar_log::binary_log::DecodeBinaryLog("does_not_exist.bin",
+                                                       decoded_sink_handle),
+            -1);
+  statusbar_log::sink::DestroySinkHandle(decoded_sink_handle);
+}
+
+// ==================================================
+// Asynchronous logging
+// ==================================================
+
+class AsyncLogTest : public FileSinkTestBase {
+ protected:
+  void SetUp() override {
+    FileSinkTestBase::SetUp();
+    this->CreateFileSink();
+  }
+  void TearDown() override {
+    if (statusbar_log::IsAsyncLoggingActive()) {
+      statusbar_log::StopAsyncLogging();
+    }
+    FileSinkTestBase::TearDown();
+  }
+};
+
+TEST_F(AsyncLogTest, LinesArriveInOrder) {
+  ASSERT_EQ(
+      statusbar_log::StartAsyncLogging(64, statusbar_log::kAsyncOverflowBlock),
+      statusbar_log::kStatusbarLogSuccess);
+  EXPECT_NE(statusbar_log::StartAsyncLogging(),
+            statusbar_log::kStatusbarLogSuccess)
+      << "Starting the backend twice should fail";
+
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_EQ(statusbar_log::LogErr(kFilename, this->file_sink_handle_,
+                                    "line %d", i),
+              statusbar_log::kStatusbarLogSuccess);
+  }
+  ASSERT_EQ(statusbar_log::FlushAsyncLogging(),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::AsyncLogStats stats;
+  ASSERT_EQ(statusbar_log::GetAsyncLogStats(stats),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(stats.enqueued, 200u);
+  EXPECT_EQ(stats.written, 200u);
+  EXPECT_EQ(stats.failed, 0u);
+
+  const std::vector<std::string> lines = ReadLines();
+  ASSERT_EQ(lines.size(), 200u);
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_EQ(lines[i],
+              "ERROR [statusbarlog_test.cc]: line " + std::to_string(i));
+  }
+  EXPECT_EQ(statusbar_log::StopAsyncLogging(),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_FALSE(statusbar_log::IsAsyncLoggingActive());
+}
+
+TEST_F(AsyncLogTest, MultipleProducersBlockingQueue) {
+  constexpr int kThreads = 4;
+  constexpr int kLinesPerThread = 250;
+  ASSERT_EQ(
+      statusbar_log::StartAsyncLogging(8, statusbar_log::kAsyncOverflowBlock),
+      statusbar_log::kStatusbarLogSuccess);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([this, t]() {
+      for (int i = 0; i < kLinesPerThread; ++i) {
+        statusbar_log::LogErr(kFilename, this->file_sink_handle_, "%d %d", t,
+                              i);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  ASSERT_EQ(statusbar_log::StopAsyncLogging(),
+            statusbar_log::kStatusbarLogSuccess);
+
+  const std::vector<std::string> lines = ReadLines();
+  ASSERT_EQ(lines.size(), static_cast<std::size_t>(kThreads * kLinesPerThread));
+  std::vector<int> next(kThreads, 0);
+  for (const std::string& line : lines) {
+    int t = -1;
+    int i = -1;
+    ASSERT_EQ(std::sscanf(line.c_str(), "ERROR [statusbarlog_test.cc]: %d %d",
+                          &t, &i),
+              2)
+        << line;
+    ASSERT_GE(t, 0);
+    ASSERT_LT(t, kThreads);
+    EXPECT_EQ(i, next[t]) << "Lines of one thread must stay in order";
+    next[t] = i + 1;
+  }
+}
+
+TEST_F(AsyncLogTest, DropNewestCountsDrops) {
+  ASSERT_EQ(statusbar_log::StartAsyncLogging(
+                4, statusbar_log::kAsyncOverflowDropNewest),
+            statusbar_log::kStatusbarLogSuccess);
+
+  // Holding the sink mutex stalls the writer thread so the queue fills up.
+  std::mutex* sink_mutex = nullptr;
+  ASSERT_EQ(statusbar_log::sink::get_mutex_ptr(this->file_sink_handle_,
+                                                sink_mutex),
+            statusbar_log::kStatusbarLogSuccess);
+  int rejected = 0;
+  {
+    std::lock_guard<std::mutex> stall(*sink_mutex);
+    for (int i = 0; i < 32; ++i) {
+      if (statusbar_log::LogErr(kFilename, this->file_sink_handle_, "msg %d",
+                                i) == -14) {
+        ++rejected;
+      }
+    }
+  }
+  ASSERT_EQ(statusbar_log::FlushAsyncLogging(),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::AsyncLogStats stats;
+  ASSERT_EQ(statusbar_log::GetAsyncLogStats(stats),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_GT(stats.dropped_newest, 0u);
+  EXPECT_EQ(stats.dropped_newest, static_cast<std::uint64_t>(rejected));
+  EXPECT_EQ(stats.enqueued + stats.dropped_newest, 32u);
+  EXPECT_EQ(stats.written, stats.enqueued);
+
+  const std::vector<std::string> lines = ReadLines();
+  ASSERT_EQ(lines.size(), stats.written);
+  EXPECT_EQ(lines.front(), "ERROR [statusbarlog_test.cc]: msg 0");
+}
+
+TEST_F(AsyncLogTest, DropOldestKeepsNewest) {
+  ASSERT_EQ(statusbar_log::StartAsyncLogging(
+                4, statusbar_log::kAsyncOverflowDropOldest),
+            statusbar_log::kStatusbarLogSuccess);
+
+  std::mutex* sink_mutex = nullptr;
+  ASSERT_EQ(statusbar_log::sink::get_mutex_ptr(this->file_sink_handle_,
+                                                sink_mutex),
+            statusbar_log::kStatusbarLogSuccess);
+  {
+    std::lock_guard<std::mutex> stall(*sink_mutex);
+    for (int i = 0; i < 32; ++i) {
+      EXPECT_EQ(statusbar_log::LogErr(kFilename, this->file_sink_handle_,
+                                      "msg %d", i),
+                statusbar_log::kStatusbarLogSuccess);
+    }
+  }
+  ASSERT_EQ(statusbar_log::FlushAsyncLogging(),
+            statusbar_log::kStatusbarLogSuccess);
+
+  statusbar_log::AsyncLogStats stats;
+  ASSERT_EQ(statusbar_log::GetAsyncLogStats(stats),
+            statusbar_log::kStatusbarLogSuccess);
+  EXPECT_EQ(stats.enqueued, 32u);
+  EXPECT_GT(stats.dropped_oldest, 0u);
+  EXPECT_EQ(stats.written + stats.dropped_oldest, 32u);
+
+  const std::vector<std::string> lines = ReadLines();
+  ASSERT_EQ(lines.size(), stats.written);
+  EXPECT_EQ(lines.back(), "ERROR [statusbarlog_test.cc]: msg 31");
+}
+
+TEST_F(AsyncLogTest, QueuedLinesAreWrittenAtExit) {
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  const std::string path = this->GetTestOutputFilename("_exit.txt");
+  std::filesystem::remove(path);
+
+  // The child exits without calling StopAsyncLogging.
+  EXPECT_EXIT(
+      {
+        statusbar_log::sink::SinkHandle handle;
+        statusbar_log::sink::CreateSinkFile(handle, path);
+        statusbar_log::StartAsyncLogging(1024,
+                                         statusbar_log::kAsyncOverflowBlock);
+        for (int i = 0; i < 500; ++i) {
+          statusbar_log::LogErr(kFilename, handle, "line %d", i);
+        }
+        std::exit(0);
+      },
+      ::testing::ExitedWithCode(0), "");
+
+  std::istringstream in(statusbar_log::test::ReadFileContents(path));
+  std::filesystem::remove(path);
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(in, line)) lines.push_back(line);
+  ASSERT_EQ(lines.size(), 500u) << "Queued lines were dropped at exit";
+  EXPECT_EQ(lines.back(), "ERROR [statusbarlog_test.cc]: line 499");
+}
+
 class ReadStatusbarUpdateTest : public StatusbarTestBase {
  protected:
   statusbar_log::sink::SinkHandle sink_handle_;
@@ -23,11 +23,16 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <new>
 #include <regex>
+#include <sstream>
 #include <string>
+#include <system_error>
 
 #include "statusbarlog/sink.h"
 #include "statusbarlog/statusbarlog.h"
@@ -35,9 +40,44 @@
 
 // clang-format on
 
+namespace {
+
+thread_local bool _count_allocations = false;
+thread_local std::size_t _allocation_count = 0;
+
+}  // namespace
+
+// Replaced global allocation functions so tests can assert that a code path
+// does not touch the heap. Counting is per thread and off by default.
+void* operator new(std::size_t size) {
+  if (_count_allocations) ++_allocation_count;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
 namespace statusbar_log {
 namespace test {
 
+void StartCountingAllocations() {
+  _allocation_count = 0;
+  _count_allocations = true;
+}
+
+std::size_t StopCountingAllocations() {
+  _count_allocations = false;
+  return _allocation_count;
+}
+
 void SetupTestOutputDirectory() {
   if (kSeparateLogFiles) {
     std::filesystem::remove_all(test_output_dir);
@@ -52,21 +92,35 @@ void SetupTestOutputDirectory() {
   }
 }
 
+std::string _SafeFileName(std::string file_name) {
+  std::replace(file_name.begin(), file_name.end(), '/', '_');
+  std::replace(file_name.begin(), file_name.end(), '\\', '_');
+  return file_name;
+}
+
 std::string GenerateTestLogFilename(const std::string& test_suite,
                                     const std::string& test_name) {
   if (kSeparateLogFiles) {
-    std::string safe_suite = test_suite;
-    std::string safe_name = test_name;
-    std::replace(safe_suite.begin(), safe_suite.end(), '/', '_');
-    std::replace(safe_name.begin(), safe_name.end(), '/', '_');
-    std::replace(safe_suite.begin(), safe_suite.end(), '\\', '_');
-    std::replace(safe_name.begin(), safe_name.end(), '\\', '_');
-    return test_output_dir + "/" + safe_suite + "_" + safe_name + ".log";
+    return test_output_dir + "/" + _SafeFileName(test_suite) + "_" +
+           _SafeFileName(test_name) + ".log";
   }
-  std::string safe_file_name = global_log_filename;
-  std::replace(safe_file_name.begin(), safe_file_name.end(), '/', '_');
-  std::replace(safe_file_name.begin(), safe_file_name.end(), '\\', '_');
-  return safe_file_name;
+  return _SafeFileName(global_log_filename);
+}
+
+std::string GenerateTestOutputFilename(const std::string& test_suite,
+                                       const std::string& test_name,
+                                       const std::string& suffix) {
+  std::error_code ec;
+  std::filesystem::create_directories(test_output_dir, ec);
+  return test_output_dir + "/" + _SafeFileName(test_suite) + "_" +
+         _SafeFileName(test_name) + suffix;
+}
+
+std::string ReadFileContents(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::ostringstream content;
+  content << in.rdbuf();
+  return content.str();
 }
 
 int _CaptureStdoutToFile(const std::string& filename) {
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Lukas Widmer
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// -- statusbarlog/tools/statusbarlog_decode.cc
+
+// Turns binary log files written by sink::kSinkBinary sinks back into text.
+//
+// Usage: statusbarlog_decode <binary log> [output file]
+//
+// Without an output file the decoded lines are written to stdout.
+
+// clang-format off
+
+#include <iostream>
+#include <string>
+
+#include "statusbarlog/binary_log.h"
+#include "statusbarlog/sink.h"
+#include "statusbarlog/statusbarlog.h"
+
+// clang-format on
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <binary log> [output file]\n";
+    return 2;
+  }
+
+  statusbar_log::sink::SinkHandle sink_handle{};
+  int err = (argc == 3)
+                ? statusbar_log::sink::CreateSinkFile(sink_handle, argv[2])
+                : statusbar_log::sink::CreateSinkStdout(sink_handle);
+  if (err != statusbar_log::kStatusbarLogSuccess) {
+    std::cerr << "ERROR: Failed to open the output (error " << err << ")\n";
+    return 1;
+  }
+
+  err = statusbar_log::binary_log::DecodeBinaryLog(argv[1], sink_handle);
+  statusbar_log::sink::DestroySinkHandle(sink_handle);
+  if (err != statusbar_log::kStatusbarLogSuccess) {
+    std::cerr << "ERROR: Failed to decode '" << argv[1] << "' (error " << err
+              << ")\n";
+    return 1;
+  }
+  return 0;
+}